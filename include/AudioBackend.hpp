@@ -0,0 +1,158 @@
+#pragma once
+
+#include "DeviceStats.hpp"
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstring>
+
+// ==================== AUDIO BACKEND ====================
+// Источник/приемник звука для AudioSystem. Раз в период backend вызывает
+// callback с входом (микрофон) и буфером выхода (динамики), как
+// дуплексный поток PortAudio.
+template <typename Sample>
+class AudioBackend {
+public:
+    // input == nullptr, если входа нет; output нужно заполнить целиком
+    using Callback = std::function<void(const Sample* input, Sample* output, unsigned long frames)>;
+
+    virtual ~AudioBackend() = default;
+
+    // low_latency: минимальная задержка устройства, если она есть
+    virtual bool open(int sample_rate, int frame_size, int channels,
+                      bool low_latency, Callback callback) = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual void close() = 0;
+
+    virtual bool is_open() const = 0;
+    virtual const char* name() const = 0;
+
+    // Источник исчерпан (конец WAV файла)
+    virtual bool finished() const { return false; }
+
+    // Xrun и тайминг callback, читать можно на ходу
+    const DeviceStats& stats() const { return device_stats; }
+
+protected:
+    DeviceStats device_stats;
+};
+
+// Backend без устройства: свой поток вызывает callback раз в период.
+// realtime — по монотонным часам, иначе так быстро, как получится.
+template <typename Sample>
+class ThreadedAudioBackend : public AudioBackend<Sample> {
+public:
+    using typename AudioBackend<Sample>::Callback;
+
+    explicit ThreadedAudioBackend(bool realtime) : realtime(realtime) {}
+    ~ThreadedAudioBackend() override { stop(); }
+
+    bool open(int sample_rate, int frame_size, int channels,
+              bool low_latency, Callback cb) override {
+        (void)low_latency;
+        close();
+
+        rate = sample_rate;
+        frames = frame_size;
+        this->channels = channels;
+        callback = std::move(cb);
+        input.assign(static_cast<size_t>(frames) * channels, Sample(0));
+        output.assign(static_cast<size_t>(frames) * channels, Sample(0));
+
+        opened = open_device();
+        return opened;
+    }
+
+    bool start() override {
+        if (!opened || running) return opened;
+
+        running = true;
+        thread = std::thread(&ThreadedAudioBackend::run, this);
+        return true;
+    }
+
+    void stop() override {
+        running = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void close() override {
+        stop();
+        if (opened) {
+            close_device();
+            opened = false;
+        }
+    }
+
+    bool is_open() const override { return opened; }
+    bool finished() const override { return done; }
+
+protected:
+    virtual bool open_device() { return true; }
+    virtual void close_device() {}
+    // Заполнить вход периода; false — источник исчерпан
+    virtual bool read_input(Sample* in, unsigned long count) {
+        memset(in, 0, count * channels * sizeof(Sample));
+        return true;
+    }
+    virtual void write_output(const Sample* out, unsigned long count) { (void)out; (void)count; }
+
+    int rate = 0;
+    int frames = 0;
+    int channels = 1;
+
+private:
+    void run() {
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(frames) / rate));
+        auto next = std::chrono::steady_clock::now();
+
+        const double period_seconds = static_cast<double>(frames) / rate;
+
+        while (running) {
+            if (!read_input(input.data(), frames)) {
+                done = true;
+                break;
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            if (callback) {
+                callback(input.data(), output.data(), frames);
+            }
+            write_output(output.data(), frames);
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            this->device_stats.record_callback(elapsed.count(), period_seconds);
+
+            if (realtime) {
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        }
+    }
+
+private:
+    bool realtime;
+    Callback callback;
+    std::vector<Sample> input;
+    std::vector<Sample> output;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> done{false};
+    bool opened = false;
+};
+
+// Нулевое устройство: тишина на входе, выход отбрасывается, темп — реальное время
+template <typename Sample>
+class NullAudioBackend : public ThreadedAudioBackend<Sample> {
+public:
+    NullAudioBackend() : ThreadedAudioBackend<Sample>(true) {}
+    ~NullAudioBackend() override { this->stop(); }
+    const char* name() const override { return "null"; }
+};
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <portaudio.h>
 #include <opus/opus.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -17,6 +16,24 @@
 #include <chrono>
 #include <string>
 #include <map>
+#include <random>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+#include "EchoCanceller.hpp"
+#include "Network.hpp"
+#include "Protocol.hpp"
+#include "Relay.hpp"
+#include "PacketCrypto.hpp"
+#include "PipelineLatency.hpp"
+#include "Trace.hpp"
+#include "Realtime.hpp"
+#include "OpusBundle.hpp"
+#include "PlaybackQueue.hpp"
+#include "PortAudioBackend.hpp"
+#include "OpusSample.hpp"
+#include "SampleFormat.hpp"
 
 // ==================== CONFIG ====================
 constexpr int SAMPLE_RATE = 48000;
@@ -24,150 +41,242 @@ constexpr int FRAME_SIZE = 480;      // 10ms
 constexpr int CHANNELS = 1;
 constexpr int OPUS_BITRATE = 32000;
 constexpr int NETWORK_PORT = 12345;
+constexpr int MAX_OPUS_FRAME_SIZE = SAMPLE_RATE * 120 / 1000;  // самый длинный пакет Opus
+
+// ==================== PROFILE ====================
+// Параметры тракта, выбираемые при запуске (по умолчанию — константы выше)
+struct AudioProfile {
+    int frame_size = FRAME_SIZE;
+    int opus_application = OPUS_APPLICATION_VOIP;
+    int bitrate = OPUS_BITRATE;
+    int complexity = 5;
+    bool low_latency_device = false;   // минимальная задержка устройства вместо умолчания
+    int jitter_target_ms = 0;          // глубина очереди воспроизведения, 0 — без ограничения
+    int poll_interval_us = 1000;       // пауза сетевого цикла
+    int bundle_frames = 1;             // кадров Opus в одной датаграмме, 1 — без склейки
+
+    static AudioProfile standard() { return AudioProfile(); }
+
+    // Кадры 2.5 или 5 мс, RESTRICTED_LOWDELAY (только CELT), мелкий джиттер-буфер
+    static AudioProfile low_latency(int frame_size) {
+        AudioProfile profile;
+        profile.frame_size = frame_size;
+        profile.opus_application = OPUS_APPLICATION_RESTRICTED_LOWDELAY;
+        profile.bitrate = 64000;
+        profile.low_latency_device = true;
+        profile.jitter_target_ms = 5;
+        profile.poll_interval_us = 200;
+        return profile;
+    }
 
-// ==================== NETWORK CLASS ====================
-class Network {
-public:
-    Network() : sockfd(-1), running(false) {}
+    float frame_ms() const { return frame_size * 1000.0f / SAMPLE_RATE; }
 
-    ~Network() { stop(); }
+    // Кадров в очереди воспроизведения, 0 — без ограничения. Не меньше
+    // MIN_JITTER_FRAMES: с одним кадром любой пакет, пришедший на период
+    // раньше, вытесняет предыдущий, и обычный джиттер сети превращается в потери
+    static constexpr size_t MIN_JITTER_FRAMES = 2;
 
-    bool start_server(int port) {
-        return create_socket("0.0.0.0", port);
+    size_t jitter_frames() const {
+        if (jitter_target_ms <= 0) return 0;
+        return std::max(MIN_JITTER_FRAMES,
+                        static_cast<size_t>((jitter_target_ms * SAMPLE_RATE / 1000 + frame_size - 1) / frame_size));
     }
+};
+
+// ==================== AUDIO SYSTEM ====================
+// Режимы общие для float и int16 тракта
+struct AudioMode {
+    enum Mode {
+        MODE_LOCAL_ECHO,     // Локальный эхо-тест
+        MODE_SERVER,         // Сервер (ретранслятор)
+        MODE_CLIENT          // Клиент
+    };
+};
 
-    bool start_client(const std::string& server_ip, int port) {
-        peer_addr.sin_family = AF_INET;
-        peer_addr.sin_port = htons(port);
-        inet_pton(AF_INET, server_ip.c_str(), &peer_addr.sin_addr);
+// Sample: float (по умолчанию) или int16_t — весь тракт от захвата
+// до воспроизведения в одном формате, без промежуточных преобразований
+template <typename Sample>
+class BasicAudioSystem : public AudioMode {
+public:
+    // У каждого счетчика один пишущий поток (указан в группе)
+    struct Counters {
+        // Сетевой поток
+        metrics::Counter packets_sent;
+        metrics::Counter bytes_sent;
+        metrics::Counter send_errors;
+        metrics::Counter reports_sent;
+        metrics::Counter packets_received;
+        metrics::Counter bytes_received;
+        metrics::Counter invalid_packets;
+        metrics::Counter auth_failures;
+        metrics::Counter replayed_packets;
+        metrics::Counter frames_decoded;
+        metrics::Counter decode_errors;
+        metrics::Counter playback_dropped;
+
+        // Поток callback звука
+        metrics::Counter frames_captured;
+        metrics::Counter encode_errors;
+        metrics::Counter network_dropped;
+        metrics::Counter playback_periods;
+        metrics::Counter playback_empty;
+        metrics::Counter playback_partial;
+    };
 
-        return create_socket("0.0.0.0", 0);
-    }
+    BasicAudioSystem() :
+        running(false),
+        mode(MODE_LOCAL_ECHO),
+        sequence_number(0),
+        timestamp(0),
+        ssrc(std::random_device{}()) {}
 
-    void stop() {
-        running = false;
-        if (sockfd != -1) {
-            close(sockfd);
-            sockfd = -1;
-        }
+    ~BasicAudioSystem() { stop(); }
+
+    // До init(): вместо PortAudio — null/WAV устройство (CI, нагрузочные тесты)
+    void set_audio_backend(std::unique_ptr<AudioBackend<Sample>> backend) {
+        audio = std::move(backend);
     }
 
-    bool send_to(const std::vector<unsigned char>& data, const sockaddr_in& addr) {
-        if (sockfd == -1) return false;
+    // До start(): комната на ретрансляторе, слышны только ее участники
+    void set_room(uint16_t r) { room = r; }
+
+    // До init(): порт ретранслятора (сервер слушает, клиент шлет на него)
+    void set_port(int p) { port = p; }
 
-        socklen_t addr_len = sizeof(addr);
-        int sent = sendto(sockfd, data.data(), data.size(), 0,
-                         (struct sockaddr*)&addr, addr_len);
+    // До init(), режим сервера: соседние ретрансляторы "ip:port" для транков
+    void set_peers(const std::vector<std::string>& addresses) { peer_addresses = addresses; }
 
-        return sent == static_cast<int>(data.size());
+    // До init(): общий ключ сессии (hex), пакеты шифруются AES-GCM.
+    // Ключ должен совпадать у всех клиентов и ретрансляторов
+    bool set_key(const std::string& hex) {
+        if (!crypto.set_key_hex(hex)) {
+            std::cerr << "❌ Session key must be 32 or 64 hex digits (AES-128/256)" << std::endl;
+            return false;
+        }
+        session_key = hex;
+        crypto_salt = PacketCrypto::random_salt();
+        return true;
     }
 
-    bool send(const std::vector<unsigned char>& data) {
-        return send_to(data, peer_addr);
+    // До init(), режим сервера: запись комнат в Ogg Opus (rooms пустой — все)
+    void set_recording(const std::string& directory, const std::vector<uint16_t>& rooms) {
+        record_directory = directory;
+        record_rooms = rooms;
     }
 
-    bool receive(std::vector<unsigned char>& data, sockaddr_in& from_addr) {
-        if (sockfd == -1) return false;
+    // До init(): приоритеты и ядра потоков звука, сети и кодеков сервера
+    void set_realtime(const realtime::Config& config) { rt_config = config; }
 
-        char buffer[4096];
-        socklen_t addr_len = sizeof(from_addr);
+    // Источник звука закончился (конец входного WAV)
+    bool audio_finished() const { return audio && audio->finished(); }
 
-        int received = recvfrom(sockfd, buffer, sizeof(buffer), MSG_DONTWAIT,
-                               (struct sockaddr*)&from_addr, &addr_len);
+    const Counters& counters() const { return stats; }
 
-        if (received > 0) {
-            data.assign(buffer, buffer + received);
-            return true;
-        }
+    // Сервер: клиенты и пересланные пакеты ретранслятора
+    size_t relay_clients() const { return relay ? relay->client_count() : 0; }
+    uint64_t relay_forwarded() const { return relay ? relay->packets_forwarded() : 0; }
+    size_t relay_peers_up() const { return relay ? relay->peers_up() : 0; }
 
-        return false;
-    }
+    // Задержки по этапам: у сервера — ретранслятора, иначе свои.
+    // Вызывать до stop(): ретранслятор при остановке удаляется
+    PipelineLatency& pipeline_latency() { return relay ? relay->latency() : latency; }
 
-private:
-    bool create_socket(const std::string& bind_ip, int port) {
-        sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-        if (sockfd < 0) return false;
-
-        int flags = fcntl(sockfd, F_GETFL, 0);
-        fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
-
-        // Allow multiple clients to bind to same port
-        int opt = 1;
-        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-        sockaddr_in bind_addr;
-        memset(&bind_addr, 0, sizeof(bind_addr));
-        bind_addr.sin_family = AF_INET;
-        bind_addr.sin_port = htons(port);
-        inet_pton(AF_INET, bind_ip.c_str(), &bind_addr.sin_addr);
-
-        if (bind(sockfd, (struct sockaddr*)&bind_addr, sizeof(bind_addr)) < 0) {
-            close(sockfd);
-            sockfd = -1;
-            return false;
+    // Все счетчики в формате Prometheus. Вызывать между start() и stop()
+    void write_metrics(metrics::Writer& out) const {
+        if (relay) {
+            relay->write_metrics(out);
+            return;
         }
 
-        running = true;
-        return true;
-    }
-
-private:
-    int sockfd;
-    std::atomic<bool> running;
-    sockaddr_in peer_addr;
-};
+        out.counter("voice_packets_sent_total", "Datagrams sent to the server", stats.packets_sent.get());
+        out.counter("voice_bytes_sent_total", "Bytes sent to the server", stats.bytes_sent.get());
+        out.counter("voice_send_errors_total", "Datagrams the socket refused to send", stats.send_errors.get());
+        out.counter("voice_reports_sent_total", "Receiver reports sent", stats.reports_sent.get());
+        out.counter("voice_packets_received_total", "Datagrams received from the server",
+                    stats.packets_received.get());
+        out.counter("voice_bytes_received_total", "Bytes received from the server", stats.bytes_received.get());
+        out.counter("voice_invalid_packets_total", "Datagrams dropped as malformed or unbundlable",
+                    stats.invalid_packets.get());
+        if (crypto.enabled()) {
+            out.counter("voice_auth_failures_total", "Datagrams dropped for a bad or missing authentication tag",
+                        stats.auth_failures.get());
+            out.counter("voice_replayed_packets_total", "Authenticated datagrams dropped as replays",
+                        stats.replayed_packets.get());
+        }
+        out.counter("voice_frames_decoded_total", "Opus frames decoded", stats.frames_decoded.get());
+        out.counter("voice_decode_errors_total", "Opus frames that failed to decode", stats.decode_errors.get());
+        out.counter("voice_playback_dropped_total", "Decoded frames dropped to keep the jitter target",
+                    stats.playback_dropped.get());
+        out.counter("voice_frames_captured_total", "Device periods captured", stats.frames_captured.get());
+        out.counter("voice_encode_errors_total", "Captured periods that failed to encode",
+                    stats.encode_errors.get());
+        out.counter("voice_network_dropped_total", "Encoded frames dropped because the send queue was full",
+                    stats.network_dropped.get());
+        out.counter("voice_playback_periods_total", "Device periods played", stats.playback_periods.get());
+        out.counter("voice_playback_empty_total", "Device periods played as silence (nothing queued)",
+                    stats.playback_empty.get());
+        out.counter("voice_playback_partial_total", "Device periods only partly filled from the queue",
+                    stats.playback_partial.get());
+
+        out.gauge("voice_playback_queue_depth", "Decoded frames waiting for playback",
+                  static_cast<double>(playback_queue.size()));
+        {
+            std::lock_guard<std::mutex> lock(net_queue_mutex);
+            out.gauge("voice_network_queue_depth", "Encoded frames waiting to be sent",
+                      static_cast<double>(network_queue.size()));
+        }
 
-// ==================== AUDIO SYSTEM ====================
-class AudioSystem {
-public:
-    enum Mode {
-        MODE_LOCAL_ECHO,     // Локальный эхо-тест
-        MODE_SERVER,         // Сервер (ретранслятор)
-        MODE_CLIENT          // Клиент
-    };
+        if (const DeviceStats* device = device_stats()) {
+            DeviceStats::Snapshot snapshot = device->snapshot();
+            std::string backend = "backend=\"" + std::string(device_name()) + "\"";
+            out.counter("voice_device_callbacks_total", "Audio device callbacks", snapshot.callbacks, backend);
+            out.counter("voice_device_slow_callbacks_total", "Callbacks longer than the buffer period",
+                        snapshot.slow_callbacks, backend);
+            for (int i = 0; i < DeviceStats::NUM_FLAGS; ++i) {
+                auto flag = static_cast<DeviceStats::Flag>(i);
+                out.counter("voice_device_status_flags_total", "Device status flags (xruns and priming)",
+                            snapshot.flags[i],
+                            backend + ",flag=\"" + DeviceStats::flag_name(flag) + "\"");
+            }
+        }
 
-    AudioSystem() :
-        pa_initialized(false),
-        running(false),
-        mode(MODE_LOCAL_ECHO),
-        sequence_number(0) {}
+        latency.write_metrics(out);
+    }
 
-    ~AudioSystem() { stop(); }
+    // Xrun и тайминг устройства; nullptr — звука нет (сервер)
+    const DeviceStats* device_stats() const { return audio ? &audio->stats() : nullptr; }
+    const char* device_name() const { return audio ? audio->name() : "none"; }
 
-    bool init(Mode m, const std::string& remote_ip = "") {
+    bool init(Mode m, const std::string& remote_ip = "",
+              const AudioProfile& p = AudioProfile::standard()) {
         mode = m;
+        profile = p;
+        capture_buffer.assign(profile.frame_size, Sample(0));
 
-        // PortAudio инициализируем только если нужно захватывать/воспроизводить звук
+        // Звук только у клиента и локального эхо: один дуплексный поток.
+        // Эхо-тест тоже захватывает микрофон и слушает себя через Opus
         if (mode != MODE_SERVER) {
-            if (Pa_Initialize() != paNoError) {
-                std::cerr << "❌ PortAudio init failed" << std::endl;
-                return false;
-            }
-            pa_initialized = true;
-
-            // Только клиенты захватывают звук с микрофона
             if (mode == MODE_CLIENT) {
-                if (Pa_OpenDefaultStream(&capture_stream, 1, 0, paFloat32,
-                                        SAMPLE_RATE, FRAME_SIZE, capture_cb, this) != paNoError) {
-                    std::cerr << "❌ Capture stream failed" << std::endl;
-                    return false;
-                }
+                // Эхо из динамиков не должно уходить обратно в сеть
+                echo_canceller = std::make_unique<EchoCanceller>(SAMPLE_RATE, profile.frame_size);
             }
 
-            // Все кроме сервера воспроизводят звук
-            if (mode != MODE_SERVER) {
-                if (Pa_OpenDefaultStream(&playback_stream, 0, 1, paFloat32,
-                                        SAMPLE_RATE, FRAME_SIZE, playback_cb, this) != paNoError) {
-                    std::cerr << "❌ Playback stream failed" << std::endl;
-                    if (capture_stream) Pa_CloseStream(capture_stream);
-                    return false;
-                }
+            auto callback = [this](const Sample* in, Sample* out, unsigned long frames) {
+                process_audio(in, out, frames);
+            };
+            if (!audio) {
+                audio = std::make_unique<PortAudioBackend<Sample>>();
+            }
+            if (!audio->open(SAMPLE_RATE, profile.frame_size, CHANNELS,
+                             profile.low_latency_device, callback)) {
+                std::cerr << "❌ Audio backend '" << audio->name() << "' failed" << std::endl;
+                return false;
             }
         }
 
         // Opus для всех режимов
         int err;
-        encoder = opus_encoder_create(SAMPLE_RATE, CHANNELS, OPUS_APPLICATION_VOIP, &err);
+        encoder = opus_encoder_create(SAMPLE_RATE, CHANNELS, profile.opus_application, &err);
         decoder = opus_decoder_create(SAMPLE_RATE, CHANNELS, &err);
 
         if (!encoder || !decoder) {
@@ -175,9 +284,9 @@ public:
             return false;
         }
 
-        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(OPUS_BITRATE));
+        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(profile.bitrate));
         opus_encoder_ctl(encoder, OPUS_SET_VBR(1));
-        opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(5));
+        opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(profile.complexity));
 
         // Network
         if (mode != MODE_LOCAL_ECHO) {
@@ -194,11 +303,16 @@ public:
         if (!running) {
             running = true;
 
-            if (capture_stream) Pa_StartStream(capture_stream);
-            if (playback_stream) Pa_StartStream(playback_stream);
+            if (audio && audio->is_open()) {
+                realtime::expect("audio", rt_config.audio);
+                audio->start();
+            }
 
-            if (mode != MODE_LOCAL_ECHO) {
-                network_thread = std::thread(&AudioSystem::network_loop, this);
+            if (mode == MODE_SERVER) {
+                relay->start();
+            } else if (mode == MODE_CLIENT) {
+                realtime::expect("network", rt_config.network);
+                network_thread = std::thread(&BasicAudioSystem::network_loop, this);
             }
         }
     }
@@ -207,21 +321,16 @@ public:
         if (running) {
             running = false;
 
-            if (mode != MODE_LOCAL_ECHO && network_thread.joinable()) {
-                network_thread.join();
+            if (relay) {
+                relay->stop();
+                relay.reset();
             }
 
-            if (capture_stream) {
-                Pa_StopStream(capture_stream);
-                Pa_CloseStream(capture_stream);
-                capture_stream = nullptr;
+            if (network_thread.joinable()) {
+                network_thread.join();
             }
 
-            if (playback_stream) {
-                Pa_StopStream(playback_stream);
-                Pa_CloseStream(playback_stream);
-                playback_stream = nullptr;
-            }
+            if (audio) audio->close();
 
             if (encoder) {
                 opus_encoder_destroy(encoder);
@@ -233,208 +342,469 @@ public:
                 decoder = nullptr;
             }
 
-            if (pa_initialized) {
-                Pa_Terminate();
-                pa_initialized = false;
-            }
-
             // Clean queues
-            {
-                std::lock_guard<std::mutex> lock(queue_mutex);
-                while (!audio_queue.empty()) audio_queue.pop();
-            }
+            playback_queue.clear();
             {
                 std::lock_guard<std::mutex> lock(net_queue_mutex);
                 while (!network_queue.empty()) network_queue.pop();
             }
 
-            // Clean clients
-            clients.clear();
+            echo_canceller.reset();
+            remote_streams.clear();
         }
     }
 
 private:
+    // Закодированный кадр в очереди на отправку с метками захвата и кодирования
+    struct EncodedFrame {
+        std::vector<unsigned char> data;
+        uint64_t captured_ns;
+        uint64_t encoded_ns;
+    };
+
     bool init_network(const std::string& remote_ip) {
         if (remote_ip.empty()) {
-            // Server mode
-            std::cout << "🔌 Server mode (port " << NETWORK_PORT << ")" << std::endl;
-            return network.start_server(NETWORK_PORT);
+            // Server mode: ретрансляцию ведет Relay
+            std::cout << "🔌 Server mode (port " << port << ")" << std::endl;
+            relay = std::make_unique<Relay>(0, rt_config);
+            if (!record_directory.empty()) {
+                relay->set_recorder(std::make_unique<Recorder>(record_directory, record_rooms));
+            }
+            for (const std::string& address : peer_addresses) {
+                if (!relay->add_peer(address)) return false;
+            }
+            if (!session_key.empty() && !relay->set_key(session_key)) return false;
+            return relay->listen(port);
         } else {
             // Client mode
-            std::cout << "🔌 Client mode (connecting to " << remote_ip << ":" << NETWORK_PORT << ")" << std::endl;
-            return network.start_client(remote_ip, NETWORK_PORT);
+            std::cout << "🔌 Client mode (connecting to " << remote_ip << ":" << port << ")" << std::endl;
+            if (!network.start_client(remote_ip, port)) return false;
+            network.enable_timestamps();
+            if (crypto.enabled()) {
+                std::cout << "🔒 Packets encrypted with AES-" << crypto.bits() << "-GCM" << std::endl;
+            }
+            return true;
         }
     }
 
     void network_loop() {
+        realtime::apply("network", rt_config.network);
+        TRACE_THREAD("network");
+
         std::vector<unsigned char> buffer;
         sockaddr_in from_addr;
+        int64_t queued_ns;
+        auto last_report = std::chrono::steady_clock::now();
 
         while (running) {
-            // Принимаем данные от всех клиентов
-            if (network.receive(buffer, from_addr)) {
-                if (buffer.size() > sizeof(uint32_t)) {
-                    // Извлекаем sequence number
-                    uint32_t seq_num;
-                    memcpy(&seq_num, buffer.data(), sizeof(seq_num));
-
-                    std::vector<unsigned char> audio_data(buffer.begin() + sizeof(seq_num), buffer.end());
-
-                    if (mode == MODE_SERVER) {
-                        // Сервер: ретранслируем всем клиентам кроме отправителя
-                        broadcast_audio(audio_data, from_addr);
-                    } else {
-                        // Клиент: декодируем и воспроизводим
-                        float decoded[FRAME_SIZE];
-                        int samples = opus_decode_float(decoder, audio_data.data(), audio_data.size(),
-                                                       decoded, FRAME_SIZE, 0);
-
-                        if (samples > 0) {
-                            std::vector<float> audio(decoded, decoded + samples);
-
-                            std::lock_guard<std::mutex> lock(queue_mutex);
-                            audio_queue.push(std::move(audio));
-                        }
-                    }
-
-                    // Запоминаем клиента (для сервера)
-                    if (mode == MODE_SERVER) {
-                        std::string client_key = get_client_key(from_addr);
-                        if (clients.find(client_key) == clients.end()) {
-                            clients[client_key] = from_addr;
-                            std::cout << "📱 New client connected: " << client_key << std::endl;
-                        }
-                    }
+            TRACE_BEGIN("network_iteration");
+
+            // Принимаем потоки других клиентов от сервера
+            while (network.receive(buffer, from_addr, queued_ns)) {
+                uint64_t read_ns = LatencyHistogram::now_ns();
+                uint64_t arrived_ns = read_ns;
+                if (queued_ns >= 0) {
+                    latency.record(PipelineLatency::RECEIVE_WAIT, static_cast<uint64_t>(queued_ns));
+                    arrived_ns -= std::min<uint64_t>(static_cast<uint64_t>(queued_ns), read_ns);
                 }
+                receive_audio(buffer, read_ns, arrived_ns);
             }
 
-            // Отправляем данные (только клиенты отправляют)
-            if (mode == MODE_CLIENT) {
+            // Отправляем все накопленные кадры: захват (например, WAV с --fast)
+            // может класть их быстрее одного за итерацию. Очередь забирается
+            // целиком, отправка идет без блокировки callback
+            {
                 std::lock_guard<std::mutex> lock(net_queue_mutex);
-                if (!network_queue.empty()) {
-                    auto data = network_queue.front();
-                    network_queue.pop();
-
-                    std::vector<unsigned char> packet;
-                    packet.resize(sizeof(sequence_number) + data.size());
+                network_queue.swap(sending_queue);
+            }
+            while (!sending_queue.empty()) {
+                send_frame(sending_queue.front());
+                sending_queue.pop();
+            }
 
-                    memcpy(packet.data(), &sequence_number, sizeof(sequence_number));
-                    memcpy(packet.data() + sizeof(sequence_number), data.data(), data.size());
+            // Раз в секунду сообщаем серверу о потерях — по ним он выбирает нам битрейт
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_report >= std::chrono::seconds(1)) {
+                send_receiver_report();
+                last_report = now;
+            }
 
-                    sequence_number++;
+            TRACE_END("network_iteration");
+            std::this_thread::sleep_for(std::chrono::microseconds(profile.poll_interval_us));
+        }
+    }
 
-                    network.send(packet);
-                }
+    // read_ns — пакет прочитан из сокета, arrived_ns — пришел в сокет
+    void receive_audio(const std::vector<unsigned char>& buffer, uint64_t read_ns, uint64_t arrived_ns) {
+        stats.packets_received.add();
+        stats.bytes_received.add(buffer.size());
+
+        // С ключом принимаем только пакеты с верным тегом
+        const unsigned char* packet = buffer.data();
+        size_t size = buffer.size();
+        uint32_t packet_salt = 0;
+        if (crypto.enabled()) {
+            if (opened_packet.size() < size) opened_packet.resize(size);
+            size = crypto.open(packet, size, opened_packet.data(), &packet_salt);
+            if (size == 0) {
+                stats.auth_failures.add();
+                return;
             }
+            packet = opened_packet.data();
+        }
+
+        protocol::PacketHeader header;
+        if (!protocol::read_header(packet, size, header) ||
+            header.type != protocol::PACKET_AUDIO || size <= protocol::HEADER_SIZE) {
+            stats.invalid_packets.add();
+            return;
+        }
+        if (crypto.enabled() && !replay.accept(header, packet_salt)) {
+            stats.replayed_packets.add();
+            return;
+        }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        track_sequence(header);
+
+        // Датаграмма может нести несколько кадров — в очередь кладем по одному
+        int frame_bytes[OpusBundler::MAX_FRAMES];
+        int frames = bundler.split(packet + protocol::HEADER_SIZE,
+                                   size - protocol::HEADER_SIZE,
+                                   split_buffer, sizeof(split_buffer),
+                                   frame_bytes, OpusBundler::MAX_FRAMES);
+        if (frames <= 0) {
+            stats.invalid_packets.add();
+            return;
+        }
+
+        const unsigned char* frame = split_buffer;
+        for (int i = 0; i < frames; ++i) {
+            Sample decoded[MAX_OPUS_FRAME_SIZE];
+            int samples;
+            {
+                TRACE_SCOPE("decode");
+                samples = opusDecode(decoder, frame, frame_bytes[i], decoded, MAX_OPUS_FRAME_SIZE, 0);
+            }
+            frame += frame_bytes[i];
+            if (samples <= 0) {
+                stats.decode_errors.add();
+                continue;
+            }
+            stats.frames_decoded.add();
+
+            // Очередь глубже цели — отбрасываем старое, чтобы не копить задержку.
+            // Целую пачку не режем
+            size_t max_frames = profile.jitter_frames();
+            if (max_frames > 0) max_frames = std::max<size_t>(max_frames, frames);
+            uint64_t queued_ns = LatencyHistogram::now_ns();
+            latency.record(PipelineLatency::DECODE, queued_ns - read_ns);
+            size_t dropped = playback_queue.push(std::vector<Sample>(decoded, decoded + samples), max_frames,
+                                                 {arrived_ns, queued_ns});
+            if (dropped > 0) {
+                TRACE_INSTANT("playback_dropped");
+                stats.playback_dropped.add(dropped);
+            }
         }
     }
 
-    void broadcast_audio(const std::vector<unsigned char>& audio_data, const sockaddr_in& exclude_addr) {
-        std::vector<unsigned char> packet;
-        packet.resize(sizeof(sequence_number) + audio_data.size());
+    void send_frame(const EncodedFrame& frame) {
+        const std::vector<unsigned char>& data = frame.data;
+        if (profile.bundle_frames <= 1) {
+            send_packet(data.data(), data.size(), timestamp, frame.captured_ns, frame.encoded_ns);
+            timestamp += profile.frame_size;
+            return;
+        }
 
-        memcpy(packet.data(), &sequence_number, sizeof(sequence_number));
-        memcpy(packet.data() + sizeof(sequence_number), audio_data.data(), audio_data.size());
+        // Склеиваем bundle_frames кадров в одну датаграмму.
+        // Задержку пачки считаем по ее первому (самому старому) кадру
+        if (bundler.getFrameCount() == 0) {
+            bundle_timestamp = timestamp;
+            bundle_captured_ns = frame.captured_ns;
+            bundle_encoded_ns = frame.encoded_ns;
+        }
+        if (!bundler.add(data.data(), data.size())) {
+            flush_bundle();
+            bundle_timestamp = timestamp;
+            bundle_captured_ns = frame.captured_ns;
+            bundle_encoded_ns = frame.encoded_ns;
+            if (!bundler.add(data.data(), data.size())) return;
+        }
+        timestamp += profile.frame_size;
 
-        sequence_number++;
+        if (bundler.getFrameCount() >= profile.bundle_frames) {
+            flush_bundle();
+        }
+    }
 
-        // Отправляем всем клиентам кроме отправителя
-        for (const auto& [key, client_addr] : clients) {
-            // Не отправляем обратно отправителю
-            if (client_addr.sin_addr.s_addr == exclude_addr.sin_addr.s_addr &&
-                client_addr.sin_port == exclude_addr.sin_port) {
-                continue;
+    void flush_bundle() {
+        unsigned char bundled[OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES];
+        int bytes = bundler.flush(bundled, sizeof(bundled));
+        if (bytes > 0) {
+            send_packet(bundled, bytes, bundle_timestamp, bundle_captured_ns, bundle_encoded_ns);
+        }
+    }
+
+    void send_packet(const unsigned char* payload, size_t size, uint32_t packet_timestamp,
+                     uint64_t captured_ns, uint64_t encoded_ns) {
+        protocol::PacketHeader header;
+        header.room = room;
+        header.ssrc = ssrc;
+        header.sequence = sequence_number++;
+        header.timestamp = packet_timestamp;
+
+        unsigned char packet[protocol::HEADER_SIZE + OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES];
+        if (size > sizeof(packet) - protocol::HEADER_SIZE) return;
+        TRACE_SCOPE("send");
+
+        protocol::write_header(packet, header);
+        memcpy(packet + protocol::HEADER_SIZE, payload, size);
+        bool sent = send_sealed(packet, protocol::HEADER_SIZE + size);
+
+        if (sent) {
+            latency.record_since(PipelineLatency::SEND_QUEUE, encoded_ns);
+            latency.record_since(PipelineLatency::CAPTURE_TO_SEND, captured_ns);
+        }
+    }
+
+    // С ключом пакет уходит зашифрованным
+    bool send_sealed(const unsigned char* packet, size_t size) {
+        unsigned char sealed[protocol::HEADER_SIZE + OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES +
+                             PacketCrypto::OVERHEAD];
+        if (crypto.enabled()) {
+            size = crypto.seal(packet, size, crypto_salt, sealed);
+            if (size == 0) {
+                stats.send_errors.add();
+                return false;
             }
+            packet = sealed;
+        }
 
-            network.send_to(packet, client_addr);
+        bool sent = network.send(packet, size);
+        count_send(sent, size);
+        return sent;
+    }
+
+    void count_send(bool sent, size_t bytes) {
+        if (!sent) {
+            stats.send_errors.add();
+            return;
         }
+        stats.packets_sent.add();
+        stats.bytes_sent.add(bytes);
     }
 
-    std::string get_client_key(const sockaddr_in& addr) {
-        char ip_str[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &addr.sin_addr, ip_str, INET_ADDRSTRLEN);
-        return std::string(ip_str) + ":" + std::to_string(ntohs(addr.sin_port));
+    // Учет принятых и ожидаемых пакетов по каждому говорящему
+    void track_sequence(const protocol::PacketHeader& header) {
+        auto it = remote_streams.find(header.ssrc);
+        if (it == remote_streams.end()) {
+            it = remote_streams.emplace(header.ssrc, RemoteStream{header.sequence, header.sequence, 0}).first;
+        }
+
+        RemoteStream& stream = it->second;
+        if (static_cast<int32_t>(header.sequence - stream.max_sequence) > 0) {
+            stream.max_sequence = header.sequence;
+        }
+        stream.received++;
     }
 
-    static int capture_cb(const void* input, void* output, unsigned long frame_count,
-                         const PaStreamCallbackTimeInfo* time_info, PaStreamCallbackFlags flags, void* user_data) {
-        (void)output; (void)time_info; (void)flags;
+    void send_receiver_report() {
+        uint64_t expected = 0, received = 0;
+        for (auto& [id, stream] : remote_streams) {
+            expected += stream.max_sequence - stream.base_sequence + 1;
+            received += stream.received;
 
-        AudioSystem* self = static_cast<AudioSystem*>(user_data);
-        if (input && self && self->running && self->mode == MODE_CLIENT) {
-            self->capture_audio(static_cast<const float*>(input), frame_count);
+            stream.base_sequence = stream.max_sequence + 1;
+            stream.received = 0;
         }
-        return 0;
+
+        protocol::ReceiverReport report;
+        if (expected > received) {
+            report.loss_permille = static_cast<uint16_t>((expected - received) * 1000 / expected);
+        }
+
+        protocol::PacketHeader header;
+        header.type = protocol::PACKET_RECEIVER_REPORT;
+        header.room = room;
+        header.ssrc = ssrc;
+        // Свой счетчик: с ключом номер входит в nonce и окно повторов
+        header.sequence = report_sequence++;
+
+        unsigned char packet[protocol::HEADER_SIZE + protocol::REPORT_SIZE];
+        protocol::write_header(packet, header);
+        protocol::write_report(packet + protocol::HEADER_SIZE, report);
+        send_sealed(packet, sizeof(packet));
+        stats.reports_sent.add();
     }
 
-    static int playback_cb(const void* input, void* output, unsigned long frame_count,
-                          const PaStreamCallbackTimeInfo* time_info, PaStreamCallbackFlags flags, void* user_data) {
-        (void)input; (void)time_info; (void)flags;
+    // Callback дуплексного потока: выход и вход одного периода
+    void process_audio(const Sample* input, Sample* output, unsigned long frame_count) {
+        // Поток callback создает бэкенд: настраиваем его при первом вызове
+        if (!audio_thread_tuned) {
+            audio_thread_tuned = true;
+            realtime::apply("audio", rt_config.audio);
+            TRACE_THREAD("audio");
+        }
 
-        AudioSystem* self = static_cast<AudioSystem*>(user_data);
-        if (!output || !self || !self->running || self->mode == MODE_SERVER) return 0;
+        if (!running) {
+            memset(output, 0, frame_count * sizeof(Sample));
+            return;
+        }
+        TRACE_SCOPE("audio_callback");
+        uint64_t callback_ns = LatencyHistogram::now_ns();
 
-        float* out = static_cast<float*>(output);
-        std::lock_guard<std::mutex> lock(self->queue_mutex);
+        if (mode == MODE_LOCAL_ECHO) {
+            loopback_audio(input, output, frame_count);
+            return;
+        }
 
-        if (!self->audio_queue.empty()) {
-            auto& data = self->audio_queue.front();
-            size_t to_copy = std::min(data.size(), static_cast<size_t>(frame_count));
+        fill_playback(output, frame_count);
 
-            memcpy(out, data.data(), to_copy * sizeof(float));
+        // То, что ушло в динамики, — опорный сигнал для эхоподавителя
+        if (echo_canceller) {
+            echo_canceller->pushReference(output, frame_count);
+        }
 
-            if (to_copy == data.size()) {
-                self->audio_queue.pop();
-            } else {
-                self->audio_queue.front() = std::vector<float>(data.begin() + to_copy, data.end());
-            }
+        if (input) {
+            capture_audio(input, frame_count, callback_ns);
+        }
+    }
 
-            if (to_copy < frame_count) {
-                memset(out + to_copy, 0, (frame_count - to_copy) * sizeof(float));
-            }
-        } else {
-            memset(out, 0, frame_count * sizeof(float));
+    void fill_playback(Sample* out, unsigned long frame_count) {
+        typename PlaybackQueue<Sample>::Timing started;
+        size_t filled = playback_queue.fill(out, frame_count, &started);
+
+        // Кадр начал звучать: сколько ждал в очереди и сколько с прихода пакета
+        if (started.queued_ns != 0) {
+            latency.record_since(PipelineLatency::JITTER_BUFFER, started.queued_ns);
+            latency.record_since(PipelineLatency::RECEIVE_TO_PLAYOUT, started.arrived_ns);
         }
 
-        return 0;
+        stats.playback_periods.add();
+        if (filled == 0) {
+            stats.playback_empty.add();
+        } else if (filled < frame_count) {
+            TRACE_INSTANT("playback_partial");
+            stats.playback_partial.add();
+        }
     }
 
-    void capture_audio(const float* input, unsigned long frame_count) {
+    // Эхо-тест: микрофон → Opus → динамики в том же периоде
+    void loopback_audio(const Sample* input, Sample* output, unsigned long frame_count) {
+        unsigned char encoded[OpusBundler::MAX_FRAME_BYTES];
+        int bytes = input ? opusEncode(encoder, input, frame_count, encoded, sizeof(encoded)) : 0;
+        int samples = (bytes > 0) ? opusDecode(decoder, encoded, bytes, output, frame_count, 0) : 0;
+
+        if (input) stats.frames_captured.add();
+        if (input && bytes <= 0) stats.encode_errors.add();
+        stats.playback_periods.add();
+
+        if (samples < static_cast<int>(frame_count)) {
+            samples = std::max(samples, 0);
+            memset(output + samples, 0, (frame_count - samples) * sizeof(Sample));
+        }
+    }
+
+    // callback_ns — вход в callback этого периода
+    void capture_audio(const Sample* input, unsigned long frame_count, uint64_t callback_ns) {
+        // Убираем эхо динамиков из микрофона
+        if (echo_canceller && frame_count == capture_buffer.size()) {
+            TRACE_SCOPE("echo_cancel");
+            echo_canceller->process(input, capture_buffer.data());
+            input = capture_buffer.data();
+        }
+        uint64_t processed_ns = LatencyHistogram::now_ns();
+        latency.record(PipelineLatency::CAPTURE_PROCESS, processed_ns - callback_ns);
+
         // Кодируем аудио
         unsigned char encoded[400];
-        int bytes = opus_encode_float(encoder, input, frame_count, encoded, sizeof(encoded));
-        if (bytes <= 0) return;
+        int bytes;
+        {
+            TRACE_SCOPE("encode");
+            bytes = opusEncode(encoder, input, frame_count, encoded, sizeof(encoded));
+        }
+        uint64_t encoded_ns = LatencyHistogram::now_ns();
+        latency.record(PipelineLatency::ENCODE, encoded_ns - processed_ns);
+        stats.frames_captured.add();
+        if (bytes <= 0) {
+            stats.encode_errors.add();
+            return;
+        }
 
-        // Отправляем в сетевую очередь
-        std::vector<unsigned char> data(encoded, encoded + bytes);
+        // Отправляем в сетевую очередь; если сетевой поток встал, очередь
+        // не растет дальше MAX_NETWORK_QUEUE кадров
+        EncodedFrame frame{std::vector<unsigned char>(encoded, encoded + bytes), callback_ns, encoded_ns};
         std::lock_guard<std::mutex> lock(net_queue_mutex);
-        network_queue.push(std::move(data));
+        if (network_queue.size() >= MAX_NETWORK_QUEUE) {
+            stats.network_dropped.add();
+            return;
+        }
+        network_queue.push(std::move(frame));
     }
 
 private:
-    bool pa_initialized;
     std::atomic<bool> running;
     Mode mode;
+    AudioProfile profile;
 
-    PaStream* capture_stream = nullptr;   // Только у клиента
-    PaStream* playback_stream = nullptr;  // У клиента и локального эхо
+    std::unique_ptr<AudioBackend<Sample>> audio;  // У клиента и локального эхо
 
     OpusEncoder* encoder = nullptr;
     OpusDecoder* decoder = nullptr;
 
+    // Эхоподавитель (только у клиента)
+    std::unique_ptr<EchoCanceller> echo_canceller;
+    std::vector<Sample> capture_buffer;
+
     // Очередь для воспроизведения
-    std::queue<std::vector<float>> audio_queue;
-    std::mutex queue_mutex;
+    PlaybackQueue<Sample> playback_queue;
 
     // Сеть
     Network network;
-    std::queue<std::vector<unsigned char>> network_queue;
-    std::mutex net_queue_mutex;
+    std::queue<EncodedFrame> network_queue;
+    std::queue<EncodedFrame> sending_queue;      // только сетевой поток
+    mutable std::mutex net_queue_mutex;
+    static constexpr size_t MAX_NETWORK_QUEUE = 256;
     std::thread network_thread;
     uint32_t sequence_number;
-
-    // Список клиентов (только для сервера)
-    std::map<std::string, sockaddr_in> clients;
+    uint32_t report_sequence = 0;
+    uint32_t timestamp;
+    uint32_t ssrc;
+    uint16_t room = 0;
+    int port = NETWORK_PORT;
+
+    // Склейка кадров в датаграммы и разбор принятых пачек
+    OpusBundler bundler;
+    uint32_t bundle_timestamp = 0;
+    uint64_t bundle_captured_ns = 0;
+    uint64_t bundle_encoded_ns = 0;
+    unsigned char split_buffer[OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES];
+
+    // Потоки других клиентов: для отчетов о потерях
+    struct RemoteStream {
+        uint32_t base_sequence;
+        uint32_t max_sequence;
+        uint32_t received;
+    };
+    std::map<uint32_t, RemoteStream> remote_streams;
+
+    // Ретранслятор (только у сервера)
+    std::unique_ptr<Relay> relay;
+    realtime::Config rt_config;
+    bool audio_thread_tuned = false;
+
+    Counters stats;
+    PipelineLatency latency;
+    std::string record_directory;
+    std::vector<uint16_t> record_rooms;
+    std::vector<std::string> peer_addresses;
+
+    // Шифрование пакетов: контексты — потока сети, у сервера свои у Relay
+    PacketCrypto crypto;
+    ReplayFilter replay;
+    uint32_t crypto_salt = 0;
+    std::string session_key;
+    std::vector<unsigned char> opened_packet;
 };
+
+using AudioSystem = BasicAudioSystem<float>;
+using AudioSystem16 = BasicAudioSystem<int16_t>;
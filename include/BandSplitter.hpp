@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+// Разделение 48 кГц сигнала на полосу речи (0-8 кГц, децимация до 16 кГц)
+// и верхнюю полосу. Верхняя полоса — остаток (вход минус интерполированная
+// нижняя), поэтому без обработки восстановление точное, с задержкой
+// getDelay() сэмплов: DELAY плюс задержка обработки нижней полосы.
+class BandSplitter {
+public:
+    static constexpr int DECIMATION = 3;
+    static constexpr int TAPS = 72;                  // кратно DECIMATION
+    static constexpr int DELAY = TAPS - 1;           // задержка анализ+синтез
+    static constexpr int PHASE_TAPS = TAPS / DECIMATION;
+    static constexpr float CUTOFF_HZ = 7000.0f;      // ФНЧ 7 кГц
+    static constexpr float SAMPLE_RATE = 48000.0f;
+
+    // lowBandLatency — задержка обработки нижней полосы в ее сэмплах
+    // (16 кГц), например NoiseSuppressor::getLatency(). На столько же
+    // задерживаются верхняя полоса и вычитаемая необработанная нижняя.
+    explicit BandSplitter(int frameSize = 480, int lowBandLatency = 0);
+
+    // Анализ: frameSize сэмплов → frameSize / 3 сэмплов нижней полосы (16 кГц)
+    void analyze(const float* input, float* lowBand);
+
+    // Синтез: обработанная нижняя полоса + верхняя с усилением highGain.
+    // Вызывается строго после analyze() того же кадра.
+    void synthesize(const float* lowBand, float highGain, float* output);
+
+    int getFrameSize() const { return frameSize_; }
+    int getLowBandSize() const { return lowSize_; }
+    int getDelay() const { return DELAY + DECIMATION * lowLatency_; }
+
+private:
+    int frameSize_;
+    int lowSize_;
+    int lowLatency_;
+    int historySize_;   // TAPS - 1 + DECIMATION * lowLatency_
+
+    // ФНЧ (окно Блэкмана)
+    std::vector<float> taps_;
+
+    // История входа: historySize_ прошлых сэмплов + текущий кадр.
+    // Первые frameSize_ элементов — вход с задержкой getDelay().
+    std::vector<float> inputHistory_;
+
+    // Нижняя полоса до обработки (для вычитания в синтезе): lowLatency_
+    // прошлых сэмплов + текущий кадр, первые lowSize_ — с той же
+    // задержкой, что у обработанной
+    std::vector<float> lowBand_;
+
+    // История интерполятора (16 кГц)
+    std::vector<float> lowHistory_;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "OpusCodec.hpp"
+#include "ThreadPool.hpp"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+// Планировщик кодеков на сервере: задачи decode/encode одного тика
+// выполняются параллельно на ThreadPool с дедлайном тика.
+// Состояние кодека закреплено за потоком (ключом): задачи одного ключа
+// идут последовательно в порядке добавления, разных ключей — параллельно.
+class CodecScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        enum Kind { DECODE, ENCODE };
+        enum Status { PENDING, DONE, LATE, MISSED };
+
+        Kind kind;
+        uint64_t stream;
+
+        // DECODE: packetIn → pcmOut (frameSize — емкость pcmOut на канал)
+        // ENCODE: pcmIn → packetOut (packetBytes — емкость packetOut)
+        const unsigned char* packetIn;
+        unsigned char* packetOut;
+        const float* pcmIn;
+        float* pcmOut;
+        int packetBytes;
+        int frameSize;
+
+        int result;      // байт / сэмплов либо отрицательный код OPUS_*
+        Status status;
+    };
+
+    struct TickReport {
+        size_t jobs = 0;
+        size_t completed = 0;   // успели до дедлайна
+        size_t late = 0;        // закончились после дедлайна
+        size_t missed = 0;      // не начаты до дедлайна
+        double elapsedMs = 0.0;
+    };
+
+    explicit CodecScheduler(size_t threads = 0, int sampleRate = 48000, int channels = 1,
+                            std::function<void(size_t)> threadInit = nullptr);
+
+    // Кодек потока создается при первом обращении (в вызывающем потоке)
+    OpusCodec& codec(uint64_t stream);
+    void removeStream(uint64_t stream);
+
+    // Буферы принадлежат вызывающему и должны жить до конца run().
+    // Результаты доступны через job() до следующего add*()
+    size_t addDecode(uint64_t stream, const unsigned char* packet, int bytes, float* pcm, int maxFrameSize);
+    size_t addEncode(uint64_t stream, const float* pcm, int frameSize, unsigned char* packet, int maxBytes);
+    const Job& job(size_t index) const { return jobs_[index]; }
+
+    // Выполняет добавленные задачи. Задачи, не начатые до дедлайна, пропускаются
+    // (MISSED); уже запущенные дорабатывают (LATE) — состояние Opus не прервать.
+    TickReport run(Clock::time_point deadline);
+
+    size_t getTotalMissed() const { return totalMissed_; }
+    size_t getTotalLate() const { return totalLate_; }
+    size_t getThreadCount() const { return pool_.size(); }
+
+private:
+    struct StreamState {
+        OpusCodec codec;
+        std::vector<size_t> queue;  // индексы задач текущего тика
+    };
+
+    StreamState& stream(uint64_t key);
+    size_t enqueue(const Job& job);
+    void runStream(StreamState& state);
+
+private:
+    int sampleRate_;
+    int channels_;
+
+    std::unordered_map<uint64_t, std::unique_ptr<StreamState>> streams_;
+    std::vector<Job> jobs_;
+    std::vector<StreamState*> active_;
+    bool finished_ = false;
+
+    // Дедлайн текущего run(); публикуется рабочим через submit()
+    Clock::time_point deadline_;
+
+    std::mutex doneMutex_;
+    std::condition_variable done_;
+    size_t remaining_ = 0;
+
+    size_t totalMissed_ = 0;
+    size_t totalLate_ = 0;
+
+    // Последним: потоки пула останавливаются раньше, чем разрушается состояние
+    ThreadPool pool_;
+};
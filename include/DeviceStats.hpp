@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// ==================== DEVICE STATS ====================
+// Xrun и тайминг callback звукового устройства. Пишет только поток
+// callback — relaxed атомики, без блокировок и аллокаций; читать
+// (snapshot/report) можно из любого потока на ходу.
+class DeviceStats {
+public:
+    // Флаги статуса PortAudio (paInputUnderflow ... paPrimingOutput)
+    enum Flag {
+        INPUT_UNDERFLOW,
+        INPUT_OVERFLOW,
+        OUTPUT_UNDERFLOW,
+        OUTPUT_OVERFLOW,
+        PRIMING_OUTPUT,
+        NUM_FLAGS
+    };
+
+    // Время callback в процентах периода буфера: шаг 10%, последняя ячейка — 200% и больше
+    static constexpr int LOAD_BUCKET_PERCENT = 10;
+    static constexpr int LOAD_BUCKETS = 21;
+    // Задержка устройства из timeInfo: шаг 1 мс, последняя ячейка — 100 мс и больше
+    static constexpr int LATENCY_BUCKETS = 101;
+
+    template <size_t N>
+    using Histogram = std::array<uint64_t, N>;
+
+    struct Snapshot {
+        uint64_t callbacks = 0;
+        uint64_t slow_callbacks = 0;          // дольше периода
+        uint32_t max_load_percent = 0;
+        std::array<uint64_t, NUM_FLAGS> flags{};
+        Histogram<LOAD_BUCKETS> load{};
+        Histogram<LATENCY_BUCKETS> input_latency{};
+        Histogram<LATENCY_BUCKETS> output_latency{};
+
+        // Настоящие сбои: priming — штатное заполнение выхода при старте
+        uint64_t xruns() const {
+            return flags[INPUT_UNDERFLOW] + flags[INPUT_OVERFLOW] +
+                   flags[OUTPUT_UNDERFLOW] + flags[OUTPUT_OVERFLOW];
+        }
+    };
+
+    DeviceStats() { reset(); }
+
+    DeviceStats(const DeviceStats&) = delete;
+    DeviceStats& operator=(const DeviceStats&) = delete;
+
+    void record_flag(Flag flag) {
+        flags[flag].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // elapsed и period — в секундах
+    void record_callback(double elapsed, double period) {
+        callbacks.fetch_add(1, std::memory_order_relaxed);
+        if (period <= 0.0) return;
+
+        uint32_t percent = static_cast<uint32_t>(elapsed / period * 100.0);
+        if (percent > 100) {
+            slow_callbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t bucket = std::min<size_t>(percent / LOAD_BUCKET_PERCENT, LOAD_BUCKETS - 1);
+        load[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        uint32_t max = max_load_percent.load(std::memory_order_relaxed);
+        while (percent > max &&
+               !max_load_percent.compare_exchange_weak(max, percent, std::memory_order_relaxed)) {}
+    }
+
+    // Задержки в секундах; 0 — устройство их не сообщает
+    void record_latency(double input, double output) {
+        if (input > 0.0) add_latency(input_latency, input);
+        if (output > 0.0) add_latency(output_latency, output);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.callbacks = callbacks.load(std::memory_order_relaxed);
+        s.slow_callbacks = slow_callbacks.load(std::memory_order_relaxed);
+        s.max_load_percent = max_load_percent.load(std::memory_order_relaxed);
+        for (int i = 0; i < NUM_FLAGS; ++i) s.flags[i] = flags[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < LOAD_BUCKETS; ++i) s.load[i] = load[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+            s.input_latency[i] = input_latency[i].load(std::memory_order_relaxed);
+            s.output_latency[i] = output_latency[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    void reset() {
+        callbacks = 0;
+        slow_callbacks = 0;
+        max_load_percent = 0;
+        for (auto& counter : flags) counter = 0;
+        for (auto& bucket : load) bucket = 0;
+        for (auto& bucket : input_latency) bucket = 0;
+        for (auto& bucket : output_latency) bucket = 0;
+    }
+
+    static const char* flag_name(Flag flag) {
+        switch (flag) {
+            case INPUT_UNDERFLOW: return "input underflow";
+            case INPUT_OVERFLOW: return "input overflow";
+            case OUTPUT_UNDERFLOW: return "output underflow";
+            case OUTPUT_OVERFLOW: return "output overflow";
+            case PRIMING_OUTPUT: return "priming output";
+            default: return "unknown";
+        }
+    }
+
+    // Ячейка, в которую попадает q-квантиль (-1 — пусто)
+    template <size_t N>
+    static int percentile_bucket(const Histogram<N>& histogram, double q) {
+        uint64_t total = 0;
+        for (uint64_t count : histogram) total += count;
+        if (total == 0) return -1;
+
+        uint64_t rank = static_cast<uint64_t>(q * total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < N; ++i) {
+            seen += histogram[i];
+            if (seen > rank) return static_cast<int>(i);
+        }
+        return static_cast<int>(N) - 1;
+    }
+
+    // Многострочный отчет с гистограммами
+    static std::string report(const Snapshot& s, const char* device) {
+        std::string text;
+        char line[256];
+
+        snprintf(line, sizeof(line), "Device %s: %llu callbacks, %llu xruns\n", device,
+                 static_cast<unsigned long long>(s.callbacks), static_cast<unsigned long long>(s.xruns()));
+        text += line;
+        for (int i = 0; i < NUM_FLAGS; ++i) {
+            snprintf(line, sizeof(line), "  %-18s %llu\n", flag_name(static_cast<Flag>(i)),
+                     static_cast<unsigned long long>(s.flags[i]));
+            text += line;
+        }
+
+        int p50 = percentile_bucket(s.load, 0.50);
+        int p99 = percentile_bucket(s.load, 0.99);
+        snprintf(line, sizeof(line),
+                 "  callback / period: p50 <%d%%, p99 <%d%%, max %u%%, %llu over 100%%\n",
+                 (p50 + 1) * LOAD_BUCKET_PERCENT, (p99 + 1) * LOAD_BUCKET_PERCENT, s.max_load_percent,
+                 static_cast<unsigned long long>(s.slow_callbacks));
+        text += line;
+        for (int i = 0; i < LOAD_BUCKETS; ++i) {
+            if (s.load[i] == 0) continue;
+            if (i == LOAD_BUCKETS - 1) {
+                snprintf(line, sizeof(line), "    >=%3d%%     %llu\n", i * LOAD_BUCKET_PERCENT,
+                         static_cast<unsigned long long>(s.load[i]));
+            } else {
+                snprintf(line, sizeof(line), "    %3d-%3d%%  %llu\n", i * LOAD_BUCKET_PERCENT,
+                         (i + 1) * LOAD_BUCKET_PERCENT, static_cast<unsigned long long>(s.load[i]));
+            }
+            text += line;
+        }
+
+        text += latency_line("input latency ", s.input_latency);
+        text += latency_line("output latency", s.output_latency);
+        return text;
+    }
+
+private:
+    using AtomicLatency = std::array<std::atomic<uint64_t>, LATENCY_BUCKETS>;
+
+    static void add_latency(AtomicLatency& histogram, double seconds) {
+        size_t bucket = std::min<size_t>(static_cast<size_t>(seconds * 1000.0), LATENCY_BUCKETS - 1);
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static std::string latency_line(const char* name, const Histogram<LATENCY_BUCKETS>& histogram) {
+        int p50 = percentile_bucket(histogram, 0.50);
+        int p99 = percentile_bucket(histogram, 0.99);
+
+        char line[128];
+        if (p50 < 0) {
+            snprintf(line, sizeof(line), "  %s: not reported by device\n", name);
+        } else {
+            snprintf(line, sizeof(line), "  %s: p50 %d-%d ms, p99 %d-%d ms\n", name,
+                     p50, p50 + 1, p99, p99 + 1);
+        }
+        return line;
+    }
+
+private:
+    std::atomic<uint64_t> callbacks;
+    std::atomic<uint64_t> slow_callbacks;
+    std::atomic<uint32_t> max_load_percent;
+    std::array<std::atomic<uint64_t>, NUM_FLAGS> flags;
+    std::array<std::atomic<uint64_t>, LOAD_BUCKETS> load;
+    AtomicLatency input_latency;
+    AtomicLatency output_latency;
+};
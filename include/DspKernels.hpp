@@ -0,0 +1,226 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+// Общие ядра обработки для NoiseSuppressor/BandSplitter/VoiceProcessor и их
+// специализаций по размеру кадра (FixedNoiseSuppressor/FixedBandSplitter/
+// FixedVoiceProcessor).
+// Все функции inline: при постоянном n циклы разворачиваются и векторизуются.
+namespace dsp {
+
+    // ==================== NOISE SUPPRESSION ====================
+
+    // Окна sqrt-Hann длины 2 * frameSize (шаг frameSize, перекрытие 50%),
+    // хвост до fftSize — нули. Произведение окон — окно Ханна, его копии со
+    // сдвигом frameSize в сумме дают ровно 1, отдельная нормализация не нужна.
+    inline void makeSuppressorWindows(float* analysis, float* synthesis, int fftSize, int frameSize) {
+        const int windowSize = 2 * frameSize;
+
+        for (int i = 0; i < fftSize; ++i) {
+            analysis[i] = (i < windowSize) ? sinf(M_PI * (i + 0.5f) / windowSize) : 0.0f;
+            synthesis[i] = analysis[i];
+        }
+    }
+
+    inline void applyWindow(float* data, const float* window, int n) {
+        for (int i = 0; i < n; ++i) {
+            data[i] *= window[i];
+        }
+    }
+
+    // Винеровский фильтр
+    inline void wienerGains(const std::complex<float>* spectrum, const float* noise, float* gains,
+                            int numBins, float reductionDb, float minGain) {
+        const float suppression = powf(10.0f, -reductionDb / 20.0f);
+
+        for (int i = 0; i < numBins; ++i) {
+            float signalPower = std::norm(spectrum[i]);
+            float wienerGain = signalPower / (signalPower + noise[i] + 1e-10f);
+            wienerGain = std::max(wienerGain, suppression);
+            gains[i] = std::max(sqrtf(wienerGain), minGain);
+        }
+    }
+
+    // Упрощенный MMSE
+    inline void mmseGains(const std::complex<float>* spectrum, const float* noise, float* gains,
+                          int numBins, float reductionDb, float minGain) {
+        const float suppression = powf(10.0f, -reductionDb / 20.0f);
+
+        for (int i = 0; i < numBins; ++i) {
+            float snr = std::norm(spectrum[i]) / (noise[i] + 1e-10f);
+            float mmseGain = std::max(snr / (1.0f + snr), suppression);
+            gains[i] = std::max(sqrtf(mmseGain), minGain);
+        }
+    }
+
+    // Пороговое подавление с кубической интерполяцией
+    inline void spectralGatingGains(const std::complex<float>* spectrum, const float* noise, float* gains,
+                                    int numBins, float reductionDb, float minGain) {
+        const float thresholdScale = powf(10.0f, reductionDb / 20.0f);
+
+        for (int i = 0; i < numBins; ++i) {
+            float magnitude = std::abs(spectrum[i]);
+            float threshold = sqrtf(noise[i]) * thresholdScale;
+
+            float gain = 1.0f;
+            if (magnitude < threshold) {
+                float attenuation = magnitude / (threshold + 1e-10f);
+                gain = attenuation * attenuation * (3.0f - 2.0f * attenuation);
+            }
+            gains[i] = std::max(gain, minGain);
+        }
+    }
+
+    // Сглаживание по частоте (scratch — numBins элементов), затем по времени
+    inline void smoothGains(float* gains, float* previousGains, float* scratch, int numBins,
+                            float timeSmoothing, float freqSmoothing) {
+        if (numBins > 2) {
+            std::copy(gains, gains + numBins, scratch);
+            for (int i = 1; i < numBins - 1; ++i) {
+                scratch[i] = (gains[i-1] + gains[i] + gains[i+1]) / 3.0f;
+            }
+            for (int i = 0; i < numBins; ++i) {
+                gains[i] = freqSmoothing * scratch[i] + (1.0f - freqSmoothing) * gains[i];
+            }
+        }
+
+        for (int i = 0; i < numBins; ++i) {
+            gains[i] = timeSmoothing * previousGains[i] + (1.0f - timeSmoothing) * gains[i];
+            previousGains[i] = gains[i];
+        }
+    }
+
+    inline float meanGain(const float* gains, int first, int last) {
+        float sum = 0.0f;
+        for (int i = first; i < last; ++i) {
+            sum += gains[i];
+        }
+        return sum / (last - first);
+    }
+
+    // ==================== BAND SPLIT ====================
+
+    // ФНЧ для BandSplitter: оконный sinc (Блэкман), единичное усиление на DC.
+    // cutoff — доля частоты дискретизации
+    inline void makeBandSplitTaps(float* taps, int numTaps, float cutoff) {
+        const float center = (numTaps - 1) / 2.0f;
+        float sum = 0.0f;
+
+        for (int k = 0; k < numTaps; ++k) {
+            float t = k - center;
+            float sinc = (t == 0.0f) ? 2.0f * cutoff : sinf(2.0f * M_PI * cutoff * t) / (M_PI * t);
+            float window = 0.42f - 0.5f * cosf(2.0f * M_PI * k / (numTaps - 1)) +
+                           0.08f * cosf(4.0f * M_PI * k / (numTaps - 1));
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+
+        for (int k = 0; k < numTaps; ++k) {
+            taps[k] /= sum;
+        }
+    }
+
+    // Полифазная децимация: считаем только каждый decimation-й выход.
+    // x — текущий кадр, перед ним numTaps - 1 сэмплов истории
+    inline void bandSplitAnalyze(const float* taps, int numTaps, int decimation,
+                                 const float* x, float* lowBand, int lowSize) {
+        for (int m = 0; m < lowSize; ++m) {
+            const float* xn = x + m * decimation;
+            float acc = 0.0f;
+            for (int k = 0; k < numTaps; ++k) {
+                acc += taps[k] * xn[-k];
+            }
+            lowBand[m] = acc;
+        }
+    }
+
+    // out = g * x(n - D) + interp(u), u = low' - g * low: верхняя полоса
+    // отдельно не строится. D — задержка фильтров плюс задержка обработки
+    // нижней полосы; delayed и low выровнены с low' вызывающим кодом.
+    // u — текущие сэмплы нижней полосы, перед ними
+    // numTaps / decimation - 1 сэмплов истории интерполятора
+    inline void bandSplitSynthesize(const float* taps, int numTaps, int decimation,
+                                    const float* u, const float* delayed, float highGain,
+                                    float* output, int frameSize) {
+        const int phaseTaps = numTaps / decimation;
+
+        for (int n = 0; n < frameSize; ++n) {
+            int phase = n % decimation;
+            const float* un = u + n / decimation;
+            float acc = 0.0f;
+            for (int j = 0; j < phaseTaps; ++j) {
+                acc += taps[phase + j * decimation] * un[-j];
+            }
+            output[n] = highGain * delayed[n] + decimation * acc;
+        }
+    }
+
+    // ==================== VOICE PROCESSING ====================
+
+    inline void dcFilter(float* frame, int n, float& dcOffset, float alpha) {
+        for (int i = 0; i < n; ++i) {
+            dcOffset = alpha * dcOffset + (1.0f - alpha) * frame[i];
+            frame[i] -= dcOffset;
+        }
+    }
+
+    inline float rmsDb(const float* frame, int n) {
+        if (n <= 0) return -100.0f;
+
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            sum += frame[i] * frame[i];
+        }
+        return 20.0f * log10f(sqrtf(sum / n) + 1e-10f);
+    }
+
+    inline float peakDb(const float* frame, int n) {
+        if (n <= 0) return -100.0f;
+
+        float peak = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            peak = std::max(peak, std::abs(frame[i]));
+        }
+        return 20.0f * log10f(peak + 1e-10f);
+    }
+
+    // Автогейн: быстрое нарастание, медленный спад
+    inline void autoGain(float* frame, int n, float targetDb, float minGainDb, float maxGainDb,
+                         float& currentGain) {
+        float desiredGainDb = std::clamp(targetDb - rmsDb(frame, n), minGainDb, maxGainDb);
+        float targetGain = powf(10.0f, desiredGainDb / 20.0f);
+        float alpha = (targetGain > currentGain) ? 0.1f : 0.01f;
+
+        currentGain = alpha * targetGain + (1.0f - alpha) * currentGain;
+
+        for (int i = 0; i < n; ++i) {
+            frame[i] *= currentGain;
+        }
+    }
+
+    inline void limiter(float* frame, int n, float& envelope, size_t& clipCount) {
+        const float threshold = 0.9f;
+        const float release = 0.999f;
+
+        for (int i = 0; i < n; ++i) {
+            float absSample = std::abs(frame[i]);
+
+            if (absSample > envelope) {
+                envelope = absSample;
+            } else {
+                envelope = release * envelope + (1.0f - release) * absSample;
+            }
+
+            if (envelope > threshold) {
+                float reduction = threshold / envelope;
+                frame[i] *= reduction;
+
+                if (reduction < 0.99f) {
+                    clipCount++;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+// Акустический эхоподавитель: адаптивный фильтр в частотной области
+// с разбиением на блоки (PBFDAF, overlap-save).
+// Опорный сигнал — то, что ушло в динамики (дальний конец).
+class EchoCanceller {
+public:
+    EchoCanceller(int sampleRate = 48000, int frameSize = 480, int tailMs = 100);
+    ~EchoCanceller() = default;
+
+    // Дальний конец: вызывается из потока воспроизведения
+    void pushReference(const float* samples, size_t count);
+    void pushReference(const int16_t* samples, size_t count);
+
+    // Ближний конец (микрофон): ровно frameSize сэмплов
+    void process(const float* nearEnd, float* out);
+    void process(const int16_t* nearEnd, int16_t* out);
+    std::vector<float> process(const std::vector<float>& frame);
+
+    // Настройки
+    void setStepSize(float mu);
+    void setDoubleTalkThreshold(float threshold);
+    void reset();
+
+    // Статистика
+    float getErleDb() const { return erleDb_; }
+    bool isDoubleTalk() const { return doubleTalkHold_ > 0; }
+    int getFrameSize() const { return blockSize_; }
+
+private:
+    template <typename Sample>
+    void pushReferenceSamples(const Sample* samples, size_t count);
+    template <typename Sample>
+    void processBlock(const Sample* nearEnd, Sample* out);
+
+    void popReference(float* block);
+    void computeFarSpectrum();
+    void estimateEcho(float* echo);
+    void adaptFilter(const float* error);
+    void constrainPartition(int partition);
+    bool detectDoubleTalk(float nearPeak);
+
+    std::complex<float>* farSpectrum(int age);
+    std::complex<float>* weights(int partition) { return &weights_[partition * numBins_]; }
+
+private:
+    int sampleRate_;
+    int blockSize_;
+    int fftSize_;
+    int numBins_;
+    int numPartitions_;
+
+    // Настройки
+    float stepSize_ = 0.5f;
+    float powerSmoothing_ = 0.9f;
+    float regularization_ = 1e-6f;
+    float doubleTalkThreshold_ = 0.5f;   // Geigel: |near| > T * max|far|
+    int doubleTalkHangover_ = 5;         // блоков без адаптации после детекции
+
+    // Дальний конец
+    std::vector<float> farBuffer_;                    // последние fftSize_ сэмплов
+    std::vector<std::complex<float>> farSpectra_;     // numPartitions_ x numBins_
+    std::vector<float> farPeaks_;                     // пик каждого блока истории
+    std::vector<float> farPower_;
+    int head_ = 0;
+
+    // Фильтр
+    std::vector<std::complex<float>> weights_;        // numPartitions_ x numBins_
+    int constraintIndex_ = 0;
+
+    // Рабочие буферы (без аллокаций в process)
+    std::vector<std::complex<float>> work_;
+    std::vector<float> refBlock_;
+    std::vector<float> echo_;
+    std::vector<float> error_;
+
+    // FIFO опорного сигнала между потоками
+    std::vector<float> refRing_;
+    size_t refRead_ = 0;
+    size_t refSize_ = 0;
+    std::mutex refMutex_;
+
+    // Состояние
+    int doubleTalkHold_ = 0;
+
+    // Статистика
+    float erleDb_ = 0.0f;
+    float nearEnergy_ = 0.0f;
+    float errorEnergy_ = 0.0f;
+};
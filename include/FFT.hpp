@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <array>
+#include <cmath>
+#include <utility>
+
+// Общая FFT для DSP модулей (NoiseSuppressor, EchoCanceller)
+namespace dsp {
+
+    // Радикс-2 FFT на месте, размер должен быть степенью двойки.
+    // Обратное преобразование нормализовано на 1/n.
+    void iterativeFFT(std::complex<float>* data, int n, bool inverse = false);
+    void iterativeFFT(std::vector<std::complex<float>>& data, bool inverse = false);
+
+    // Верхняя половина спектра реального сигнала: data[n - i] = conj(data[i])
+    void mirrorSpectrum(std::complex<float>* data, int n);
+
+    // Ближайшая степень двойки >= n
+    constexpr int nextPowerOfTwo(int n) {
+        int size = 1;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // FFT с размером, известным при компиляции: таблицы перестановки и
+    // поворотных множителей считаются один раз в конструкторе (план),
+    // границы циклов — константы.
+    template <int N>
+    class FixedFFT {
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "FixedFFT size must be a power of two");
+
+    public:
+        FixedFFT() {
+            for (int i = 0, j = 0; i < N; ++i) {
+                bitReverse_[i] = j;
+                int bit = N >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+            }
+
+            for (int k = 0; k < N / 2; ++k) {
+                twiddles_[k] = std::polar(1.0f, static_cast<float>(-2.0 * M_PI * k / N));
+            }
+        }
+
+        void forward(std::complex<float>* data) const { transform<false>(data); }
+
+        void inverse(std::complex<float>* data) const {
+            transform<true>(data);
+            for (int i = 0; i < N; ++i) {
+                data[i] *= 1.0f / N;
+            }
+        }
+
+    private:
+        template <bool Inverse>
+        void transform(std::complex<float>* data) const {
+            for (int i = 0; i < N; ++i) {
+                int j = bitReverse_[i];
+                if (i < j) {
+                    std::swap(data[i], data[j]);
+                }
+            }
+
+            for (int len = 2; len <= N; len <<= 1) {
+                const int half = len / 2;
+                const int stride = N / len;
+                for (int i = 0; i < N; i += len) {
+                    for (int j = 0; j < half; ++j) {
+                        std::complex<float> w = twiddles_[j * stride];
+                        if (Inverse) w = std::conj(w);
+
+                        std::complex<float> u = data[i + j];
+                        std::complex<float> v = data[i + j + half] * w;
+                        data[i + j] = u + v;
+                        data[i + j + half] = u - v;
+                    }
+                }
+            }
+        }
+
+        std::array<int, N> bitReverse_;
+        std::array<std::complex<float>, N / 2> twiddles_;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "BandSplitter.hpp"
+#include "DspKernels.hpp"
+#include <algorithm>
+#include <array>
+
+// BandSplitter с размером кадра, известным при компиляции:
+// коэффициенты и истории — std::array, объект хранится по значению.
+// LowBandLatency — задержка обработки нижней полосы в ее сэмплах,
+// как lowBandLatency у BandSplitter.
+template <int FrameSize, int LowBandLatency = 0>
+class FixedBandSplitter {
+    static_assert(FrameSize % BandSplitter::DECIMATION == 0,
+                  "FixedBandSplitter frame size must be a multiple of DECIMATION");
+
+public:
+    static constexpr int TAPS = BandSplitter::TAPS;
+    static constexpr int DECIMATION = BandSplitter::DECIMATION;
+    static constexpr int PHASE_TAPS = BandSplitter::PHASE_TAPS;
+    static constexpr int LOW_BAND_SIZE = FrameSize / DECIMATION;
+    static constexpr int DELAY = BandSplitter::DELAY + DECIMATION * LowBandLatency;
+    static constexpr int HISTORY_SIZE = TAPS - 1 + DECIMATION * LowBandLatency;
+
+    FixedBandSplitter() {
+        dsp::makeBandSplitTaps(taps_.data(), TAPS, BandSplitter::CUTOFF_HZ / BandSplitter::SAMPLE_RATE);
+        reset();
+    }
+
+    // Очистка историй (при повторном включении разделения)
+    void reset() {
+        inputHistory_.fill(0.0f);
+        lowBand_.fill(0.0f);
+        lowHistory_.fill(0.0f);
+    }
+
+    // Анализ: FrameSize сэмплов → LOW_BAND_SIZE сэмплов нижней полосы
+    void analyze(const float* input, float* lowBand) {
+        std::copy(input, input + FrameSize, inputHistory_.begin() + HISTORY_SIZE);
+        dsp::bandSplitAnalyze(taps_.data(), TAPS, DECIMATION, inputHistory_.data() + HISTORY_SIZE,
+                              lowBand, LOW_BAND_SIZE);
+        std::copy(lowBand, lowBand + LOW_BAND_SIZE, lowBand_.begin() + LowBandLatency);
+    }
+
+    // Синтез: строго после analyze() того же кадра
+    void synthesize(const float* lowBand, float highGain, float* output) {
+        float* u = lowHistory_.data() + (PHASE_TAPS - 1);
+        for (int m = 0; m < LOW_BAND_SIZE; ++m) {
+            u[m] = lowBand[m] - highGain * lowBand_[m];
+        }
+
+        dsp::bandSplitSynthesize(taps_.data(), TAPS, DECIMATION, u, inputHistory_.data(), highGain,
+                                 output, FrameSize);
+
+        std::copy(inputHistory_.end() - HISTORY_SIZE, inputHistory_.end(), inputHistory_.begin());
+        std::copy(lowBand_.end() - LowBandLatency, lowBand_.end(), lowBand_.begin());
+        std::copy(lowHistory_.end() - (PHASE_TAPS - 1), lowHistory_.end(), lowHistory_.begin());
+    }
+
+private:
+    std::array<float, TAPS> taps_;
+    std::array<float, HISTORY_SIZE + FrameSize> inputHistory_;
+    std::array<float, LowBandLatency + LOW_BAND_SIZE> lowBand_;
+    std::array<float, PHASE_TAPS - 1 + LOW_BAND_SIZE> lowHistory_;
+};
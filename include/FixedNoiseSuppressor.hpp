@@ -0,0 +1,156 @@
+#pragma once
+
+#include "NoiseSuppressor.hpp"
+#include "FFT.hpp"
+#include "DspKernels.hpp"
+#include <array>
+#include <complex>
+
+// NoiseSuppressor с размером кадра, известным при компиляции:
+// FFT план и все буферы — std::array, в process нет аллокаций.
+template <int FrameSize>
+class FixedNoiseSuppressor {
+public:
+    static constexpr int WINDOW_SIZE = FrameSize * 2;
+    static constexpr int FFT_SIZE = dsp::nextPowerOfTwo(WINDOW_SIZE);
+    static constexpr int NUM_BINS = FFT_SIZE / 2 + 1;
+    static constexpr int OVERLAP_SIZE = FrameSize;
+    // Выход задержан на один кадр, как у NoiseSuppressor
+    static constexpr int LATENCY = FrameSize;
+
+    explicit FixedNoiseSuppressor(int sampleRate = 48000) : sampleRate_(sampleRate) {
+        dsp::makeSuppressorWindows(analysisWindow_.data(), synthesisWindow_.data(),
+                                   FFT_SIZE, FrameSize);
+        noiseEstimate_.fill(1e-6f);
+        previousGains_.fill(1.0f);
+        inputBuffer_.fill(0.0f);
+        overlapBuffer_.fill(0.0f);
+    }
+
+    // Обработка: ровно FrameSize сэмплов
+    void process(const float* frame, float* output) {
+        // 1. Окно анализа (предыдущий кадр + текущий) и FFT
+        std::copy(inputBuffer_.begin() + FrameSize, inputBuffer_.end(), inputBuffer_.begin());
+        std::copy(frame, frame + FrameSize, inputBuffer_.begin() + FrameSize);
+        transformWindow(inputBuffer_.data());
+
+        // 2. Выбор фильтра
+        switch (suppressionType_) {
+            case NoiseSuppressor::WIENER:
+                dsp::wienerGains(spectrum_.data(), noiseEstimate_.data(), gains_.data(), NUM_BINS,
+                                 reductionDb_, minGain_);
+                break;
+            case NoiseSuppressor::MMSE:
+                dsp::mmseGains(spectrum_.data(), noiseEstimate_.data(), gains_.data(), NUM_BINS,
+                               reductionDb_, 0.1f);
+                break;
+            case NoiseSuppressor::SPECTRAL_GATING:
+                dsp::spectralGatingGains(spectrum_.data(), noiseEstimate_.data(), gains_.data(), NUM_BINS,
+                                         reductionDb_, 0.05f);
+                break;
+            default:
+                gains_.fill(1.0f);
+                break;
+        }
+
+        // 3. Сглаживание и применение
+        dsp::smoothGains(gains_.data(), previousGains_.data(), smoothingScratch_.data(), NUM_BINS,
+                         timeSmoothing_, freqSmoothing_);
+
+        for (int i = 0; i < NUM_BINS; ++i) {
+            spectrum_[i] *= gains_[i];
+        }
+        dsp::mirrorSpectrum(spectrum_.data(), FFT_SIZE);
+
+        // 4. Обратное FFT и синтез
+        fft_.inverse(spectrum_.data());
+        for (int i = 0; i < FFT_SIZE; ++i) {
+            frame_[i] = spectrum_[i].real();
+        }
+        dsp::applyWindow(frame_.data(), synthesisWindow_.data(), FFT_SIZE);
+
+        // 5. Overlap-add с шагом в кадр
+        for (int i = 0; i < FrameSize; ++i) {
+            output[i] = overlapBuffer_[i] + frame_[i];
+        }
+        for (int i = 0; i < OVERLAP_SIZE; ++i) {
+            overlapBuffer_[i] = frame_[i + FrameSize];
+        }
+
+        // 6. Статистика
+        float totalSignal = 0.0f, totalNoise = 0.0f;
+        for (int i = 0; i < NUM_BINS; ++i) {
+            totalSignal += std::norm(spectrum_[i]);
+            totalNoise += noiseEstimate_[i];
+        }
+
+        noiseLevelDb_ = 10.0f * log10f(totalNoise / NUM_BINS + 1e-10f);
+        snrDb_ = 10.0f * log10f(totalSignal / NUM_BINS + 1e-10f) - noiseLevelDb_;
+    }
+
+    // Настройки
+    void setSuppressionType(NoiseSuppressor::SuppressionType type) { suppressionType_ = type; }
+    void setReduction(float reductionDb) { reductionDb_ = std::clamp(reductionDb, 6.0f, 30.0f); }
+    void setSmoothing(float timeSmoothing, float freqSmoothing) {
+        timeSmoothing_ = std::clamp(timeSmoothing, 0.9f, 0.999f);
+        freqSmoothing_ = std::clamp(freqSmoothing, 0.3f, 0.9f);
+    }
+
+    // Калибровка
+    // Кадр повторён дважды, чтобы заполнить окно анализа
+    void calibrateNoise(const float* noiseFrame) {
+        std::copy(noiseFrame, noiseFrame + FrameSize, frame_.begin());
+        std::copy(noiseFrame, noiseFrame + FrameSize, frame_.begin() + FrameSize);
+        transformWindow(frame_.data());
+        for (int i = 0; i < NUM_BINS; ++i) {
+            noiseEstimate_[i] = std::norm(spectrum_[i]);
+        }
+    }
+
+    // Статистика
+    float getNoiseLevelDb() const { return noiseLevelDb_; }
+    float getSnrDb() const { return snrDb_; }
+    float getUpperBandGain() const { return dsp::meanGain(previousGains_.data(), NUM_BINS / 2, NUM_BINS); }
+    int getSampleRate() const { return sampleRate_; }
+
+private:
+    // WINDOW_SIZE сэмплов, дополненных нулями до FFT_SIZE
+    void transformWindow(const float* window) {
+        for (int i = 0; i < FFT_SIZE; ++i) {
+            float sample = (i < WINDOW_SIZE) ? window[i] : 0.0f;
+            spectrum_[i] = sample * analysisWindow_[i];
+        }
+        fft_.forward(spectrum_.data());
+    }
+
+private:
+    int sampleRate_;
+    dsp::FixedFFT<FFT_SIZE> fft_;
+
+    // Настройки
+    NoiseSuppressor::SuppressionType suppressionType_ = NoiseSuppressor::MMSE;
+    float reductionDb_ = 15.0f;
+    float timeSmoothing_ = 0.98f;
+    float freqSmoothing_ = 0.7f;
+    float minGain_ = 0.1f;
+
+    // Окна
+    std::array<float, FFT_SIZE> analysisWindow_;
+    std::array<float, FFT_SIZE> synthesisWindow_;
+
+    // Состояние
+    std::array<float, NUM_BINS> noiseEstimate_;
+    std::array<float, NUM_BINS> previousGains_;
+    std::array<float, WINDOW_SIZE> inputBuffer_;
+    std::array<float, OVERLAP_SIZE> overlapBuffer_;
+
+    // Рабочие буферы
+    std::array<std::complex<float>, FFT_SIZE> spectrum_;
+    std::array<float, FFT_SIZE> frame_;
+    std::array<float, NUM_BINS> gains_;
+    std::array<float, NUM_BINS> smoothingScratch_;
+
+    // Статистика
+    float noiseLevelDb_ = -100.0f;
+    float snrDb_ = 0.0f;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "VoiceProcessor.hpp"
+#include "FixedNoiseSuppressor.hpp"
+#include "FixedBandSplitter.hpp"
+#include <array>
+#include <memory>
+
+// VoiceProcessor с размером кадра, известным при компиляции.
+// Специализации для кадров, которые реально используются (120/240/480/960
+// при 48 кГц), собраны в FixedVoiceProcessor.cpp; выбирает их createFrameProcessor().
+template <int FrameSize>
+class FixedVoiceProcessor : public FrameProcessor {
+public:
+    static constexpr int LOW_BAND_SIZE = FixedBandSplitter<FrameSize>::LOW_BAND_SIZE;
+
+    explicit FixedVoiceProcessor(int sampleRate = 48000)
+        : sampleRate_(sampleRate)
+        , suppressor_(sampleRate)
+        , lowBandSuppressor_(sampleRate / BandSplitter::DECIMATION) {
+        setMode(MODE_STANDARD);
+    }
+
+    void process(const float* in, float* out) override {
+        if (in != out) {
+            std::copy(in, in + FrameSize, out);
+        }
+
+        // 1. DC фильтр
+        dsp::dcFilter(out, FrameSize, dcOffset_, dcAlpha_);
+
+        // 2. Измерение входного уровня
+        inputLevelDb_ = dsp::rmsDb(out, FrameSize);
+
+        // 3. Подавление шума
+        if (nsEnabled_) {
+            if (bandSplitEnabled_) {
+                bandSplitter_.analyze(out, lowBand_.data());
+                lowBandSuppressor_.process(lowBand_.data(), lowBand_.data());
+                bandSplitter_.synthesize(lowBand_.data(), lowBandSuppressor_.getUpperBandGain(), out);
+            } else {
+                std::copy(out, out + FrameSize, frame_.begin());
+                suppressor_.process(frame_.data(), out);
+            }
+        }
+
+        // 4. Автогейн
+        if (agcEnabled_) {
+            dsp::autoGain(out, FrameSize, targetLevelDb_, minGainDb_, maxGainDb_, currentGain_);
+        }
+
+        // 5. Лимитер
+        if (limiterEnabled_) {
+            dsp::limiter(out, FrameSize, limiterEnvelope_, clipCount_);
+        }
+
+        // 6. Измерение выходного уровня
+        outputLevelDb_ = dsp::rmsDb(out, FrameSize);
+        peakLevelDb_ = std::max(peakLevelDb_, dsp::peakDb(out, FrameSize));
+    }
+
+    void setMode(ProcessingMode mode) override {
+        mode_ = mode;
+
+        ModeSettings settings = settingsFor(mode);
+        suppressor_.setReduction(settings.reductionDb);
+        suppressor_.setSmoothing(settings.timeSmoothing, settings.freqSmoothing);
+        lowBandSuppressor_.setReduction(settings.reductionDb);
+        lowBandSuppressor_.setSmoothing(settings.timeSmoothing, settings.freqSmoothing);
+        if (settings.setsType) {
+            suppressor_.setSuppressionType(settings.type);
+            lowBandSuppressor_.setSuppressionType(settings.type);
+        }
+    }
+
+    bool enableBandSplit(bool enable) override {
+        if (enable && sampleRate_ != 48000) return false;
+
+        if (enable && !bandSplitEnabled_) {
+            bandSplitter_.reset();
+        }
+        bandSplitEnabled_ = enable;
+        return true;
+    }
+
+    void calibrateNoise(const float* noiseSample) override {
+        if (bandSplitEnabled_) {
+            FixedBandSplitter<FrameSize> splitter;
+            std::array<float, LOW_BAND_SIZE> lowBand;
+            splitter.analyze(noiseSample, lowBand.data());
+            lowBandSuppressor_.calibrateNoise(lowBand.data());
+        } else {
+            suppressor_.calibrateNoise(noiseSample);
+        }
+    }
+
+    void enableNoiseSuppression(bool enable) { nsEnabled_ = enable; }
+    void enableAutoGain(bool enable) { agcEnabled_ = enable; }
+    void enableLimiter(bool enable) { limiterEnabled_ = enable; }
+    void setTargetLevel(float db) { targetLevelDb_ = db; }
+
+    Stats getStats() const override {
+        Stats stats;
+        stats.inputLevelDb = inputLevelDb_;
+        stats.outputLevelDb = outputLevelDb_;
+        stats.noiseLevelDb = bandSplitEnabled_ ? lowBandSuppressor_.getNoiseLevelDb() : suppressor_.getNoiseLevelDb();
+        stats.snrDb = bandSplitEnabled_ ? lowBandSuppressor_.getSnrDb() : suppressor_.getSnrDb();
+        stats.gainAppliedDb = 20.0f * log10f(currentGain_ + 1e-10f);
+        stats.clipping = (clipCount_ > 0);
+        return stats;
+    }
+
+    int getFrameSize() const override { return FrameSize; }
+
+private:
+    int sampleRate_;
+
+    // Компоненты
+    FixedNoiseSuppressor<FrameSize> suppressor_;
+    FixedNoiseSuppressor<LOW_BAND_SIZE> lowBandSuppressor_;
+    // Верхняя полоса ждет подавитель нижней
+    FixedBandSplitter<FrameSize, FixedNoiseSuppressor<LOW_BAND_SIZE>::LATENCY> bandSplitter_;
+    bool bandSplitEnabled_ = false;
+
+    // Рабочие буферы
+    std::array<float, FrameSize> frame_;
+    std::array<float, LOW_BAND_SIZE> lowBand_;
+
+    // Настройки
+    ProcessingMode mode_ = MODE_STANDARD;
+    bool nsEnabled_ = true;
+    bool agcEnabled_ = true;
+    bool limiterEnabled_ = true;
+
+    float targetLevelDb_ = -18.0f;
+    float maxGainDb_ = 20.0f;
+    float minGainDb_ = -10.0f;
+    float currentGain_ = 1.0f;
+
+    // Состояние
+    float inputLevelDb_ = -100.0f;
+    float outputLevelDb_ = -100.0f;
+    float peakLevelDb_ = -100.0f;
+
+    float dcOffset_ = 0.0f;
+    float dcAlpha_ = 0.995f;
+    float limiterEnvelope_ = 0.0f;
+
+    size_t clipCount_ = 0;
+};
+
+extern template class FixedVoiceProcessor<120>;
+extern template class FixedVoiceProcessor<240>;
+extern template class FixedVoiceProcessor<480>;
+extern template class FixedVoiceProcessor<960>;
+
+// Специализация под размер кадра, для остальных размеров — VoiceProcessor
+std::unique_ptr<FrameProcessor> createFrameProcessor(int sampleRate, int frameSize);
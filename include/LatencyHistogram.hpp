@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// ==================== LATENCY HISTOGRAM ====================
+// Гистограмма задержек в духе HDR Histogram: логарифмические октавы,
+// в каждой SUB_BUCKETS линейных ячеек — относительная ошибка не больше
+// 1/SUB_BUCKETS (~3%) на всем диапазоне от наносекунд до минуты.
+// Пишет один поток (load + store без блокировок), снимок читается из любого.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    // 2^36 нс ≈ 69 с — все дольше попадает в последнюю ячейку
+    static constexpr int MAX_MAGNITUDE = 36;
+    static constexpr int BUCKETS = (MAX_MAGNITUDE - SUB_BITS + 2) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{};
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+
+        void merge(const Snapshot& other) {
+            for (int i = 0; i < BUCKETS; ++i) counts[i] += other.counts[i];
+            count += other.count;
+            sum_ns += other.sum_ns;
+            max_ns = std::max(max_ns, other.max_ns);
+        }
+
+        // Прирост с предыдущего снимка того же счетчика. Максимум
+        // интервала — по верхней границе последней непустой ячейки
+        Snapshot since(const Snapshot& previous) const {
+            Snapshot delta = *this;
+            delta.max_ns = 0;
+            for (int i = 0; i < BUCKETS; ++i) {
+                delta.counts[i] -= previous.counts[i];
+                if (delta.counts[i] > 0) delta.max_ns = std::min(upper_bound(i), max_ns);
+            }
+            delta.count -= previous.count;
+            delta.sum_ns -= previous.sum_ns;
+            return delta;
+        }
+
+        // Верхняя граница ячейки q-квантиля, нс (0 — пусто)
+        uint64_t percentile(double q) const {
+            if (count == 0) return 0;
+
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; ++i) {
+                seen += counts[i];
+                if (seen >= rank) return std::min(upper_bound(i), max_ns);
+            }
+            return max_ns;
+        }
+
+        double mean_ns() const { return count > 0 ? static_cast<double>(sum_ns) / count : 0.0; }
+    };
+
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t ns) {
+        bump(counts[index_of(ns)], 1);
+        bump(count, 1);
+        bump(sum_ns, ns);
+        if (ns > max_ns.load(std::memory_order_relaxed)) {
+            max_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (int i = 0; i < BUCKETS; ++i) s.counts[i] = counts[i].load(std::memory_order_relaxed);
+        s.count = count.load(std::memory_order_relaxed);
+        s.sum_ns = sum_ns.load(std::memory_order_relaxed);
+        s.max_ns = max_ns.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Только когда пишущий поток остановлен
+    void reset() {
+        for (auto& bucket : counts) bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        sum_ns.store(0, std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    static int index_of(uint64_t ns) {
+        if (ns < SUB_BUCKETS) return static_cast<int>(ns);
+
+        int magnitude = 63 - __builtin_clzll(ns);
+        if (magnitude > MAX_MAGNITUDE) return BUCKETS - 1;
+
+        // Старшие SUB_BITS + 1 бит: [SUB_BUCKETS, 2 * SUB_BUCKETS)
+        int shift = magnitude - SUB_BITS;
+        int sub = static_cast<int>(ns >> shift);
+        return (shift + 1) * SUB_BUCKETS + (sub - SUB_BUCKETS);
+    }
+
+    static uint64_t lower_bound(int index) {
+        int octave = index / SUB_BUCKETS;
+        uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+        if (octave == 0) return sub;
+        return (SUB_BUCKETS + sub) << (octave - 1);
+    }
+
+    static uint64_t upper_bound(int index) {
+        return index + 1 < BUCKETS ? lower_bound(index + 1) - 1 : UINT64_MAX;
+    }
+
+    // Монотонные наносекунды для меток этапов
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ==================== METRICS ====================
+// Счетчики для мониторинга и их выдача в текстовом формате Prometheus
+// по HTTP (127.0.0.1:порт) или Unix сокету. На горячем пути — только
+// Counter::add; текст собирается в потоке сервера при запросе.
+namespace metrics {
+
+    // Счетчик с одним пишущим потоком: load + store без атомарного
+    // read-modify-write. Читать можно из любого потока
+    class Counter {
+    public:
+        Counter() = default;
+        Counter(const Counter& other) : value(other.get()) {}
+        Counter& operator=(const Counter& other) {
+            value.store(other.get(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void add(uint64_t n = 1) {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value{0};
+    };
+
+    // Текст экспозиции. Строки одной метрики (с разными метками)
+    // добавляются подряд: HELP/TYPE пишутся один раз на имя
+    class Writer {
+    public:
+        // labels — готовый список без фигурных скобок: room="1",client="..."
+        void counter(const std::string& name, const std::string& help, uint64_t value,
+                     const std::string& labels = "");
+        void gauge(const std::string& name, const std::string& help, double value,
+                   const std::string& labels = "");
+        // quantiles — пары (квантиль, значение)
+        void summary(const std::string& name, const std::string& help,
+                     const std::vector<std::pair<double, double>>& quantiles,
+                     double sum, uint64_t count, const std::string& labels = "");
+
+        const std::string& str() const { return text; }
+
+    private:
+        void family(const std::string& name, const std::string& help, const char* type);
+        void sample(const std::string& name, const std::string& labels, const std::string& value);
+
+        std::string text;
+        std::string last_family;
+    };
+
+    // HTTP сервер метрик: на любой GET /metrics отвечает текстом render()
+    class Server {
+    public:
+        using Render = std::function<std::string()>;
+
+        explicit Server(Render render);
+        ~Server() { stop(); }
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        // "9100", "127.0.0.1:9100" или "unix:/run/voice.sock"
+        bool start(const std::string& address);
+        void stop();
+
+    private:
+        void serve_loop();
+        void handle_connection(int fd);
+
+        Render render;
+        int listen_fd = -1;
+        std::string unix_path;
+        std::thread thread;
+        std::atomic<bool> running;
+    };
+}
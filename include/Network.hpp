@@ -5,31 +5,46 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <ctime>
+#include <cstdint>
 #include <cstring>
 #include <string>
-#include <iostream>
 #include <vector>
-#include <thread>
 #include <atomic>
 
+// Пачка датаграмм для одного recvmmsg: буферы выделены заранее
+struct DatagramBatch {
+    static constexpr int CAPACITY = 64;
+    static constexpr size_t MAX_DATAGRAM = 4096;
+
+    int count = 0;
+    unsigned char data[CAPACITY][MAX_DATAGRAM];
+    size_t size[CAPACITY];
+    sockaddr_in from[CAPACITY];
+    int64_t queued_ns[CAPACITY];     // -1 — без метки ядра
+
+    alignas(cmsghdr) char control[CAPACITY][CMSG_SPACE(sizeof(timespec))];
+    iovec iov[CAPACITY];
+    mmsghdr messages[CAPACITY];
+};
+
+// UDP сокет: сервер слушает порт, клиент шлет на адрес сервера
 class Network {
 public:
     Network() : sockfd(-1), running(false) {}
 
     ~Network() { stop(); }
 
-    // Серверный режим (слушаем порт)
     bool start_server(int port) {
         return create_socket("0.0.0.0", port);
     }
 
-    // Клиентский режим (подключаемся к серверу)
     bool start_client(const std::string& server_ip, int port) {
         peer_addr.sin_family = AF_INET;
         peer_addr.sin_port = htons(port);
         inet_pton(AF_INET, server_ip.c_str(), &peer_addr.sin_addr);
 
-        return create_socket("0.0.0.0", 0); // Слушаем на любом порту
+        return create_socket("0.0.0.0", 0);
     }
 
     void stop() {
@@ -40,23 +55,32 @@ public:
         }
     }
 
-    // Отправка данных
-    bool send(const std::vector<unsigned char>& data) {
+    bool send_to(const unsigned char* data, size_t size, const sockaddr_in& addr) {
         if (sockfd == -1) return false;
 
-        socklen_t addr_len = sizeof(peer_addr);
-        int sent = sendto(sockfd, data.data(), data.size(), 0,
-                         (struct sockaddr*)&peer_addr, addr_len);
+        socklen_t addr_len = sizeof(addr);
+        int sent = sendto(sockfd, data, size, 0,
+                         (struct sockaddr*)&addr, addr_len);
 
-        return sent == static_cast<int>(data.size());
+        return sent == static_cast<int>(size);
+    }
+
+    bool send_to(const std::vector<unsigned char>& data, const sockaddr_in& addr) {
+        return send_to(data.data(), data.size(), addr);
+    }
+
+    bool send(const std::vector<unsigned char>& data) {
+        return send_to(data, peer_addr);
     }
 
-    // Получение данных (неблокирующее)
-    bool receive(std::vector<unsigned char>& data) {
+    bool send(const unsigned char* data, size_t size) {
+        return send_to(data, size, peer_addr);
+    }
+
+    bool receive(std::vector<unsigned char>& data, sockaddr_in& from_addr) {
         if (sockfd == -1) return false;
 
         char buffer[4096];
-        sockaddr_in from_addr;
         socklen_t addr_len = sizeof(from_addr);
 
         int received = recvfrom(sockfd, buffer, sizeof(buffer), MSG_DONTWAIT,
@@ -64,16 +88,103 @@ public:
 
         if (received > 0) {
             data.assign(buffer, buffer + received);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Метка времени ядра на каждой принятой датаграмме (SO_TIMESTAMPNS)
+    bool enable_timestamps() {
+        if (sockfd == -1) return false;
 
-            // Автоматически обновляем peer для ответа
-            if (peer_addr.sin_port == 0) {
-                peer_addr = from_addr;
+        int opt = 1;
+        return setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &opt, sizeof(opt)) == 0;
+    }
+
+    // Как receive, плюс сколько датаграмма пролежала в сокете, нс
+    // (-1 — ядро метку не дало: timestamps не включены)
+    bool receive(std::vector<unsigned char>& data, sockaddr_in& from_addr, int64_t& queued_ns) {
+        queued_ns = -1;
+        if (sockfd == -1) return false;
+
+        char buffer[4096];
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+        iovec iov{buffer, sizeof(buffer)};
+        msghdr msg{};
+        msg.msg_name = &from_addr;
+        msg.msg_namelen = sizeof(from_addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t received = recvmsg(sockfd, &msg, MSG_DONTWAIT);
+        if (received <= 0) return false;
+
+        for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec arrived;
+                memcpy(&arrived, CMSG_DATA(c), sizeof(arrived));
+                // Метка ядра — по CLOCK_REALTIME
+                timespec now;
+                clock_gettime(CLOCK_REALTIME, &now);
+                queued_ns = (now.tv_sec - arrived.tv_sec) * 1000000000LL + (now.tv_nsec - arrived.tv_nsec);
+                if (queued_ns < 0) queued_ns = 0;
             }
+        }
 
-            return true;
+        data.assign(buffer, buffer + received);
+        return true;
+    }
+
+    // До CAPACITY датаграмм одним системным вызовом; метки как у receive
+    // с queued_ns. Возвращает batch.count (0 — очередь пуста)
+    int receive_batch(DatagramBatch& batch) {
+        batch.count = 0;
+        if (sockfd == -1) return 0;
+
+        for (int i = 0; i < DatagramBatch::CAPACITY; ++i) {
+            batch.iov[i] = {batch.data[i], DatagramBatch::MAX_DATAGRAM};
+            msghdr& msg = batch.messages[i].msg_hdr;
+            msg = msghdr{};
+            msg.msg_name = &batch.from[i];
+            msg.msg_namelen = sizeof(batch.from[i]);
+            msg.msg_iov = &batch.iov[i];
+            msg.msg_iovlen = 1;
+            msg.msg_control = batch.control[i];
+            msg.msg_controllen = sizeof(batch.control[i]);
         }
 
-        return false;
+        int received = recvmmsg(sockfd, batch.messages, DatagramBatch::CAPACITY, MSG_DONTWAIT, nullptr);
+        if (received <= 0) return 0;
+
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        for (int i = 0; i < received; ++i) {
+            msghdr& msg = batch.messages[i].msg_hdr;
+            batch.size[i] = batch.messages[i].msg_len;
+            batch.queued_ns[i] = -1;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                    timespec arrived;
+                    memcpy(&arrived, CMSG_DATA(c), sizeof(arrived));
+                    int64_t queued = (now.tv_sec - arrived.tv_sec) * 1000000000LL + (now.tv_nsec - arrived.tv_nsec);
+                    batch.queued_ns[i] = queued < 0 ? 0 : queued;
+                }
+            }
+        }
+
+        batch.count = received;
+        return received;
+    }
+
+    // Буферы сокета ядра на прием и передачу
+    void set_buffer_size(int bytes) {
+        if (sockfd == -1) return;
+
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
     }
 
 private:
@@ -81,11 +192,13 @@ private:
         sockfd = socket(AF_INET, SOCK_DGRAM, 0);
         if (sockfd < 0) return false;
 
-        // Неблокирующий режим
         int flags = fcntl(sockfd, F_GETFL, 0);
         fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
 
-        // Биндим сокет
+        // Allow multiple clients to bind to same port
+        int opt = 1;
+        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
         sockaddr_in bind_addr;
         memset(&bind_addr, 0, sizeof(bind_addr));
         bind_addr.sin_family = AF_INET;
@@ -18,7 +18,10 @@ public:
     NoiseSuppressor(int sampleRate = 48000, int frameSize = 960);
     ~NoiseSuppressor() = default;
 
-    // Обработка
+    // Обработка. Выход задержан на один кадр (frameSize отсчётов):
+    // 50% overlap-add отдаёт кадр только после прихода следующего.
+    // Кто смешивает выход с необработанным сигналом, должен задержать
+    // его на getLatency().
     std::vector<float> process(const std::vector<float>& frame);
 
     // Настройки
@@ -32,6 +35,11 @@ public:
     // Получение статистики
     float getNoiseLevelDb() const { return noiseLevelDb_; }
     float getSnrDb() const { return snrDb_; }
+    int getLatency() const { return frameSize_; }
+
+    // Среднее сглаженное усиление верхней половины спектра
+    // (для дешёвой обработки верхней полосы при разделении на полосы)
+    float getUpperBandGain() const;
 
 private:
     // Методы подавления
@@ -67,8 +75,12 @@ private:
     // Состояние
     std::vector<float> noiseEstimate_;
     std::vector<float> previousGains_;
+    std::vector<float> smoothingScratch_;
+
+    // Анализ: предыдущий и текущий кадр (2 * frameSize)
+    std::vector<float> inputBuffer_;
 
-    // Overlap-add
+    // Overlap-add: вторая половина прошлого окна синтеза
     std::vector<float> overlapBuffer_;
     int overlapSize_;
 
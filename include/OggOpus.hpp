@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Запись готовых пакетов Opus в Ogg Opus (RFC 7845) без перекодирования.
+// Гранула считается по media timestamp пакетов (сэмплы 48 кГц):
+// пропуски заполняются пакетами из одного TOC байта — декодер
+// восстановит их как потерянные кадры.
+class OggOpusWriter {
+public:
+    // Данных на странице до сброса: ~1 с звука
+    static constexpr uint64_t PAGE_DURATION = 48000;
+    // Дольше — разрыв не заполняется, запись продолжается встык
+    static constexpr uint32_t MAX_GAP = 48000 * 60;
+
+    OggOpusWriter() = default;
+    ~OggOpusWriter() { close(); }
+
+    OggOpusWriter(const OggOpusWriter&) = delete;
+    OggOpusWriter& operator=(const OggOpusWriter&) = delete;
+
+    // comments — строки вида "KEY=value" для OpusTags
+    bool open(const std::string& path, uint32_t serial, int channels,
+              const std::vector<std::string>& comments = {});
+    // Последняя страница с флагом EOS
+    void close();
+
+    // false — пакет отброшен (битый, опоздавший или повтор)
+    bool write(const unsigned char* packet, int bytes, uint32_t timestamp);
+    // Сбросить накопленные страницы в файл
+    void flush();
+
+    bool isOpen() const { return file_ != nullptr; }
+    uint64_t getGranule() const { return granule_; }
+
+private:
+    void appendPacket(const unsigned char* packet, int bytes, int samples);
+    void writePage(uint8_t flags);
+
+private:
+    FILE* file_ = nullptr;
+    uint32_t serial_ = 0;
+    uint32_t pageSequence_ = 0;
+
+    bool started_ = false;
+    uint32_t nextTimestamp_ = 0;
+    uint64_t granule_ = 0;
+
+    // Текущая страница: таблица сегментов и данные
+    std::vector<uint8_t> segments_;
+    std::vector<unsigned char> body_;
+    uint64_t pageStartGranule_ = 0;
+
+    // Готовые страницы до flush()
+    std::vector<unsigned char> output_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+struct OpusRepacketizer;
+
+// Склейка нескольких кадров Opus в один пакет (repacketizer) и обратно.
+// Меньше датаграмм — меньше накладных расходов IP/UDP/заголовка
+// и нагрузки на ретранслятор, ценой (N-1) кадров задержки.
+class OpusBundler {
+public:
+    static constexpr int MAX_FRAMES = 6;
+    // Пакет Opus с одним кадром занимает не больше 1276 байт
+    static constexpr int MAX_FRAME_BYTES = 1276;
+
+    OpusBundler();
+    ~OpusBundler();
+
+    OpusBundler(const OpusBundler&) = delete;
+    OpusBundler& operator=(const OpusBundler&) = delete;
+
+    // Добавить пакет; false — не совместим с накопленными или места нет
+    bool add(const unsigned char* packet, int bytes);
+    int getFrameCount() const { return count_; }
+
+    // Собрать накопленное в один пакет и начать заново.
+    // Возвращает размер пакета либо отрицательный код OPUS_*
+    int flush(unsigned char* out, int maxBytes);
+
+    // Разбить пакет на однокадровые пакеты, записанные подряд в out;
+    // frameBytes[i] — размер i-го. Возвращает число кадров либо код OPUS_*
+    int split(const unsigned char* packet, int bytes, unsigned char* out, int maxBytes,
+              int* frameBytes, int maxFrames);
+
+private:
+    OpusRepacketizer* bundle_;
+    OpusRepacketizer* splitter_;
+
+    // Repacketizer хранит указатели на кадры — держим копии до flush()
+    std::array<unsigned char, MAX_FRAMES * MAX_FRAME_BYTES> storage_;
+    int used_ = 0;
+    int count_ = 0;
+};
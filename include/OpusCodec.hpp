@@ -1,22 +1,51 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 struct OpusEncoder;
 struct OpusDecoder;
 
-class OpusCodec {
+// Sample: float (opus_*_float) или int16_t (нативные opus_encode/opus_decode)
+template <typename Sample>
+class BasicOpusCodec {
 public:
-    OpusCodec();
-    ~OpusCodec();
+    // Рекомендованный libopus размер буфера пакета
+    static constexpr int MAX_PACKET_SIZE = 4000;
+    // Самый длинный кадр Opus — 120 мс
+    static constexpr int MAX_FRAME_MS = 120;
+
+    BasicOpusCodec();
+    ~BasicOpusCodec();
 
     bool init(int sampleRate = 48000, int channels = 1);
-    std::vector<unsigned char> encode(const std::vector<float>& pcm);
-    std::vector<float> decode(const std::vector<unsigned char>& encoded);
+    int setBitrate(int bitsPerSecond);
+
+    // Без аллокаций: буферы принадлежат вызывающему.
+    // Возвращают число байт / сэмплов на канал либо отрицательный код OPUS_*
+    int encode(const Sample* pcm, int frameSize, unsigned char* packet, int maxBytes);
+    int decode(const unsigned char* packet, int bytes, Sample* pcm, int maxFrameSize);
+
+    std::vector<unsigned char> encode(const std::vector<Sample>& pcm);
+    std::vector<Sample> decode(const std::vector<unsigned char>& encoded);
+
+    // Сэмплов на канал в кадре 120 мс при текущей частоте
+    int getMaxFrameSize() const { return sampleRate * MAX_FRAME_MS / 1000; }
+    static const char* errorString(int status);
 
 private:
     OpusEncoder* encoder;
     OpusDecoder* decoder;
     int sampleRate;
     int channels;
+
+    // Промежуточные буферы векторных перегрузок, выделяются в init()
+    std::vector<unsigned char> packetBuffer;
+    std::vector<Sample> pcmBuffer;
 };
+
+extern template class BasicOpusCodec<float>;
+extern template class BasicOpusCodec<int16_t>;
+
+using OpusCodec = BasicOpusCodec<float>;
+using OpusCodec16 = BasicOpusCodec<int16_t>;
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <opus/opus.h>
+#include <cstdint>
+
+// Перегрузки Opus по типу сэмпла: float → *_float, int16 → нативные вызовы
+inline opus_int32 opusEncode(OpusEncoder* encoder, const float* pcm, int frameSize,
+                             unsigned char* data, opus_int32 maxBytes) {
+    return opus_encode_float(encoder, pcm, frameSize, data, maxBytes);
+}
+
+inline opus_int32 opusEncode(OpusEncoder* encoder, const int16_t* pcm, int frameSize,
+                             unsigned char* data, opus_int32 maxBytes) {
+    return opus_encode(encoder, pcm, frameSize, data, maxBytes);
+}
+
+inline int opusDecode(OpusDecoder* decoder, const unsigned char* data, opus_int32 len,
+                      float* pcm, int frameSize, int decodeFec) {
+    return opus_decode_float(decoder, data, len, pcm, frameSize, decodeFec);
+}
+
+inline int opusDecode(OpusDecoder* decoder, const unsigned char* data, opus_int32 len,
+                      int16_t* pcm, int frameSize, int decodeFec) {
+    return opus_decode(decoder, data, len, pcm, frameSize, decodeFec);
+}
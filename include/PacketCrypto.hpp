@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+struct evp_cipher_ctx_st;
+
+// ==================== PACKET CRYPTO ====================
+// AEAD пакетов: AES-GCM из libcrypto (OpenSSL сам берет AES-NI и PCLMULQDQ).
+// Ключ общий для сессии (всех клиентов и ретрансляторов), 128 или 256 бит.
+//
+// Зашифрованный пакет:
+//   [заголовок 16, type | PACKET_ENCRYPTED][u32 salt][шифротекст][тег 16]
+// Заголовок и salt — AAD: их нельзя подменить. Nonce — salt, ssrc и
+// sequence; тип и уровень подмешаны в salt, так что пакеты разных типов
+// и уровни, перекодированные ретранслятором, nonce не делят. Salt каждый
+// отправитель выбирает случайно при старте: номера пакетов после
+// перезапуска повторяются, nonce — нет.
+//
+// Контексты шифра создаются один раз: на пакет меняется только IV, без
+// расписания ключа и выделений памяти. Экземпляр — на один поток.
+class PacketCrypto {
+public:
+    static constexpr size_t SALT_SIZE = 4;
+    static constexpr size_t TAG_SIZE = 16;
+    // На столько зашифрованный пакет длиннее открытого
+    static constexpr size_t OVERHEAD = SALT_SIZE + TAG_SIZE;
+
+    PacketCrypto();
+    ~PacketCrypto();
+
+    PacketCrypto(const PacketCrypto&) = delete;
+    PacketCrypto& operator=(const PacketCrypto&) = delete;
+
+    // 32 или 64 шестнадцатеричных символа: AES-128 или AES-256
+    bool set_key_hex(const std::string& hex);
+    bool set_key(const unsigned char* key, size_t size);
+    bool enabled() const { return key_bits > 0; }
+    int bits() const { return key_bits; }
+
+    // Открытый пакет (заголовок и нагрузка) -> зашифрованный в out, в out
+    // должно поместиться size + OVERHEAD. Возвращает размер, 0 — ошибка
+    size_t seal(const unsigned char* packet, size_t size, uint32_t salt, unsigned char* out);
+
+    // Проверка и расшифровка: в out — заголовок без флага и открытая
+    // нагрузка (out вмещает size). 0 — пакет не прошел проверку
+    size_t open(const unsigned char* packet, size_t size, unsigned char* out, uint32_t* salt = nullptr);
+
+    // Случайный salt отправителя
+    static uint32_t random_salt();
+
+private:
+    void make_nonce(const unsigned char* header, uint32_t salt, unsigned char* nonce) const;
+
+    evp_cipher_ctx_st* encrypt_ctx;
+    evp_cipher_ctx_st* decrypt_ctx;
+    int key_bits = 0;
+};
+
+// Окно защиты от повторов, как в SRTP и IPsec: номер новее последнего
+// или один из 64 предыдущих, еще не виденный. Обновлять — только после
+// проверки тега, иначе подделка сдвинет окно
+class ReplayWindow {
+public:
+    static constexpr uint32_t SIZE = 64;
+
+    // true — номер принят и запомнен; повтор или слишком старый — false
+    bool accept(uint32_t sequence);
+
+private:
+    bool started = false;
+    uint32_t highest = 0;
+    uint64_t seen = 0;       // бит i — highest - i
+};
+
+// Окна по потокам: поток — (salt, ssrc, тип, уровень). Потоки заводят
+// только пакеты с верным тегом; старые вытесняются по давности
+class ReplayFilter {
+public:
+    static constexpr size_t MAX_STREAMS = 65536;
+
+    bool accept(const protocol::PacketHeader& header, uint32_t salt);
+    size_t streams() const { return windows.size(); }
+
+private:
+    struct Stream {
+        uint32_t salt;
+        uint32_t ssrc;
+        uint8_t type;
+        uint8_t tier;
+
+        bool operator==(const Stream& other) const {
+            return salt == other.salt && ssrc == other.ssrc && type == other.type && tier == other.tier;
+        }
+    };
+
+    struct StreamHash {
+        size_t operator()(const Stream& stream) const {
+            uint64_t key = (uint64_t(stream.salt) << 32) | stream.ssrc;
+            key ^= (uint64_t(stream.type) << 8 | stream.tier) * 0x9E3779B97F4A7C15ull;
+            return std::hash<uint64_t>()(key);
+        }
+    };
+
+    struct Entry {
+        ReplayWindow window;
+        uint64_t last_used = 0;
+    };
+
+    std::unordered_map<Stream, Entry, StreamHash> windows;
+    uint64_t clock = 0;
+};
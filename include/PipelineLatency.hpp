@@ -0,0 +1,68 @@
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "Metrics.hpp"
+#include <array>
+#include <memory>
+#include <string>
+
+// ==================== PIPELINE LATENCY ====================
+// Задержка по этапам тракта: захват -> обработка -> кодирование -> отправка,
+// прием -> пересылка на ретрансляторе, прием -> декодирование ->
+// джиттер-буфер -> воспроизведение. Каждый этап пишет ровно один поток
+// (указан у этапа), поэтому запись — без блокировок. Снимки сводятся
+// при экспорте метрик и в отчете за интервал.
+class PipelineLatency {
+public:
+    enum Stage {
+        // Клиент, поток звука
+        CAPTURE_PROCESS,     // вход callback -> после эхоподавителя
+        ENCODE,              // кодирование кадра
+        // Клиент, сетевой поток
+        SEND_QUEUE,          // закодирован -> отправлен (очередь и склейка пачки)
+        CAPTURE_TO_SEND,     // вход callback -> датаграмма ушла
+        RECEIVE_WAIT,        // пришла в сокет (метка ядра) -> прочитана
+        DECODE,              // прочитана -> кадр декодирован и в очереди
+        // Клиент, поток звука
+        JITTER_BUFFER,       // в очереди -> начал звучать
+        RECEIVE_TO_PLAYOUT,  // пришла в сокет -> начала звучать
+        // Ретранслятор, сетевой поток
+        RELAY_SOCKET_WAIT,   // пришла в сокет -> прочитана
+        RELAY_FORWARD,       // прочитана -> разослана всем слушателям без перекодирования
+        RELAY_TRANSCODE,     // прочитана -> перекодированная разослана
+        NUM_STAGES
+    };
+
+    using Snapshots = std::array<LatencyHistogram::Snapshot, NUM_STAGES>;
+
+    PipelineLatency();
+
+    PipelineLatency(const PipelineLatency&) = delete;
+    PipelineLatency& operator=(const PipelineLatency&) = delete;
+
+    void record(Stage stage, uint64_t ns) { stages[stage].record(ns); }
+
+    // От метки start (LatencyHistogram::now_ns) до сейчас; 0 — метки нет
+    void record_since(Stage stage, uint64_t start_ns) {
+        if (start_ns == 0) return;
+        uint64_t now = LatencyHistogram::now_ns();
+        stages[stage].record(now > start_ns ? now - start_ns : 0);
+    }
+
+    std::unique_ptr<Snapshots> snapshot() const;
+
+    static const char* stage_name(Stage stage);
+
+    // Сводка (summary) на этап: квантили за все время, сумма и число
+    void write_metrics(metrics::Writer& out) const;
+
+    // Таблица по этапам с прошлого вызова (только для одного потока-читателя)
+    std::string interval_report();
+
+private:
+    std::array<LatencyHistogram, NUM_STAGES> stages;
+
+    // Снимок прошлого отчета и его время
+    std::unique_ptr<Snapshots> last_report;
+    uint64_t last_report_ns = 0;
+};
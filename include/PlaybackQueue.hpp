@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+// ==================== PLAYBACK QUEUE ====================
+// Передача декодированных кадров из сетевого потока в callback звука.
+// Сеть кладет кадры целиком, callback забирает ровно период; остаток
+// кадра остается в голове очереди до следующего периода.
+template <typename Sample>
+class PlaybackQueue {
+public:
+    // Метки кадра (LatencyHistogram::now_ns, 0 — нет): когда пакет
+    // пришел в сокет и когда кадр встал в очередь
+    struct Timing {
+        uint64_t arrived_ns = 0;
+        uint64_t queued_ns = 0;
+    };
+
+    // max_frames > 0: очередь глубже — отбрасываем самое старое,
+    // чтобы не копить задержку. Возвращает число отброшенных кадров
+    size_t push(std::vector<Sample> frame, size_t max_frames, Timing timing = Timing()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.push(Entry{std::move(frame), timing, false});
+
+        size_t dropped = 0;
+        while (max_frames > 0 && frames.size() > max_frames) {
+            frames.pop();
+            dropped++;
+        }
+        return dropped;
+    }
+
+    // Заполнить out целиком; чего нет — тишина.
+    // Возвращает число сэмплов из очереди (меньше frame_count — недобор).
+    // started: метки кадра, который начал звучать в этом периоде
+    // (не изменяется, если новый кадр не начался)
+    size_t fill(Sample* out, unsigned long frame_count, Timing* started = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!frames.empty()) {
+            Entry& entry = frames.front();
+            auto& data = entry.samples;
+            size_t to_copy = std::min(data.size(), static_cast<size_t>(frame_count));
+
+            memcpy(out, data.data(), to_copy * sizeof(Sample));
+
+            if (!entry.started) {
+                entry.started = true;
+                if (started) *started = entry.timing;
+            }
+
+            if (to_copy == data.size()) {
+                frames.pop();
+            } else {
+                data = std::vector<Sample>(data.begin() + to_copy, data.end());
+            }
+
+            if (to_copy < frame_count) {
+                memset(out + to_copy, 0, (frame_count - to_copy) * sizeof(Sample));
+            }
+            return to_copy;
+        }
+
+        memset(out, 0, frame_count * sizeof(Sample));
+        return 0;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!frames.empty()) frames.pop();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames.size();
+    }
+
+private:
+    struct Entry {
+        std::vector<Sample> samples;
+        Timing timing;
+        bool started;
+    };
+
+    std::queue<Entry> frames;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "AudioBackend.hpp"
+#include <portaudio.h>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <type_traits>
+
+// ==================== PORTAUDIO BACKEND ====================
+// Один полнодуплексный поток PortAudio: вход и выход одного периода
+// приходят в один callback, поэтому захват и воспроизведение выровнены
+// по сэмплам (это нужно эхоподавителю) и на один буфер устройства меньше.
+// Pa_Initialize/Pa_Terminate — только здесь, парой на open/close.
+template <typename Sample>
+class PortAudioBackend : public AudioBackend<Sample> {
+public:
+    static constexpr PaSampleFormat SAMPLE_FORMAT =
+        std::is_same<Sample, int16_t>::value ? paInt16 : paFloat32;
+
+    using typename AudioBackend<Sample>::Callback;
+
+    PortAudioBackend() = default;
+    ~PortAudioBackend() override { close(); }
+
+    PortAudioBackend(const PortAudioBackend&) = delete;
+    PortAudioBackend& operator=(const PortAudioBackend&) = delete;
+
+    // low_latency: минимальная задержка устройства вместо потока по умолчанию
+    bool open(int sample_rate, int frame_size, int channels,
+              bool low_latency, Callback cb) override {
+        close();
+        callback = std::move(cb);
+        stream_rate = sample_rate;
+        this->device_stats.reset();
+
+        if (Pa_Initialize() != paNoError) return false;
+        pa_initialized = true;
+
+        PaError err;
+        if (!low_latency) {
+            err = Pa_OpenDefaultStream(&stream, channels, channels, SAMPLE_FORMAT,
+                                       sample_rate, frame_size, pa_callback, this);
+        } else {
+            PaStreamParameters in_params, out_params;
+            if (!make_params(in_params, true, channels) || !make_params(out_params, false, channels)) {
+                close();
+                return false;
+            }
+
+            err = Pa_OpenStream(&stream, &in_params, &out_params,
+                                sample_rate, frame_size, paNoFlag, pa_callback, this);
+        }
+
+        if (err != paNoError) {
+            stream = nullptr;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool start() override { return stream && Pa_StartStream(stream) == paNoError; }
+
+    void stop() override {
+        if (stream) Pa_StopStream(stream);
+    }
+
+    void close() override {
+        if (stream) {
+            Pa_StopStream(stream);
+            Pa_CloseStream(stream);
+            stream = nullptr;
+        }
+        if (pa_initialized) {
+            Pa_Terminate();
+            pa_initialized = false;
+        }
+    }
+
+    bool is_open() const override { return stream != nullptr; }
+    const char* name() const override { return "portaudio"; }
+
+private:
+    static bool make_params(PaStreamParameters& params, bool input, int channels) {
+        memset(&params, 0, sizeof(params));
+        params.device = input ? Pa_GetDefaultInputDevice() : Pa_GetDefaultOutputDevice();
+        if (params.device == paNoDevice) return false;
+
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(params.device);
+        if (!info) return false;
+
+        params.channelCount = channels;
+        params.sampleFormat = SAMPLE_FORMAT;
+        params.suggestedLatency = input ? info->defaultLowInputLatency : info->defaultLowOutputLatency;
+        return true;
+    }
+
+    static int pa_callback(const void* input, void* output, unsigned long frame_count,
+                           const PaStreamCallbackTimeInfo* time_info, PaStreamCallbackFlags flags,
+                           void* user_data) {
+        auto started = std::chrono::steady_clock::now();
+
+        PortAudioBackend* self = static_cast<PortAudioBackend*>(user_data);
+        self->record_status(time_info, flags);
+
+        Sample* out = static_cast<Sample*>(output);
+        if (!out) return paContinue;
+
+        if (self->callback) {
+            self->callback(static_cast<const Sample*>(input), out, frame_count);
+        } else {
+            memset(out, 0, frame_count * sizeof(Sample));
+        }
+
+        // Период — по фактическому числу кадров: PortAudio может его менять
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        self->device_stats.record_callback(elapsed.count(),
+                                           static_cast<double>(frame_count) / self->stream_rate);
+        return paContinue;
+    }
+
+    void record_status(const PaStreamCallbackTimeInfo* time_info, PaStreamCallbackFlags flags) {
+        static constexpr PaStreamCallbackFlags FLAG_BITS[DeviceStats::NUM_FLAGS] = {
+            paInputUnderflow, paInputOverflow, paOutputUnderflow, paOutputOverflow, paPrimingOutput
+        };
+        for (int i = 0; i < DeviceStats::NUM_FLAGS; ++i) {
+            if (flags & FLAG_BITS[i]) {
+                this->device_stats.record_flag(static_cast<DeviceStats::Flag>(i));
+            }
+        }
+
+        // Времена в секундах потоковых часов: АЦП раньше текущего, ЦАП позже
+        if (time_info && time_info->currentTime > 0.0) {
+            double input_latency = time_info->inputBufferAdcTime > 0.0
+                ? time_info->currentTime - time_info->inputBufferAdcTime : 0.0;
+            double output_latency = time_info->outputBufferDacTime > 0.0
+                ? time_info->outputBufferDacTime - time_info->currentTime : 0.0;
+            this->device_stats.record_latency(input_latency, output_latency);
+        }
+    }
+
+private:
+    PaStream* stream = nullptr;
+    bool pa_initialized = false;
+    int stream_rate = 48000;
+    Callback callback;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+// ==================== WIRE FORMAT ====================
+// Заголовок пакета, 16 байт, сетевой порядок байт:
+//   [u8 type][u8 tier][u16 room][u32 ssrc][u32 sequence][u32 timestamp]
+// AUDIO:           за заголовком — пакет Opus
+// RECEIVER_REPORT: за заголовком — [u16 loss_permille][u16 reserved]
+// TRUNK_ROOMS:     ретранслятор соседу: комнаты, где у него есть слушатели,
+//                  [u16 part][u16 parts][u16 room]...; sequence — номер
+//                  объявления, длинный список — несколькими частями
+// TRUNK_AUDIO:     ретранслятор соседу: за заголовком — пакет говорящего,
+//                  как пришел (с ключом — запечатанный говорящим); ssrc —
+//                  идентификатор узла-отправителя, sequence — номер в транке
+// Старший бит type — пакет зашифрован (формат — PacketCrypto.hpp)
+namespace protocol {
+
+    constexpr size_t HEADER_SIZE = 16;
+    constexpr size_t REPORT_SIZE = 4;
+    constexpr size_t ANNOUNCEMENT_HEADER_SIZE = 4;
+    // Комнат в одной части: датаграмма не длиннее типичного MTU
+    constexpr size_t ANNOUNCEMENT_MAX_ROOMS = (1200 - HEADER_SIZE - ANNOUNCEMENT_HEADER_SIZE) / 2;
+
+    enum PacketType : uint8_t {
+        PACKET_AUDIO = 1,
+        PACKET_RECEIVER_REPORT = 2,
+        PACKET_TRUNK_ROOMS = 3,
+        PACKET_TRUNK_AUDIO = 4
+    };
+
+    constexpr uint8_t PACKET_ENCRYPTED = 0x80;
+
+    struct PacketHeader {
+        uint8_t type = PACKET_AUDIO;
+        uint8_t tier = 0;            // уровень битрейта, 0 — исходный поток говорящего
+        uint16_t room = 0;           // комната ретранслятора, 0 — общая
+        uint32_t ssrc = 0;           // идентификатор отправителя
+        uint32_t sequence = 0;
+        uint32_t timestamp = 0;      // в сэмплах
+    };
+
+    struct ReceiverReport {
+        uint16_t loss_permille = 0;  // потери за интервал отчета, ‰
+    };
+
+    // Часть объявления комнат; rooms указывает в принятый пакет
+    struct RoomAnnouncement {
+        uint16_t part = 0;
+        uint16_t parts = 1;
+        const unsigned char* rooms = nullptr;
+        size_t room_count = 0;
+
+        uint16_t room(size_t i) const;
+    };
+
+    inline void put_u16(unsigned char* out, uint16_t value) {
+        value = htons(value);
+        memcpy(out, &value, sizeof(value));
+    }
+
+    inline void put_u32(unsigned char* out, uint32_t value) {
+        value = htonl(value);
+        memcpy(out, &value, sizeof(value));
+    }
+
+    inline uint16_t get_u16(const unsigned char* in) {
+        uint16_t value;
+        memcpy(&value, in, sizeof(value));
+        return ntohs(value);
+    }
+
+    inline uint32_t get_u32(const unsigned char* in) {
+        uint32_t value;
+        memcpy(&value, in, sizeof(value));
+        return ntohl(value);
+    }
+
+    inline void write_header(unsigned char* out, const PacketHeader& header) {
+        out[0] = header.type;
+        out[1] = header.tier;
+        put_u16(out + 2, header.room);
+        put_u32(out + 4, header.ssrc);
+        put_u32(out + 8, header.sequence);
+        put_u32(out + 12, header.timestamp);
+    }
+
+    inline bool read_header(const unsigned char* data, size_t size, PacketHeader& header) {
+        if (size < HEADER_SIZE) return false;
+
+        header.type = data[0];
+        header.tier = data[1];
+        header.room = get_u16(data + 2);
+        header.ssrc = get_u32(data + 4);
+        header.sequence = get_u32(data + 8);
+        header.timestamp = get_u32(data + 12);
+        return true;
+    }
+
+    inline void write_report(unsigned char* out, const ReceiverReport& report) {
+        put_u16(out, report.loss_permille);
+        put_u16(out + 2, 0);
+    }
+
+    inline bool read_report(const unsigned char* data, size_t size, ReceiverReport& report) {
+        if (size < REPORT_SIZE) return false;
+
+        report.loss_permille = get_u16(data);
+        return true;
+    }
+
+    // Возвращает размер части; rooms — не больше ANNOUNCEMENT_MAX_ROOMS
+    inline size_t write_announcement(unsigned char* out, uint16_t part, uint16_t parts,
+                                     const uint16_t* rooms, size_t count) {
+        put_u16(out, part);
+        put_u16(out + 2, parts);
+        for (size_t i = 0; i < count; ++i) {
+            put_u16(out + ANNOUNCEMENT_HEADER_SIZE + 2 * i, rooms[i]);
+        }
+        return ANNOUNCEMENT_HEADER_SIZE + 2 * count;
+    }
+
+    inline bool read_announcement(const unsigned char* data, size_t size, RoomAnnouncement& announcement) {
+        if (size < ANNOUNCEMENT_HEADER_SIZE || (size - ANNOUNCEMENT_HEADER_SIZE) % 2 != 0) return false;
+
+        announcement.part = get_u16(data);
+        announcement.parts = get_u16(data + 2);
+        announcement.rooms = data + ANNOUNCEMENT_HEADER_SIZE;
+        announcement.room_count = (size - ANNOUNCEMENT_HEADER_SIZE) / 2;
+        return announcement.parts > 0 && announcement.part < announcement.parts;
+    }
+
+    inline uint16_t RoomAnnouncement::room(size_t i) const {
+        return get_u16(rooms + 2 * i);
+    }
+}
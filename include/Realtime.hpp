@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sched.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// ==================== REAL-TIME ====================
+// Приоритет реального времени, привязка к ядрам и блокировка памяти.
+// Все по желанию: без прав (нет CAP_SYS_NICE / RLIMIT_RTPRIO / RLIMIT_MEMLOCK)
+// настройка откатывается к тому, что разрешено, и это попадает в отчет.
+namespace realtime {
+
+    // Настройка для одной роли потоков
+    struct ThreadPolicy {
+        int policy = SCHED_OTHER;    // SCHED_FIFO, SCHED_RR или SCHED_OTHER
+        int priority = 0;            // 1-99 для FIFO/RR
+        std::vector<int> cpus;       // пусто — без привязки
+
+        bool configured() const { return policy != SCHED_OTHER || !cpus.empty(); }
+    };
+
+    struct Config {
+        ThreadPolicy audio;     // callback звука: DSP, AEC, кодер
+        ThreadPolicy network;   // сетевые потоки клиента и ретранслятора
+        ThreadPolicy codec;     // рабочие потоки перекодирования на сервере
+        bool lock_memory = false;
+
+        // Значения по умолчанию для --rt: звук выше сети, сеть выше кодеков
+        static Config defaults();
+    };
+
+    // "fifo:80@2,3", "rr:50", "other@0-3"
+    bool parse_policy(const std::string& spec, ThreadPolicy& out);
+
+    // Применить к вызывающему потоку и проверить, что получилось.
+    // role — имя в отчете. Ничего не делает для ненастроенной политики
+    void apply(const std::string& role, const ThreadPolicy& policy);
+
+    // Поток с этой ролью запускается и вызовет apply(): print_report() его дождется.
+    // Вызывать до запуска потока или сразу после; ненастроенная политика не ждется
+    void expect(const std::string& role, const ThreadPolicy& policy);
+
+    // mlockall(MCL_CURRENT | MCL_FUTURE); при ограниченном RLIMIT_MEMLOCK
+    // без прав — только MCL_CURRENT, иначе не создать новый поток
+    // (его стек уже не влезет в лимит)
+    void lock_memory();
+
+    // Отчет о том, что удалось применить (накапливается из всех потоков).
+    // Ждет ожидаемые роли не дольше timeout; не отчитавшиеся перечисляются
+    void print_report(std::chrono::milliseconds timeout = std::chrono::seconds(2));
+}
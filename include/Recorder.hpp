@@ -0,0 +1,85 @@
+#pragma once
+
+#include "OggOpus.hpp"
+#include "Protocol.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// ==================== RECORDER ====================
+// Запись комнат на сервере: пакеты каждого говорящего как есть пишутся
+// в свой файл Ogg Opus (<dir>/room<N>-<ssrc>-<время>.opus).
+// Путь пересылки только копирует пакет в буфер; диск — в фоновом потоке,
+// который раз в FLUSH_INTERVAL забирает накопленное пачкой. Файл говорящего,
+// от которого нет пакетов IDLE_TIMEOUT, закрывается (страница EOS): после
+// переподключения у клиента новый ssrc, и старый файл больше не нужен.
+class Recorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(200);
+    static constexpr auto IDLE_TIMEOUT = std::chrono::seconds(30);
+    // Диск не успевает — новые пакеты отбрасываются, а не копятся в памяти
+    static constexpr size_t MAX_PENDING_BYTES = 16 * 1024 * 1024;
+
+    // rooms пустой — пишутся все комнаты
+    explicit Recorder(std::string directory, std::vector<uint16_t> rooms = {});
+    ~Recorder() { stop(); }
+
+    bool start();
+    // Дописывает накопленное и закрывает файлы
+    void stop();
+
+    // С пути пересылки: не блокируется на диске
+    void record(const protocol::PacketHeader& header, const unsigned char* payload, size_t size);
+
+    bool records_room(uint16_t room) const { return rooms.empty() || rooms.count(room) > 0; }
+    size_t dropped() const { return dropped_packets; }
+    size_t idle_closed() const { return idle_closed_streams; }
+    size_t open_streams() const { return open_stream_count; }
+
+private:
+    // Запись в буфере, за ней — payload
+    struct Entry {
+        uint32_t ssrc;
+        uint32_t timestamp;
+        uint16_t room;
+        uint16_t size;
+    };
+
+    void io_loop();
+    struct Stream {
+        std::unique_ptr<OggOpusWriter> writer;   // nullptr — файл не открылся
+        Clock::time_point last_packet;
+    };
+
+    void write_batch(const std::vector<unsigned char>& batch, Clock::time_point now);
+    void close_idle(Clock::time_point now);
+    OggOpusWriter* stream_for(const Entry& entry, const unsigned char* payload, Clock::time_point now);
+
+private:
+    std::string directory;
+    std::unordered_set<uint16_t> rooms;
+
+    // Двойной буфер: в incoming пишет пересылка, writing разбирает поток записи
+    std::vector<unsigned char> incoming;
+    std::vector<unsigned char> writing;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    std::atomic<size_t> dropped_packets;
+    std::atomic<size_t> idle_closed_streams;
+    std::atomic<size_t> open_stream_count;
+
+    // (комната, ssrc) -> файл; только поток записи
+    std::unordered_map<uint64_t, Stream> streams;
+};
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "Network.hpp"
+#include "Protocol.hpp"
+#include "PacketCrypto.hpp"
+#include "CodecScheduler.hpp"
+#include "OpusBundle.hpp"
+#include "Recorder.hpp"
+#include "Realtime.hpp"
+#include "Metrics.hpp"
+#include "PipelineLatency.hpp"
+#include "Trace.hpp"
+#include <pthread.h>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+// ==================== RELAY ====================
+// Сервер: пересылает пакеты говорящего всем остальным клиентам его комнаты
+// (комната — поле room заголовка, 0 — общая).
+// Слушателю с плохим каналом (по его receiver reports) достается поток,
+// перекодированный в меньший битрейт — один раз на (говорящий, уровень),
+// а не на каждого слушателя.
+//
+// Комната может занимать несколько ретрансляторов (узлов), связанных
+// транками: узлы объявляют соседям комнаты со своими слушателями, пакет
+// своего говорящего уходит соседу, у которого есть слушатели комнаты,
+// один раз. Пакет из транка получают только свои клиенты — соседи
+// соединены каждый с каждым. В транк пакет уходит в конверте TRUNK_AUDIO
+// с идентификатором узла: сосед узнается по адресу и по типу пакета.
+// Пакет транка с чужого адреса не заводит клиента и не рассылается, а
+// вернувшийся к своему узлу (петля из-за ошибки настройки) отбрасывается.
+//
+// С ключом сессии (set_key) пакеты зашифрованы и аутентифицированы:
+// пакет без верного тега или повтор не заводит клиента и не попадает в
+// рассылку. Слушателям и соседям уходят исходные байты отправителя —
+// шифрование на слушателя не нужно; заново шифруются только перекодированные
+// уровни, один раз на уровень.
+class Relay {
+public:
+    static constexpr int NUM_TIERS = 3;
+    // Уровень 0 — исходные байты говорящего, без перекодирования
+    static constexpr int TIER_BITRATES[NUM_TIERS] = {0, 24000, 12000};
+    // Отчетов подряд с хорошим каналом до повышения уровня
+    static constexpr int UPGRADE_REPORTS = 3;
+    // Объявление комнат соседям — не реже; изменения уходят сразу
+    static constexpr auto ANNOUNCE_INTERVAL = std::chrono::seconds(1);
+    // Сосед молчит дольше — его комнаты забываем, транк не нагружаем
+    static constexpr auto PEER_TIMEOUT = std::chrono::seconds(5);
+    // Кодеки говорящего, от которого нет пакетов столько же, сколько
+    // закрывается его запись, освобождаются: новый ssrc заведет новые
+    static constexpr auto CODEC_IDLE_TIMEOUT = Recorder::IDLE_TIMEOUT;
+    static constexpr auto CODEC_SWEEP_INTERVAL = std::chrono::seconds(1);
+
+    explicit Relay(size_t codec_threads = 0, const realtime::Config& rt = realtime::Config());
+    ~Relay() { stop(); }
+
+    bool listen(int port);
+    // До start(): соседний ретранслятор "ip:port". Транк нужно настроить
+    // с обеих сторон: соседу верим только пакеты транка с его адреса
+    bool add_peer(const std::string& address);
+    // До start(): общий ключ сессии, hex (см. PacketCrypto)
+    bool set_key(const std::string& hex);
+    bool encrypted() const { return crypto.enabled(); }
+    // До start(): исходные пакеты говорящих пишутся в Ogg Opus
+    void set_recorder(std::unique_ptr<Recorder> r) { recorder = std::move(r); }
+    void start();
+    void stop();
+
+    size_t client_count() const;
+    // Соседи, от которых недавно было объявление
+    size_t peers_up() const;
+    uint64_t packets_forwarded() const { return counters.packets_forwarded.get(); }
+    size_t transcode_missed() const { return scheduler.getTotalMissed() + scheduler.getTotalLate(); }
+    // Процессорное время сетевого потока (прием и рассылка), секунды
+    double network_cpu_seconds() const;
+    // Счетчики ретранслятора и его клиентов в формате Prometheus
+    void write_metrics(metrics::Writer& out) const;
+    // Задержки RELAY_* этапов; пишет сетевой поток
+    PipelineLatency& latency() { return stage_latency; }
+
+    // Уровень, которого заслуживает канал с такими потерями
+    static int tier_for_loss(int loss_permille);
+
+private:
+    // Клиент — адрес и порт отправителя
+    using ClientKey = uint64_t;
+
+    struct Client {
+        sockaddr_in addr;
+        ClientKey key = 0;
+        uint16_t room = 0;
+        int tier = 0;
+        int good_reports = 0;
+
+        metrics::Counter packets_in;
+        metrics::Counter bytes_in;
+        metrics::Counter packets_out;
+        metrics::Counter bytes_out;
+    };
+
+    // Соседний узел. rooms — комнаты с его слушателями по последнему
+    // полному объявлению; части нового собираются в incoming
+    struct Peer {
+        sockaddr_in addr;
+        ClientKey key = 0;
+        bool up = false;
+        std::chrono::steady_clock::time_point last_heard;
+        std::unordered_set<uint16_t> rooms;
+
+        uint32_t incoming_generation = 0;
+        uint16_t incoming_parts = 0;
+        std::vector<bool> incoming_received;
+        std::unordered_set<uint16_t> incoming_rooms;
+
+        metrics::Counter packets_in;
+        metrics::Counter bytes_in;
+        metrics::Counter packets_out;
+        metrics::Counter bytes_out;
+    };
+
+    // Пишет только сетевой поток
+    struct Counters {
+        metrics::Counter packets_received;
+        metrics::Counter bytes_received;
+        metrics::Counter invalid_packets;
+        metrics::Counter packets_forwarded;
+        metrics::Counter bytes_forwarded;
+        metrics::Counter send_errors;
+        metrics::Counter trunk_packets_sent;
+        metrics::Counter trunk_bytes_sent;
+        metrics::Counter auth_failures;
+        metrics::Counter replayed_packets;
+        metrics::Counter trunk_rejected;
+        metrics::Counter trunk_loops;
+        metrics::Counter codec_streams_freed;
+    };
+
+    // Принятый пакет: wire — как пришел (его и пересылаем), data — открытый.
+    // Без шифрования это один и тот же буфер
+    struct Incoming {
+        const unsigned char* wire;
+        size_t wire_size;
+        const unsigned char* data;
+        size_t size;
+        uint32_t salt;
+    };
+
+    // Расшифрованная пачка; size 0 — пакет не прошел проверку
+    struct OpenedBatch {
+        unsigned char data[DatagramBatch::CAPACITY][DatagramBatch::MAX_DATAGRAM];
+        size_t size[DatagramBatch::CAPACITY];
+        uint32_t salt[DatagramBatch::CAPACITY];
+    };
+
+    // Пакет говорящего, ждущий перекодирования в этом тике.
+    // Пачку кадров перекодируем по кадру и склеиваем обратно
+    struct Transcode {
+        using FrameJobs = std::array<size_t, OpusBundler::MAX_FRAMES>;
+
+        protocol::PacketHeader header;
+        ClientKey sender = 0;
+        unsigned tier_mask = 0;
+        uint64_t received_ns = 0;
+
+        int frames = 0;
+        std::vector<unsigned char> payload;                    // кадры подряд
+        std::array<int, OpusBundler::MAX_FRAMES> frame_bytes;
+        std::array<int, OpusBundler::MAX_FRAMES> frame_samples;
+        std::vector<float> pcm;
+        bool decoded = false;
+
+        FrameJobs decode_jobs;
+        std::array<FrameJobs, NUM_TIERS> encode_jobs;
+        std::array<std::vector<unsigned char>, NUM_TIERS> encoded;   // кадры уровня подряд
+    };
+
+    void network_loop();
+    // Проверка и расшифровка всей пачки подряд, до разбора пакетов
+    void open_batch();
+    // received_ns — когда пакет прочитан из сокета (LatencyHistogram::now_ns)
+    void handle_packet(const Incoming& packet, const sockaddr_in& from, uint64_t received_ns);
+    // sender — ключ клиента или соседа; из транка пакет идет только своим
+    void handle_audio(const protocol::PacketHeader& header, const Incoming& packet,
+                      ClientKey sender, bool from_trunk, uint64_t received_ns);
+    void handle_trunk_packet(Peer& peer, const protocol::PacketHeader& header,
+                             const Incoming& packet, uint64_t received_ns);
+    // Конверт TRUNK_AUDIO: проверка узла и вложенного пакета говорящего
+    void handle_trunk_audio(Peer& peer, const protocol::PacketHeader& envelope,
+                            const Incoming& packet, uint64_t received_ns);
+    // Пакет своего говорящего соседям с его комнатой; true — хоть одному ушел
+    bool send_to_peers(const protocol::PacketHeader& header, const Incoming& packet);
+    // Шифрует открытый пакет своим salt в sealed_packet; без ключа — как есть
+    bool seal(const unsigned char*& data, size_t& size);
+    void handle_announcement(Peer& peer, const protocol::PacketHeader& header,
+                             const protocol::RoomAnnouncement& announcement);
+    void forward(Client& client, const unsigned char* data, size_t size);
+    void forward(Peer& peer, const unsigned char* data, size_t size);
+    void join_room(Client& client, uint16_t room);
+    // Объявления соседям и проверка, кто из них замолчал
+    void maintain_trunks();
+    void announce_rooms();
+    void handle_report(Client& client, const protocol::ReceiverReport& report);
+    void transcode_pending();
+    // Освобождает кодеки (декодер и кодеры уровней) замолчавших говорящих
+    void expire_idle_codecs();
+
+    static uint64_t codec_key(uint32_t ssrc, int tier) { return (uint64_t(ssrc) << 8) | uint64_t(tier); }
+    static ClientKey client_key(const sockaddr_in& addr) {
+        return (ClientKey(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+    }
+    static std::string describe(const sockaddr_in& addr);
+
+private:
+    Network network;
+    std::unique_ptr<DatagramBatch> batch;
+    // Шифр и окна повторов — только сетевого потока
+    PacketCrypto crypto;
+    ReplayFilter replay;
+    uint32_t salt = 0;
+    std::unique_ptr<OpenedBatch> opened;
+    std::vector<unsigned char> sealed_packet;
+    std::thread thread;
+    pthread_t thread_handle{};
+    std::atomic<bool> running;
+    realtime::Config rt_config;
+
+    // Ссылки на элементы unordered_map не инвалидируются при росте
+    std::unordered_map<ClientKey, Client> clients;
+    std::unordered_map<uint16_t, std::vector<Client*>> rooms;
+    mutable std::mutex clients_mutex;
+    // Соседи: состав задается до start(), состояние — под clients_mutex
+    std::unordered_map<ClientKey, Peer> peers;
+    // Идентификатор узла в конвертах транка: по нему видна петля
+    uint32_t node_id = 0;
+    uint32_t trunk_sequence = 0;
+    std::vector<unsigned char> trunk_packet;
+    // Вложенный пакет, расшифрованный (только с ключом)
+    std::vector<unsigned char> trunk_opened;
+    uint32_t announcement_generation = 0;
+    bool rooms_changed = false;
+    std::chrono::steady_clock::time_point last_announcement;
+    Counters counters;
+    PipelineLatency stage_latency;
+
+    CodecScheduler scheduler;
+    std::unordered_set<uint64_t> configured_encoders;
+    // Последняя перекодировка по ssrc: по ней освобождаются кодеки
+    std::unordered_map<uint32_t, CodecScheduler::Clock::time_point> codec_last_used;
+    CodecScheduler::Clock::time_point last_codec_sweep;
+    std::vector<Transcode> pending;
+    size_t pending_count = 0;
+
+    OpusBundler bundler;
+    std::vector<unsigned char> out_packet;
+
+    std::unique_ptr<Recorder> recorder;
+};
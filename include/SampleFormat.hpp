@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Формат сэмплов аудио тракта: float32 (по умолчанию) или int16
+template <typename Sample>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<float> {
+    static constexpr const char* name = "float32";
+
+    static float toFloat(float sample) { return sample; }
+    static float fromFloat(float value) { return value; }
+};
+
+template <>
+struct SampleTraits<int16_t> {
+    static constexpr const char* name = "int16";
+
+    static float toFloat(int16_t sample) { return sample * (1.0f / 32768.0f); }
+    static int16_t fromFloat(float value) {
+        float scaled = std::clamp(value * 32768.0f, -32768.0f, 32767.0f);
+        return static_cast<int16_t>(lrintf(scaled));
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+// Пул потоков с кражей задач: у каждого рабочего своя очередь,
+// свои задачи он берет с конца, чужие — с начала. Очередь — кольцо
+// с заранее выделенными слотами: submit() не выделяет память, пока в
+// очереди рабочего не больше INITIAL_CAPACITY задач (при переполнении
+// кольцо удваивается и дальше держит новую емкость), а задача помещается
+// во внутренний буфер std::function (лямбда с парой указателей).
+class ThreadPool {
+public:
+    // 0 — по числу ядер. threadInit вызывается в каждом рабочем потоке
+    // до первой задачи (приоритет, привязка к ядрам)
+    explicit ThreadPool(size_t threads = 0, std::function<void(size_t)> threadInit = nullptr);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static constexpr size_t INITIAL_CAPACITY = 256;   // степень двойки
+
+    void submit(std::function<void()> task);
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct Worker {
+        std::vector<std::function<void()>> ring;   // размер — степень двойки
+        size_t head = 0;                           // самая старая задача
+        size_t count = 0;
+        std::mutex mutex;
+
+        void pushBack(std::function<void()>&& task);
+        void popBack(std::function<void()>& task);
+        void popFront(std::function<void()>& task);
+    };
+
+    void workerLoop(size_t index);
+    bool popTask(size_t index, std::function<void()>& task);
+    bool stealTask(size_t thief, std::function<void()>& task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::function<void(size_t)> threadInit_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> nextWorker_{0};
+    std::atomic<bool> stopping_{false};
+};
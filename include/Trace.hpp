@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ==================== TRACE ====================
+// Временная шкала событий для разбора редких сбоев: begin/end/instant
+// в кольцевых буферах по потоку (пишет только свой поток, без блокировок),
+// выгрузка в JSON формата Chrome trace — открывается в Perfetto
+// (ui.perfetto.dev) и chrome://tracing.
+//
+// Собирается с -DVOICE_TRACE (опция CMake VOICE_TRACE). Без нее макросы
+// пустые. Собрано, но не включено — одна проверка флага на событие.
+namespace trace {
+
+#ifdef VOICE_TRACE
+    constexpr bool COMPILED_IN = true;
+#else
+    constexpr bool COMPILED_IN = false;
+#endif
+
+    enum Phase : char {
+        BEGIN = 'B',
+        END = 'E',
+        INSTANT = 'i'
+    };
+
+    // Событий на поток по умолчанию: кольцо хранит последние
+    constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+    // Колец сверх числа ядер (пул кодеков): сеть, звук, запись, main...
+    constexpr size_t EXTRA_THREADS = 8;
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+        void record(Phase phase, const char* name);
+    }
+
+    inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+    // Начать запись; capacity — событий на каждый поток. Кольца на threads
+    // потоков (0 — ядра + EXTRA_THREADS) выделяются здесь, до запуска потоков:
+    // первое событие потока (в том числе в callback звука) только забирает
+    // готовое кольцо, без блокировок и выделения памяти. Размеры задает
+    // первый вызов; повторный лишь включает запись
+    void enable(size_t capacity = DEFAULT_CAPACITY, size_t threads = 0);
+    void disable();
+
+    // Имя потока на шкале (до первого события или в любой момент после).
+    // Без выделения памяти; длинное имя обрезается
+    void set_thread_name(const std::string& name);
+
+    // Потоков, которым не хватило колец: их события не записываются
+    size_t untraced_threads();
+
+    // name — строка со статическим временем жизни (литерал)
+    inline void begin(const char* name) { if (enabled()) detail::record(BEGIN, name); }
+    inline void end(const char* name) { if (enabled()) detail::record(END, name); }
+    inline void instant(const char* name) { if (enabled()) detail::record(INSTANT, name); }
+
+    // Снимок всех буферов в файл. Можно звать на ходу: события, которые
+    // поток успел перезаписать во время чтения, отбрасываются.
+    // Возвращает число записанных событий, -1 — файл не открыть
+    long write_json(const std::string& path);
+
+    // begin в конструкторе, end в деструкторе. Включение трассировки
+    // посреди области не дает непарного end
+    class Scope {
+    public:
+        explicit Scope(const char* n) : name(enabled() ? n : nullptr) {
+            if (name) detail::record(BEGIN, name);
+        }
+        ~Scope() {
+            if (name) detail::record(END, name);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+    };
+}
+
+#define VOICE_TRACE_CONCAT_(a, b) a##b
+#define VOICE_TRACE_CONCAT(a, b) VOICE_TRACE_CONCAT_(a, b)
+
+#ifdef VOICE_TRACE
+#define TRACE_SCOPE(name) trace::Scope VOICE_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_BEGIN(name) trace::begin(name)
+#define TRACE_END(name) trace::end(name)
+#define TRACE_INSTANT(name) trace::instant(name)
+#define TRACE_THREAD(name) trace::set_thread_name(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#define TRACE_THREAD(name) do {} while (0)
+#endif
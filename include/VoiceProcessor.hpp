@@ -1,10 +1,13 @@
 #pragma once
 
 #include "NoiseSuppressor.hpp"
+#include "BandSplitter.hpp"
 #include <vector>
 #include <memory>
 
-class VoiceProcessor {
+// Общий интерфейс обработки кадров: VoiceProcessor (любой размер кадра)
+// и FixedVoiceProcessor<N> (размер кадра известен при компиляции)
+class FrameProcessor {
 public:
     enum ProcessingMode {
         MODE_AGGRESSIVE,
@@ -13,45 +16,82 @@ public:
         MODE_AUTO
     };
 
+    // Статистика
+    struct Stats {
+        float inputLevelDb;
+        float outputLevelDb;
+        float noiseLevelDb;
+        float snrDb;
+        float gainAppliedDb;
+        bool clipping;
+    };
+
+    // Настройки подавителя шума для режима
+    struct ModeSettings {
+        float reductionDb;
+        float timeSmoothing;
+        float freqSmoothing;
+        bool setsType;                          // MODE_AUTO тип не меняет
+        NoiseSuppressor::SuppressionType type;
+    };
+
+    static ModeSettings settingsFor(ProcessingMode mode) {
+        switch (mode) {
+            case MODE_AGGRESSIVE:
+                return {20.0f, 0.95f, 0.5f, true, NoiseSuppressor::WIENER};
+            case MODE_CONSERVATIVE:
+                return {10.0f, 0.99f, 0.8f, true, NoiseSuppressor::SPECTRAL_GATING};
+            case MODE_AUTO:
+                return {12.0f, 0.97f, 0.6f, false, NoiseSuppressor::MMSE};
+            case MODE_STANDARD:
+            default:
+                return {15.0f, 0.98f, 0.7f, true, NoiseSuppressor::MMSE};
+        }
+    }
+
+    virtual ~FrameProcessor() = default;
+
+    // Ровно getFrameSize() сэмплов, in и out могут совпадать
+    virtual void process(const float* in, float* out) = 0;
+
+    virtual void setMode(ProcessingMode mode) = 0;
+    virtual bool enableBandSplit(bool enable) = 0;
+    virtual void calibrateNoise(const float* noiseSample) = 0;
+
+    virtual Stats getStats() const = 0;
+    virtual int getFrameSize() const = 0;
+};
+
+class VoiceProcessor : public FrameProcessor {
+public:
     VoiceProcessor(int sampleRate = 48000, int frameSize = 960);
 
     // Обработка
     std::vector<float> process(const std::vector<float>& frame);
+    void process(const float* in, float* out) override;
 
     // Настройки
-    void setMode(ProcessingMode mode);
+    void setMode(ProcessingMode mode) override;
     void enableNoiseSuppression(bool enable) { nsEnabled_ = enable; }
     void enableAutoGain(bool enable) { agcEnabled_ = enable; }
     void enableLimiter(bool enable) { limiterEnabled_ = enable; }
 
+    // Подавление шума только в полосе речи (0-8 кГц на 16 кГц),
+    // верхняя полоса — общим усилением. Только для 48 кГц и frameSize % 3 == 0.
+    bool enableBandSplit(bool enable) override;
+    bool isBandSplitEnabled() const { return bandSplitter_ != nullptr; }
+
     void setTargetLevel(float db) { targetLevelDb_ = db; }
     void setNoiseReduction(float db);
     void setMinGain(float gain);
 
     // Калибровка
     void calibrateNoise(const std::vector<float>& noiseSample);
+    void calibrateNoise(const float* noiseSample) override;
 
     // Статистика
-    struct Stats {
-        float inputLevelDb;
-        float outputLevelDb;
-        float noiseLevelDb;
-        float snrDb;
-        float gainAppliedDb;
-        bool clipping;
-    };
-
-    Stats getStats() const;
-
-private:
-    // Эффекты
-    void applyAutoGain(std::vector<float>& frame);
-    void applyLimiter(std::vector<float>& frame);
-    void applyDcFilter(std::vector<float>& frame);
-
-    // Вспомогательные
-    float calculateRmsDb(const std::vector<float>& frame) const;
-    float calculatePeakDb(const std::vector<float>& frame) const;
+    Stats getStats() const override;
+    int getFrameSize() const override { return frameSize_; }
 
 private:
     int sampleRate_;
@@ -59,6 +99,8 @@ private:
 
     // Компоненты
     std::unique_ptr<NoiseSuppressor> noiseSuppressor_;
+    std::unique_ptr<BandSplitter> bandSplitter_;
+    std::vector<float> lowBand_;
 
     // Настройки
     ProcessingMode mode_ = MODE_STANDARD;
@@ -80,6 +122,9 @@ private:
     float dcOffset_ = 0.0f;
     float dcAlpha_ = 0.995f;
 
+    // Лимитер
+    float limiterEnvelope_ = 0.0f;
+
     // Статистика
     size_t clipCount_ = 0;
 
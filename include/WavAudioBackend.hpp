@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AudioBackend.hpp"
+#include "SampleFormat.hpp"
+#include "WavFile.hpp"
+#include <string>
+#include <iostream>
+
+// Backend на WAV файлах: вход читается из файла (без файла — тишина),
+// выход пишется в файл. realtime — темп реального времени, иначе как
+// можно быстрее. По концу входного файла backend сообщает finished().
+template <typename Sample>
+class WavAudioBackend : public ThreadedAudioBackend<Sample> {
+public:
+    WavAudioBackend(const std::string& input_path, const std::string& output_path, bool realtime)
+        : ThreadedAudioBackend<Sample>(realtime)
+        , input_path(input_path)
+        , output_path(output_path) {}
+
+    // Поток останавливается до разрушения файлов
+    ~WavAudioBackend() override { this->close(); }
+
+    const char* name() const override { return "wav"; }
+
+protected:
+    bool open_device() override {
+        const size_t samples = static_cast<size_t>(this->frames) * this->channels;
+        scratch.assign(samples, 0.0f);
+
+        if (!input_path.empty()) {
+            if (!reader.open(input_path)) {
+                std::cerr << "❌ Cannot read WAV: " << input_path << std::endl;
+                return false;
+            }
+            if (reader.getSampleRate() != this->rate || reader.getChannels() != this->channels) {
+                std::cerr << "❌ WAV must be " << this->rate << " Hz, " << this->channels
+                          << " channel(s): " << input_path << std::endl;
+                reader.close();
+                return false;
+            }
+        }
+
+        if (!output_path.empty() && !writer.open(output_path, this->rate, this->channels)) {
+            std::cerr << "❌ Cannot write WAV: " << output_path << std::endl;
+            reader.close();
+            return false;
+        }
+        return true;
+    }
+
+    void close_device() override {
+        reader.close();
+        writer.close();
+    }
+
+    bool read_input(Sample* in, unsigned long count) override {
+        const size_t samples = count * this->channels;
+        if (!reader.isOpen()) {
+            std::fill(in, in + samples, Sample(0));
+            return true;
+        }
+
+        size_t got = reader.read(scratch.data(), count);
+        if (got == 0) return false;
+
+        std::fill(scratch.begin() + got * this->channels, scratch.begin() + samples, 0.0f);
+        for (size_t i = 0; i < samples; ++i) {
+            in[i] = SampleTraits<Sample>::fromFloat(scratch[i]);
+        }
+        return true;
+    }
+
+    void write_output(const Sample* out, unsigned long count) override {
+        if (!writer.isOpen()) return;
+
+        const size_t samples = count * this->channels;
+        for (size_t i = 0; i < samples; ++i) {
+            scratch[i] = SampleTraits<Sample>::toFloat(out[i]);
+        }
+        writer.write(scratch.data(), count);
+    }
+
+private:
+    std::string input_path;
+    std::string output_path;
+    WavReader reader;
+    WavWriter writer;
+    std::vector<float> scratch;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Чтение/запись WAV: PCM 16 бит или IEEE float 32 бит, каналы перемежаются.
+// Сэмплы наружу — float в [-1, 1].
+class WavReader {
+public:
+    WavReader() = default;
+    ~WavReader() { close(); }
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Читает до frames кадров, возвращает прочитанное
+    size_t read(float* out, size_t frames);
+
+    bool isOpen() const { return file_ != nullptr; }
+    int getSampleRate() const { return sampleRate_; }
+    int getChannels() const { return channels_; }
+    size_t getFrameCount() const { return frameCount_; }
+
+private:
+    FILE* file_ = nullptr;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    int bitsPerSample_ = 0;
+    bool isFloat_ = false;
+    size_t frameCount_ = 0;
+    size_t remaining_ = 0;   // кадров до конца data
+    std::vector<int16_t> pcm_;
+};
+
+// WAV, отображенный в память: кадры читаются с любого места и из любых
+// потоков без копирования файла (пакетная обработка длинных записей)
+class MappedWav {
+public:
+    MappedWav() = default;
+    ~MappedWav() { close(); }
+
+    MappedWav(const MappedWav&) = delete;
+    MappedWav& operator=(const MappedWav&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Кадры [first, first + frames), каналы сведены в моно.
+    // Возвращает прочитанное (меньше у конца файла)
+    size_t readMono(size_t first, size_t frames, float* out) const;
+
+    bool isOpen() const { return data_ != nullptr; }
+    int getSampleRate() const { return sampleRate_; }
+    int getChannels() const { return channels_; }
+    size_t getFrameCount() const { return frameCount_; }
+
+private:
+    const unsigned char* map_ = nullptr;
+    size_t mapSize_ = 0;
+    const unsigned char* data_ = nullptr;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    bool isFloat_ = false;
+    size_t frameBytes_ = 0;
+    size_t frameCount_ = 0;
+};
+
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter() { close(); }
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    // PCM 16 бит; размеры в заголовке дописываются в close()
+    bool open(const std::string& path, int sampleRate, int channels);
+    void close();
+
+    size_t write(const float* in, size_t frames);
+
+    bool isOpen() const { return file_ != nullptr; }
+
+private:
+    FILE* file_ = nullptr;
+    int channels_ = 0;
+    size_t dataBytes_ = 0;
+    std::vector<int16_t> pcm_;
+};
@@ -0,0 +1,39 @@
+#include "../include/BandSplitter.hpp"
+#include "../include/DspKernels.hpp"
+#include <algorithm>
+
+BandSplitter::BandSplitter(int frameSize, int lowBandLatency)
+    : frameSize_(frameSize)
+    , lowSize_(frameSize / DECIMATION)
+    , lowLatency_(lowBandLatency)
+    , historySize_(TAPS - 1 + DECIMATION * lowBandLatency) {
+
+    taps_.resize(TAPS);
+    dsp::makeBandSplitTaps(taps_.data(), TAPS, CUTOFF_HZ / SAMPLE_RATE);
+
+    inputHistory_.resize(historySize_ + frameSize_, 0.0f);
+    lowBand_.resize(lowLatency_ + lowSize_, 0.0f);
+    lowHistory_.resize(PHASE_TAPS - 1 + lowSize_, 0.0f);
+}
+
+void BandSplitter::analyze(const float* input, float* lowBand) {
+    std::copy(input, input + frameSize_, inputHistory_.begin() + historySize_);
+    dsp::bandSplitAnalyze(taps_.data(), TAPS, DECIMATION, inputHistory_.data() + historySize_,
+                          lowBand, lowSize_);
+    std::copy(lowBand, lowBand + lowSize_, lowBand_.begin() + lowLatency_);
+}
+
+void BandSplitter::synthesize(const float* lowBand, float highGain, float* output) {
+    float* u = lowHistory_.data() + (PHASE_TAPS - 1);
+    for (int m = 0; m < lowSize_; ++m) {
+        u[m] = lowBand[m] - highGain * lowBand_[m];
+    }
+
+    dsp::bandSplitSynthesize(taps_.data(), TAPS, DECIMATION, u, inputHistory_.data(), highGain,
+                             output, frameSize_);
+
+    // Сдвиг историй на кадр
+    std::copy(inputHistory_.end() - historySize_, inputHistory_.end(), inputHistory_.begin());
+    std::copy(lowBand_.end() - lowLatency_, lowBand_.end(), lowBand_.begin());
+    std::copy(lowHistory_.end() - (PHASE_TAPS - 1), lowHistory_.end(), lowHistory_.begin());
+}
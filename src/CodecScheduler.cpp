@@ -0,0 +1,135 @@
+#include "../include/CodecScheduler.hpp"
+#include "../include/Trace.hpp"
+#include <opus/opus.h>
+
+CodecScheduler::CodecScheduler(size_t threads, int sampleRate, int channels,
+                               std::function<void(size_t)> threadInit)
+    : sampleRate_(sampleRate)
+    , channels_(channels)
+    , pool_(threads, std::move(threadInit)) {}
+
+CodecScheduler::StreamState& CodecScheduler::stream(uint64_t key) {
+    auto it = streams_.find(key);
+    if (it == streams_.end()) {
+        auto state = std::make_unique<StreamState>();
+        state->codec.init(sampleRate_, channels_);
+        it = streams_.emplace(key, std::move(state)).first;
+    }
+    return *it->second;
+}
+
+OpusCodec& CodecScheduler::codec(uint64_t key) {
+    return stream(key).codec;
+}
+
+void CodecScheduler::removeStream(uint64_t key) {
+    streams_.erase(key);
+}
+
+size_t CodecScheduler::enqueue(const Job& job) {
+    if (finished_) {
+        jobs_.clear();
+        finished_ = false;
+    }
+
+    StreamState& state = stream(job.stream);
+    if (state.queue.empty()) {
+        active_.push_back(&state);
+    }
+
+    size_t index = jobs_.size();
+    jobs_.push_back(job);
+    state.queue.push_back(index);
+    return index;
+}
+
+size_t CodecScheduler::addDecode(uint64_t key, const unsigned char* packet, int bytes,
+                                 float* pcm, int maxFrameSize) {
+    Job job{};
+    job.kind = Job::DECODE;
+    job.stream = key;
+    job.packetIn = packet;
+    job.pcmOut = pcm;
+    job.packetBytes = bytes;
+    job.frameSize = maxFrameSize;
+    job.status = Job::PENDING;
+    return enqueue(job);
+}
+
+size_t CodecScheduler::addEncode(uint64_t key, const float* pcm, int frameSize,
+                                 unsigned char* packet, int maxBytes) {
+    Job job{};
+    job.kind = Job::ENCODE;
+    job.stream = key;
+    job.pcmIn = pcm;
+    job.packetOut = packet;
+    job.packetBytes = maxBytes;
+    job.frameSize = frameSize;
+    job.status = Job::PENDING;
+    return enqueue(job);
+}
+
+void CodecScheduler::runStream(StreamState& state) {
+    for (size_t index : state.queue) {
+        Job& job = jobs_[index];
+
+        if (Clock::now() >= deadline_) {
+            job.status = Job::MISSED;
+            job.result = OPUS_INTERNAL_ERROR;
+            continue;
+        }
+
+        TRACE_SCOPE(job.kind == Job::DECODE ? "decode" : "encode");
+        if (job.kind == Job::DECODE) {
+            job.result = state.codec.decode(job.packetIn, job.packetBytes, job.pcmOut, job.frameSize);
+        } else {
+            job.result = state.codec.encode(job.pcmIn, job.frameSize, job.packetOut, job.packetBytes);
+        }
+        job.status = (Clock::now() > deadline_) ? Job::LATE : Job::DONE;
+    }
+
+    std::lock_guard<std::mutex> lock(doneMutex_);
+    if (--remaining_ == 0) {
+        done_.notify_one();
+    }
+}
+
+CodecScheduler::TickReport CodecScheduler::run(Clock::time_point deadline) {
+    TickReport report;
+    report.jobs = jobs_.size();
+    auto start = Clock::now();
+
+    if (!active_.empty()) {
+        deadline_ = deadline;
+        remaining_ = active_.size();
+
+        for (StreamState* state : active_) {
+            pool_.submit([this, state] { runStream(*state); });
+        }
+
+        std::unique_lock<std::mutex> lock(doneMutex_);
+        done_.wait(lock, [this] { return remaining_ == 0; });
+    }
+
+    for (const Job& job : jobs_) {
+        switch (job.status) {
+            case Job::DONE:   report.completed++; break;
+            case Job::LATE:   report.late++; break;
+            case Job::MISSED: report.missed++; break;
+            default: break;
+        }
+    }
+    report.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    totalMissed_ += report.missed;
+    totalLate_ += report.late;
+
+    // Емкость сохраняется: в установившемся режиме тик без аллокаций
+    for (StreamState* state : active_) {
+        state->queue.clear();
+    }
+    active_.clear();
+    finished_ = true;
+
+    return report;
+}
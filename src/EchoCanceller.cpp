@@ -0,0 +1,275 @@
+#include "../include/EchoCanceller.hpp"
+#include "../include/FFT.hpp"
+#include "../include/SampleFormat.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Сколько кадров опорного сигнала держим в FIFO. Больше — и опора
+    // начинает отставать от эха в микрофоне (фильтр становится некаузальным).
+    constexpr int REFERENCE_FIFO_FRAMES = 3;
+}
+
+EchoCanceller::EchoCanceller(int sampleRate, int frameSize, int tailMs)
+    : sampleRate_(sampleRate)
+    , blockSize_(frameSize)
+    , fftSize_(dsp::nextPowerOfTwo(frameSize * 2))
+    , numBins_(fftSize_ / 2 + 1) {
+
+    int tailSamples = sampleRate_ * tailMs / 1000;
+    numPartitions_ = std::max(1, (tailSamples + blockSize_ - 1) / blockSize_);
+
+    farBuffer_.resize(fftSize_, 0.0f);
+    farSpectra_.resize(numPartitions_ * numBins_);
+    farPeaks_.resize(numPartitions_, 0.0f);
+    farPower_.resize(numBins_, 0.0f);
+    weights_.resize(numPartitions_ * numBins_);
+
+    work_.resize(fftSize_);
+    refBlock_.resize(blockSize_, 0.0f);
+    echo_.resize(blockSize_, 0.0f);
+    error_.resize(blockSize_, 0.0f);
+
+    refRing_.resize(blockSize_ * REFERENCE_FIFO_FRAMES, 0.0f);
+
+    std::cout << "EchoCanceller initialized (" << numPartitions_ << " partitions, "
+              << fftSize_ << "-point FFT)" << std::endl;
+}
+
+void EchoCanceller::setStepSize(float mu) {
+    stepSize_ = std::clamp(mu, 0.01f, 1.0f);
+}
+
+void EchoCanceller::setDoubleTalkThreshold(float threshold) {
+    doubleTalkThreshold_ = std::clamp(threshold, 0.1f, 2.0f);
+}
+
+void EchoCanceller::reset() {
+    std::fill(farBuffer_.begin(), farBuffer_.end(), 0.0f);
+    std::fill(farSpectra_.begin(), farSpectra_.end(), std::complex<float>(0.0f));
+    std::fill(farPeaks_.begin(), farPeaks_.end(), 0.0f);
+    std::fill(farPower_.begin(), farPower_.end(), 0.0f);
+    std::fill(weights_.begin(), weights_.end(), std::complex<float>(0.0f));
+    head_ = 0;
+    constraintIndex_ = 0;
+    doubleTalkHold_ = 0;
+    erleDb_ = 0.0f;
+    nearEnergy_ = errorEnergy_ = 0.0f;
+
+    std::lock_guard<std::mutex> lock(refMutex_);
+    refRead_ = refSize_ = 0;
+}
+
+void EchoCanceller::pushReference(const float* samples, size_t count) {
+    pushReferenceSamples(samples, count);
+}
+
+void EchoCanceller::pushReference(const int16_t* samples, size_t count) {
+    pushReferenceSamples(samples, count);
+}
+
+template <typename Sample>
+void EchoCanceller::pushReferenceSamples(const Sample* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(refMutex_);
+    const size_t capacity = refRing_.size();
+
+    // Если захват отстал — выбрасываем самое старое
+    if (count >= capacity) {
+        samples += count - capacity;
+        count = capacity;
+    }
+    if (refSize_ + count > capacity) {
+        size_t drop = refSize_ + count - capacity;
+        refRead_ = (refRead_ + drop) % capacity;
+        refSize_ -= drop;
+    }
+
+    // Опора хранится во float: преобразование одно, при записи
+    size_t write = (refRead_ + refSize_) % capacity;
+    for (size_t i = 0; i < count; ++i) {
+        refRing_[write] = SampleTraits<Sample>::toFloat(samples[i]);
+        write = (write + 1) % capacity;
+    }
+    refSize_ += count;
+}
+
+void EchoCanceller::popReference(float* block) {
+    std::lock_guard<std::mutex> lock(refMutex_);
+    const size_t capacity = refRing_.size();
+    size_t available = std::min(refSize_, static_cast<size_t>(blockSize_));
+
+    for (size_t i = 0; i < available; ++i) {
+        block[i] = refRing_[refRead_];
+        refRead_ = (refRead_ + 1) % capacity;
+    }
+    refSize_ -= available;
+
+    // Воспроизведение ничего не дало — считаем, что играла тишина
+    std::fill(block + available, block + blockSize_, 0.0f);
+}
+
+std::complex<float>* EchoCanceller::farSpectrum(int age) {
+    return &farSpectra_[((head_ + age) % numPartitions_) * numBins_];
+}
+
+void EchoCanceller::computeFarSpectrum() {
+    // Сдвигаем окно дальнего конца на блок
+    std::copy(farBuffer_.begin() + blockSize_, farBuffer_.end(), farBuffer_.begin());
+    std::copy(refBlock_.begin(), refBlock_.end(), farBuffer_.end() - blockSize_);
+
+    for (int i = 0; i < fftSize_; ++i) {
+        work_[i] = farBuffer_[i];
+    }
+    dsp::iterativeFFT(work_.data(), fftSize_);
+
+    // Новый спектр становится самым свежим (age = 0)
+    head_ = (head_ + numPartitions_ - 1) % numPartitions_;
+    std::complex<float>* X = farSpectrum(0);
+    std::copy(work_.begin(), work_.begin() + numBins_, X);
+
+    for (int k = 0; k < numBins_; ++k) {
+        farPower_[k] = powerSmoothing_ * farPower_[k] +
+                       (1.0f - powerSmoothing_) * std::norm(X[k]);
+    }
+
+    float peak = 0.0f;
+    for (float sample : refBlock_) {
+        peak = std::max(peak, std::abs(sample));
+    }
+    farPeaks_[head_] = peak;
+}
+
+void EchoCanceller::estimateEcho(float* echo) {
+    std::fill(work_.begin(), work_.end(), std::complex<float>(0.0f));
+
+    for (int p = 0; p < numPartitions_; ++p) {
+        const std::complex<float>* X = farSpectrum(p);
+        const std::complex<float>* W = weights(p);
+        for (int k = 0; k < numBins_; ++k) {
+            work_[k] += W[k] * X[k];
+        }
+    }
+
+    dsp::mirrorSpectrum(work_.data(), fftSize_);
+    dsp::iterativeFFT(work_.data(), fftSize_, true);
+
+    // Overlap-save: валидны последние blockSize_ сэмплов
+    for (int i = 0; i < blockSize_; ++i) {
+        echo[i] = work_[fftSize_ - blockSize_ + i].real();
+    }
+}
+
+bool EchoCanceller::detectDoubleTalk(float nearPeak) {
+    float farPeak = *std::max_element(farPeaks_.begin(), farPeaks_.end());
+
+    // Детектор Гейгеля
+    if (nearPeak > doubleTalkThreshold_ * farPeak) {
+        doubleTalkHold_ = doubleTalkHangover_;
+    } else if (doubleTalkHold_ > 0) {
+        doubleTalkHold_--;
+    }
+
+    return doubleTalkHold_ > 0;
+}
+
+void EchoCanceller::adaptFilter(const float* error) {
+    // Спектр ошибки: нули + блок ошибки (overlap-save)
+    std::fill(work_.begin(), work_.end() - blockSize_, std::complex<float>(0.0f));
+    for (int i = 0; i < blockSize_; ++i) {
+        work_[fftSize_ - blockSize_ + i] = error[i];
+    }
+    dsp::iterativeFFT(work_.data(), fftSize_);
+
+    // Нормированный шаг по бинам (делится между разделами)
+    const float mu = stepSize_ / numPartitions_;
+    for (int k = 0; k < numBins_; ++k) {
+        work_[k] *= mu / (farPower_[k] + regularization_);
+    }
+
+    for (int p = 0; p < numPartitions_; ++p) {
+        const std::complex<float>* X = farSpectrum(p);
+        std::complex<float>* W = weights(p);
+        for (int k = 0; k < numBins_; ++k) {
+            W[k] += std::conj(X[k]) * work_[k];
+        }
+    }
+
+    // Ограничение градиента дорогое (две FFT), поэтому за блок
+    // ограничиваем только один раздел — по кругу
+    constrainPartition(constraintIndex_);
+    constraintIndex_ = (constraintIndex_ + 1) % numPartitions_;
+}
+
+void EchoCanceller::constrainPartition(int partition) {
+    std::complex<float>* W = weights(partition);
+
+    std::copy(W, W + numBins_, work_.begin());
+    dsp::mirrorSpectrum(work_.data(), fftSize_);
+    dsp::iterativeFFT(work_.data(), fftSize_, true);
+
+    // Линейная свёртка: оставляем только первые blockSize_ отводов
+    for (int i = 0; i < fftSize_; ++i) {
+        work_[i] = (i < blockSize_) ? work_[i].real() : 0.0f;
+    }
+    dsp::iterativeFFT(work_.data(), fftSize_);
+
+    std::copy(work_.begin(), work_.begin() + numBins_, W);
+}
+
+void EchoCanceller::process(const float* nearEnd, float* out) {
+    processBlock(nearEnd, out);
+}
+
+void EchoCanceller::process(const int16_t* nearEnd, int16_t* out) {
+    processBlock(nearEnd, out);
+}
+
+template <typename Sample>
+void EchoCanceller::processBlock(const Sample* nearEnd, Sample* out) {
+    // 1. Опорный блок и его спектр
+    popReference(refBlock_.data());
+    computeFarSpectrum();
+
+    // 2. Оценка эха
+    estimateEcho(echo_.data());
+
+    // 3. Вычитание
+    float nearEnergy = 0.0f, errorEnergy = 0.0f, nearPeak = 0.0f;
+    for (int i = 0; i < blockSize_; ++i) {
+        float nearSample = SampleTraits<Sample>::toFloat(nearEnd[i]);
+        error_[i] = nearSample - echo_[i];
+        nearEnergy += nearSample * nearSample;
+        errorEnergy += error_[i] * error_[i];
+        nearPeak = std::max(nearPeak, std::abs(nearSample));
+    }
+
+    // 4. Адаптация (не во время двойного разговора)
+    bool doubleTalk = detectDoubleTalk(nearPeak);
+    if (!doubleTalk && farPeaks_[head_] > 0.0f) {
+        adaptFilter(error_.data());
+    }
+
+    // Фильтр разошёлся — лучше отдать микрофон как есть
+    if (errorEnergy > 2.0f * nearEnergy + 1e-9f) {
+        std::copy(nearEnd, nearEnd + blockSize_, out);
+        errorEnergy = nearEnergy;
+    } else {
+        for (int i = 0; i < blockSize_; ++i) {
+            out[i] = SampleTraits<Sample>::fromFloat(error_[i]);
+        }
+    }
+
+    // 5. Статистика (ERLE)
+    nearEnergy_ = 0.9f * nearEnergy_ + 0.1f * nearEnergy;
+    errorEnergy_ = 0.9f * errorEnergy_ + 0.1f * errorEnergy;
+    erleDb_ = 10.0f * log10f((nearEnergy_ + 1e-10f) / (errorEnergy_ + 1e-10f));
+}
+
+std::vector<float> EchoCanceller::process(const std::vector<float>& frame) {
+    if (frame.size() != static_cast<size_t>(blockSize_)) return frame;
+
+    std::vector<float> output(blockSize_);
+    process(frame.data(), output.data());
+    return output;
+}
@@ -0,0 +1,61 @@
+#include "../include/FFT.hpp"
+#include <cmath>
+#include <utility>
+
+namespace dsp {
+
+namespace {
+    void bitReverse(std::complex<float>* data, int n) {
+        for (int i = 1, j = 0; i < n; ++i) {
+            int bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+    }
+}
+
+void iterativeFFT(std::complex<float>* data, int n, bool inverse) {
+    if (n <= 1) return;
+
+    bitReverse(data, n);
+
+    for (int len = 2; len <= n; len <<= 1) {
+        float angle = 2.0f * M_PI / len * (inverse ? 1.0f : -1.0f);
+        std::complex<float> wlen(cosf(angle), sinf(angle));
+
+        for (int i = 0; i < n; i += len) {
+            std::complex<float> w(1.0f);
+            for (int j = 0; j < len/2; ++j) {
+                std::complex<float> u = data[i + j];
+                std::complex<float> v = data[i + j + len/2] * w;
+                data[i + j] = u + v;
+                data[i + j + len/2] = u - v;
+                w *= wlen;
+            }
+        }
+    }
+
+    if (inverse) {
+        for (int i = 0; i < n; ++i) {
+            data[i] /= static_cast<float>(n);
+        }
+    }
+}
+
+void iterativeFFT(std::vector<std::complex<float>>& data, bool inverse) {
+    iterativeFFT(data.data(), static_cast<int>(data.size()), inverse);
+}
+
+void mirrorSpectrum(std::complex<float>* data, int n) {
+    for (int i = n / 2 + 1; i < n; ++i) {
+        data[i] = std::conj(data[n - i]);
+    }
+}
+
+}
@@ -0,0 +1,16 @@
+#include "../include/FixedVoiceProcessor.hpp"
+
+template class FixedVoiceProcessor<120>;
+template class FixedVoiceProcessor<240>;
+template class FixedVoiceProcessor<480>;
+template class FixedVoiceProcessor<960>;
+
+std::unique_ptr<FrameProcessor> createFrameProcessor(int sampleRate, int frameSize) {
+    switch (frameSize) {
+        case 120: return std::make_unique<FixedVoiceProcessor<120>>(sampleRate);
+        case 240: return std::make_unique<FixedVoiceProcessor<240>>(sampleRate);
+        case 480: return std::make_unique<FixedVoiceProcessor<480>>(sampleRate);
+        case 960: return std::make_unique<FixedVoiceProcessor<960>>(sampleRate);
+        default:  return std::make_unique<VoiceProcessor>(sampleRate, frameSize);
+    }
+}
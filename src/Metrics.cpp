@@ -0,0 +1,209 @@
+#include "../include/Metrics.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace metrics {
+
+    namespace {
+        // Проверка running между ожиданиями accept
+        constexpr int POLL_TIMEOUT_MS = 200;
+        // Медленный клиент не держит сервер дольше
+        constexpr int CLIENT_TIMEOUT_MS = 1000;
+        constexpr size_t MAX_REQUEST_BYTES = 4096;
+
+        std::string format_number(double value) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.17g", value);
+            return buffer;
+        }
+
+        // Метка квантиля: коротко, "0.99", а не "0.98999999999999999"
+        std::string format_quantile(double value) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%g", value);
+            return buffer;
+        }
+
+        bool send_all(int fd, const std::string& data) {
+            size_t offset = 0;
+            while (offset < data.size()) {
+                ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+                if (sent <= 0) return false;
+                offset += static_cast<size_t>(sent);
+            }
+            return true;
+        }
+    }
+
+    void Writer::counter(const std::string& name, const std::string& help, uint64_t value,
+                         const std::string& labels) {
+        family(name, help, "counter");
+        sample(name, labels, std::to_string(value));
+    }
+
+    void Writer::gauge(const std::string& name, const std::string& help, double value,
+                       const std::string& labels) {
+        family(name, help, "gauge");
+        sample(name, labels, format_number(value));
+    }
+
+    void Writer::summary(const std::string& name, const std::string& help,
+                         const std::vector<std::pair<double, double>>& quantiles,
+                         double sum, uint64_t count, const std::string& labels) {
+        family(name, help, "summary");
+        std::string separator = labels.empty() ? "" : ",";
+        for (const auto& [quantile, value] : quantiles) {
+            sample(name, labels + separator + "quantile=\"" + format_quantile(quantile) + "\"",
+                   format_number(value));
+        }
+        sample(name + "_sum", labels, format_number(sum));
+        sample(name + "_count", labels, std::to_string(count));
+    }
+
+    void Writer::family(const std::string& name, const std::string& help, const char* type) {
+        if (name == last_family) return;
+        last_family = name;
+        text += "# HELP " + name + " " + help + "\n";
+        text += "# TYPE " + name + " " + type + "\n";
+    }
+
+    void Writer::sample(const std::string& name, const std::string& labels, const std::string& value) {
+        text += name;
+        if (!labels.empty()) text += "{" + labels + "}";
+        text += " " + value + "\n";
+    }
+
+    Server::Server(Render r) : render(std::move(r)), running(false) {}
+
+    bool Server::start(const std::string& address) {
+        stop();
+
+        std::string shown;
+        if (address.rfind("unix:", 0) == 0) {
+            unix_path = address.substr(5);
+            sockaddr_un addr{};
+            if (unix_path.empty() || unix_path.size() >= sizeof(addr.sun_path)) {
+                std::cerr << "❌ Invalid metrics socket path '" << unix_path << "'" << std::endl;
+                return false;
+            }
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, unix_path.c_str(), unix_path.size() + 1);
+
+            listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            unlink(unix_path.c_str());
+            if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+                std::cerr << "❌ Cannot bind metrics socket " << unix_path << ": " << strerror(errno) << std::endl;
+                stop();
+                return false;
+            }
+            shown = "unix:" + unix_path;
+        } else {
+            // Без адреса — только локально: наружу метрики не выставляем
+            std::string host = "127.0.0.1";
+            std::string port = address;
+            size_t colon = address.rfind(':');
+            if (colon != std::string::npos) {
+                host = address.substr(0, colon);
+                port = address.substr(colon + 1);
+            }
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+            if (addr.sin_port == 0 || inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+                std::cerr << "❌ Invalid metrics address '" << address << "'" << std::endl;
+                return false;
+            }
+
+            listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            int opt = 1;
+            if (listen_fd >= 0) setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+                std::cerr << "❌ Cannot bind metrics address " << address << ": " << strerror(errno) << std::endl;
+                stop();
+                return false;
+            }
+            shown = "http://" + host + ":" + port + "/metrics";
+        }
+
+        if (listen(listen_fd, 16) < 0) {
+            std::cerr << "❌ Metrics listen failed: " << strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+
+        running = true;
+        thread = std::thread(&Server::serve_loop, this);
+        std::cout << "📊 Metrics at " << shown << std::endl;
+        return true;
+    }
+
+    void Server::stop() {
+        running = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            listen_fd = -1;
+        }
+        if (!unix_path.empty()) {
+            unlink(unix_path.c_str());
+            unix_path.clear();
+        }
+    }
+
+    void Server::serve_loop() {
+        pollfd listening{listen_fd, POLLIN, 0};
+        while (running) {
+            if (poll(&listening, 1, POLL_TIMEOUT_MS) <= 0) continue;
+
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) continue;
+
+            timeval timeout{CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            handle_connection(fd);
+            close(fd);
+        }
+    }
+
+    void Server::handle_connection(int fd) {
+        // Нужна только строка запроса: читаем до конца заголовков
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) break;
+            request.append(buffer, static_cast<size_t>(received));
+        }
+
+        std::string status = "200 OK";
+        std::string body;
+        if (request.rfind("GET /metrics", 0) == 0 &&
+            (request.size() == 12 || request[12] == ' ' || request[12] == '?')) {
+            body = render();
+        } else if (request.rfind("GET ", 0) == 0) {
+            status = "404 Not Found";
+            body = "Try /metrics\n";
+        } else {
+            status = "405 Method Not Allowed";
+        }
+
+        std::string response = "HTTP/1.0 " + status + "\r\n"
+                               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + body;
+        send_all(fd, response);
+    }
+}
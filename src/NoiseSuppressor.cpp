@@ -1,91 +1,26 @@
 #include "../include/NoiseSuppressor.hpp"
+#include "../include/FFT.hpp"
+#include "../include/DspKernels.hpp"
 #include <iostream>
 #include <numeric>
 
-// Упрощенная FFT реализация
-namespace {
-    void bitReverse(std::vector<std::complex<float>>& data) {
-        int n = data.size();
-        for (int i = 1, j = 0; i < n; ++i) {
-            int bit = n >> 1;
-            for (; j & bit; bit >>= 1) {
-                j ^= bit;
-            }
-            j ^= bit;
-
-            if (i < j) {
-                std::swap(data[i], data[j]);
-            }
-        }
-    }
-
-    void iterativeFFT(std::vector<std::complex<float>>& data, bool inverse = false) {
-        int n = data.size();
-        if (n <= 1) return;
-
-        bitReverse(data);
-
-        for (int len = 2; len <= n; len <<= 1) {
-            float angle = 2.0f * M_PI / len * (inverse ? 1.0f : -1.0f);
-            std::complex<float> wlen(cosf(angle), sinf(angle));
-
-            for (int i = 0; i < n; i += len) {
-                std::complex<float> w(1.0f);
-                for (int j = 0; j < len/2; ++j) {
-                    std::complex<float> u = data[i + j];
-                    std::complex<float> v = data[i + j + len/2] * w;
-                    data[i + j] = u + v;
-                    data[i + j + len/2] = u - v;
-                    w *= wlen;
-                }
-            }
-        }
-
-        if (inverse) {
-            for (auto& x : data) {
-                x /= static_cast<float>(n);
-            }
-        }
-    }
-}
-
 NoiseSuppressor::NoiseSuppressor(int sampleRate, int frameSize)
     : sampleRate_(sampleRate)
     , frameSize_(frameSize)
-    , fftSize_(frameSize * 2)
+    , fftSize_(dsp::nextPowerOfTwo(frameSize * 2)) // radix-2 FFT, окно 2 * frameSize
     , numBins_(fftSize_ / 2 + 1)
-    , overlapSize_(frameSize_ / 2) {
+    , overlapSize_(frameSize_) {
 
-    // Окна
+    // Окна sqrt-Hann, шаг анализа — один кадр
     analysisWindow_.resize(fftSize_);
     synthesisWindow_.resize(fftSize_);
-
-    // Окно синус-квадрат
-    for (int i = 0; i < fftSize_; ++i) {
-        analysisWindow_[i] = sinf(M_PI * i / fftSize_);
-        analysisWindow_[i] *= analysisWindow_[i];
-
-        if (i < frameSize_) {
-            synthesisWindow_[i] = analysisWindow_[i];
-        }
-    }
-
-    // Нормализация
-    float sum = 0.0f;
-    for (int i = 0; i < overlapSize_; ++i) {
-        sum += analysisWindow_[i] * synthesisWindow_[i] +
-               analysisWindow_[i + overlapSize_] * synthesisWindow_[i + overlapSize_];
-    }
-
-    float scale = 2.0f / sum;
-    for (int i = 0; i < fftSize_; ++i) {
-        analysisWindow_[i] *= scale;
-        synthesisWindow_[i] *= scale;
-    }
+    dsp::makeSuppressorWindows(analysisWindow_.data(), synthesisWindow_.data(), fftSize_, frameSize_);
 
     // Инициализация
     noiseEstimate_.resize(numBins_, 1e-6f);
     previousGains_.resize(numBins_, 1.0f);
+    smoothingScratch_.resize(numBins_, 0.0f);
+    inputBuffer_.resize(frameSize_ * 2, 0.0f);
     overlapBuffer_.resize(overlapSize_, 0.0f);
 
     std::cout << "NoiseSuppressor initialized" << std::endl;
@@ -100,11 +35,18 @@ void NoiseSuppressor::setSmoothing(float timeSmoothing, float freqSmoothing) {
     freqSmoothing_ = std::clamp(freqSmoothing, 0.3f, 0.9f);
 }
 
+float NoiseSuppressor::getUpperBandGain() const {
+    return dsp::meanGain(previousGains_.data(), numBins_ / 2, numBins_);
+}
+
 void NoiseSuppressor::calibrateNoise(const std::vector<float>& noiseFrame) {
     if (noiseFrame.size() != static_cast<size_t>(frameSize_)) return;
 
-    std::vector<float> padded = noiseFrame;
-    padded.resize(fftSize_, 0.0f);
+    // Кадр повторён дважды, чтобы заполнить окно анализа:
+    // масштаб спектра шума тот же, что в process()
+    std::vector<float> padded(fftSize_, 0.0f);
+    std::copy(noiseFrame.begin(), noiseFrame.end(), padded.begin());
+    std::copy(noiseFrame.begin(), noiseFrame.end(), padded.begin() + frameSize_);
     applyWindow(padded, true);
 
     std::vector<std::complex<float>> spectrum(fftSize_);
@@ -121,7 +63,7 @@ void NoiseSuppressor::calibrateNoise(const std::vector<float>& noiseFrame) {
 }
 
 void NoiseSuppressor::fft(std::vector<std::complex<float>>& data, bool inverse) {
-    iterativeFFT(data, inverse);
+    dsp::iterativeFFT(data, inverse);
 }
 
 float NoiseSuppressor::estimateSNR(const std::complex<float>& bin, float noisePower) {
@@ -131,101 +73,43 @@ float NoiseSuppressor::estimateSNR(const std::complex<float>& bin, float noisePo
 
 std::vector<float> NoiseSuppressor::wienerFilter(const std::vector<std::complex<float>>& spectrum) {
     std::vector<float> gains(numBins_);
-
-    for (int i = 0; i < numBins_; ++i) {
-        float signalPower = std::norm(spectrum[i]);
-        float noisePower = noiseEstimate_[i];
-
-        float wienerGain = signalPower / (signalPower + noisePower + 1e-10f);
-        float suppression = powf(10.0f, -reductionDb_ / 20.0f);
-        wienerGain = std::max(wienerGain, suppression);
-
-        gains[i] = sqrtf(wienerGain);
-        gains[i] = std::max(gains[i], minGain_);
-    }
-
+    dsp::wienerGains(spectrum.data(), noiseEstimate_.data(), gains.data(), numBins_,
+                     reductionDb_, minGain_);
     return gains;
 }
 
 std::vector<float> NoiseSuppressor::mmseFilter(const std::vector<std::complex<float>>& spectrum) {
     std::vector<float> gains(numBins_);
-
-    for (int i = 0; i < numBins_; ++i) {
-        float signalPower = std::norm(spectrum[i]);
-        float noisePower = noiseEstimate_[i];
-
-        // Упрощенный MMSE (без сложных вычислений)
-        float snr = signalPower / (noisePower + 1e-10f);
-        float mmseGain = snr / (1.0f + snr);
-
-        // Применяем reduction
-        float suppression = powf(10.0f, -reductionDb_ / 20.0f);
-        mmseGain = std::max(mmseGain, suppression);
-
-        gains[i] = sqrtf(mmseGain);
-        gains[i] = std::max(gains[i], 0.1f); // Сохраняем хоть что-то
-    }
-
+    dsp::mmseGains(spectrum.data(), noiseEstimate_.data(), gains.data(), numBins_,
+                   reductionDb_, 0.1f); // Сохраняем хоть что-то
     return gains;
 }
 
 std::vector<float> NoiseSuppressor::spectralGating(const std::vector<std::complex<float>>& spectrum) {
     std::vector<float> gains(numBins_);
-
-    for (int i = 0; i < numBins_; ++i) {
-        float magnitude = std::abs(spectrum[i]);
-        float noiseMag = sqrtf(noiseEstimate_[i]);
-
-        float threshold = noiseMag * powf(10.0f, reductionDb_ / 20.0f);
-
-        if (magnitude < threshold) {
-            float attenuation = magnitude / (threshold + 1e-10f);
-            // Кубическая интерполяция для плавности
-            attenuation = attenuation * attenuation * (3.0f - 2.0f * attenuation);
-            gains[i] = attenuation;
-        } else {
-            gains[i] = 1.0f;
-        }
-
-        gains[i] = std::max(gains[i], 0.05f); // Очень мягкое минимальное значение
-    }
-
+    dsp::spectralGatingGains(spectrum.data(), noiseEstimate_.data(), gains.data(), numBins_,
+                             reductionDb_, 0.05f); // Очень мягкое минимальное значение
     return gains;
 }
 
 void NoiseSuppressor::applySmoothing(std::vector<float>& gains) {
-    // Сглаживание по частоте
-    if (numBins_ > 2) {
-        std::vector<float> smoothed = gains;
-        for (int i = 1; i < numBins_ - 1; ++i) {
-            smoothed[i] = (gains[i-1] + gains[i] + gains[i+1]) / 3.0f;
-        }
-
-        for (int i = 0; i < numBins_; ++i) {
-            gains[i] = freqSmoothing_ * smoothed[i] + (1.0f - freqSmoothing_) * gains[i];
-        }
-    }
-
-    // Сглаживание по времени
-    for (int i = 0; i < numBins_; ++i) {
-        gains[i] = timeSmoothing_ * previousGains_[i] +
-                  (1.0f - timeSmoothing_) * gains[i];
-        previousGains_[i] = gains[i];
-    }
+    dsp::smoothGains(gains.data(), previousGains_.data(), smoothingScratch_.data(), numBins_,
+                     timeSmoothing_, freqSmoothing_);
 }
 
 void NoiseSuppressor::applyWindow(std::vector<float>& data, bool analysis) {
     const std::vector<float>& window = analysis ? analysisWindow_ : synthesisWindow_;
-    for (size_t i = 0; i < data.size() && i < window.size(); ++i) {
-        data[i] *= window[i];
-    }
+    dsp::applyWindow(data.data(), window.data(), std::min(data.size(), window.size()));
 }
 
 std::vector<float> NoiseSuppressor::process(const std::vector<float>& frame) {
     if (frame.size() != static_cast<size_t>(frameSize_)) return frame;
 
-    // 1. Подготовка
-    std::vector<float> padded = frame;
+    // 1. Окно анализа: предыдущий кадр + текущий
+    std::copy(inputBuffer_.begin() + frameSize_, inputBuffer_.end(), inputBuffer_.begin());
+    std::copy(frame.begin(), frame.end(), inputBuffer_.begin() + frameSize_);
+
+    std::vector<float> padded = inputBuffer_;
     padded.resize(fftSize_, 0.0f);
     applyWindow(padded, true);
 
@@ -262,9 +146,7 @@ std::vector<float> NoiseSuppressor::process(const std::vector<float>& frame) {
     }
 
     // Симметрия для реального сигнала
-    for (int i = 1; i < numBins_ - 1; ++i) {
-        spectrum[fftSize_ - i] = std::conj(spectrum[i]);
-    }
+    dsp::mirrorSpectrum(spectrum.data(), fftSize_);
 
     // 6. Обратное FFT
     fft(spectrum, true);
@@ -276,20 +158,16 @@ std::vector<float> NoiseSuppressor::process(const std::vector<float>& frame) {
     }
     applyWindow(processed, false);
 
-    // 8. Overlap-add
+    // 8. Overlap-add с шагом в кадр: первая половина окна + хвост прошлого
     std::vector<float> output(frameSize_, 0.0f);
 
     for (int i = 0; i < frameSize_; ++i) {
-        if (i < overlapSize_) {
-            output[i] = overlapBuffer_[i] + processed[i];
-        } else {
-            output[i] = processed[i];
-        }
+        output[i] = overlapBuffer_[i] + processed[i];
     }
 
-    // 9. Сохранение overlap
+    // 9. Вторая половина окна — overlap для следующего кадра
     for (int i = 0; i < overlapSize_; ++i) {
-        overlapBuffer_[i] = processed[i + frameSize_ - overlapSize_];
+        overlapBuffer_[i] = processed[i + frameSize_];
     }
 
     // 10. Статистика
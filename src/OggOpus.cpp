@@ -0,0 +1,188 @@
+#include "../include/OggOpus.hpp"
+#include <opus/opus.h>
+#include <array>
+#include <cstring>
+
+namespace {
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr size_t PAGE_HEADER_SIZE = 27;
+    constexpr size_t MAX_SEGMENTS = 255;
+
+    constexpr uint8_t FLAG_BOS = 0x02;
+    constexpr uint8_t FLAG_EOS = 0x04;
+
+    // Ogg: CRC-32, полином 0x04C11DB7, без отражения, начальное значение 0
+    std::array<uint32_t, 256> makeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t r = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                r = (r & 0x80000000u) ? (r << 1) ^ 0x04C11DB7u : (r << 1);
+            }
+            table[i] = r;
+        }
+        return table;
+    }
+
+    uint32_t oggCrc(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = makeCrcTable();
+        for (size_t i = 0; i < size; ++i) {
+            crc = (crc << 8) ^ table[((crc >> 24) & 0xFF) ^ data[i]];
+        }
+        return crc;
+    }
+
+    // Ogg всегда little-endian
+    void putU16(std::vector<unsigned char>& out, uint16_t v) {
+        out.push_back(v & 0xFF);
+        out.push_back(v >> 8);
+    }
+    void putU32(std::vector<unsigned char>& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) out.push_back((v >> (8 * i)) & 0xFF);
+    }
+    void putU32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; ++i) p[i] = (v >> (8 * i)) & 0xFF;
+    }
+    void putU64(unsigned char* p, uint64_t v) {
+        for (int i = 0; i < 8; ++i) p[i] = (v >> (8 * i)) & 0xFF;
+    }
+}
+
+bool OggOpusWriter::open(const std::string& path, uint32_t serial, int channels,
+                         const std::vector<std::string>& comments) {
+    close();
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    serial_ = serial;
+    pageSequence_ = 0;
+    started_ = false;
+    granule_ = 0;
+    segments_.clear();
+    body_.clear();
+    output_.clear();
+
+    // OpusHead — отдельная первая страница. Запись начинается с середины
+    // потока, декодер уже прогрет у отправителя: pre-skip 0
+    std::vector<unsigned char> head = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd'};
+    head.push_back(1);                          // версия
+    head.push_back(static_cast<unsigned char>(channels));
+    putU16(head, 0);                            // pre-skip
+    putU32(head, SAMPLE_RATE);                  // исходная частота
+    putU16(head, 0);                            // усиление
+    head.push_back(0);                          // mapping family 0: моно/стерео
+    appendPacket(head.data(), static_cast<int>(head.size()), 0);
+    writePage(FLAG_BOS);
+
+    std::vector<unsigned char> tags = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's'};
+    const std::string vendor = "c-speak relay recorder";
+    putU32(tags, static_cast<uint32_t>(vendor.size()));
+    tags.insert(tags.end(), vendor.begin(), vendor.end());
+    putU32(tags, static_cast<uint32_t>(comments.size()));
+    for (const auto& comment : comments) {
+        putU32(tags, static_cast<uint32_t>(comment.size()));
+        tags.insert(tags.end(), comment.begin(), comment.end());
+    }
+    appendPacket(tags.data(), static_cast<int>(tags.size()), 0);
+    writePage(0);
+
+    flush();
+    return true;
+}
+
+void OggOpusWriter::close() {
+    if (!file_) return;
+
+    // EOS допустим и на странице без пакетов
+    writePage(FLAG_EOS);
+    flush();
+
+    fclose(file_);
+    file_ = nullptr;
+}
+
+bool OggOpusWriter::write(const unsigned char* packet, int bytes, uint32_t timestamp) {
+    if (!file_ || bytes <= 0) return false;
+
+    int samples = opus_packet_get_nb_samples(packet, bytes, SAMPLE_RATE);
+    if (samples <= 0) return false;
+
+    if (!started_) {
+        started_ = true;
+        nextTimestamp_ = timestamp;
+    }
+
+    int32_t gap = static_cast<int32_t>(timestamp - nextTimestamp_);
+    if (gap < 0) return false;
+
+    // Потерянные кадры: пакет из одного TOC (code 0, кадр нулевой длины)
+    if (gap > 0 && static_cast<uint32_t>(gap) <= MAX_GAP) {
+        int frameSamples = opus_packet_get_samples_per_frame(packet, SAMPLE_RATE);
+        unsigned char lost = packet[0] & 0xFC;
+        for (int filled = 0; frameSamples > 0 && filled + frameSamples <= gap; filled += frameSamples) {
+            appendPacket(&lost, 1, frameSamples);
+        }
+    }
+
+    appendPacket(packet, bytes, samples);
+    nextTimestamp_ = timestamp + samples;
+    return true;
+}
+
+void OggOpusWriter::flush() {
+    if (!file_ || output_.empty()) return;
+
+    fwrite(output_.data(), 1, output_.size(), file_);
+    fflush(file_);
+    output_.clear();
+}
+
+void OggOpusWriter::appendPacket(const unsigned char* packet, int bytes, int samples) {
+    // Пакет не разрываем между страницами: не влезает — закрываем страницу
+    size_t needed = static_cast<size_t>(bytes) / 255 + 1;
+    if (segments_.size() + needed > MAX_SEGMENTS) {
+        writePage(0);
+    }
+
+    // Lacing: по 255 и остаток (0 при кратной длине)
+    int remaining = bytes;
+    while (remaining >= 255) {
+        segments_.push_back(255);
+        remaining -= 255;
+    }
+    segments_.push_back(static_cast<uint8_t>(remaining));
+    body_.insert(body_.end(), packet, packet + bytes);
+
+    granule_ += samples;
+    if (granule_ - pageStartGranule_ >= PAGE_DURATION) {
+        writePage(0);
+    }
+}
+
+void OggOpusWriter::writePage(uint8_t flags) {
+    if (segments_.empty() && !(flags & FLAG_EOS)) return;
+
+    size_t start = output_.size();
+    output_.resize(start + PAGE_HEADER_SIZE);
+    unsigned char* header = output_.data() + start;
+
+    memcpy(header, "OggS", 4);
+    header[4] = 0;                              // версия
+    header[5] = flags;
+    putU64(header + 6, granule_);
+    putU32(header + 14, serial_);
+    putU32(header + 18, pageSequence_++);
+    putU32(header + 22, 0);                     // CRC считается с нулем на своем месте
+    header[26] = static_cast<uint8_t>(segments_.size());
+
+    output_.insert(output_.end(), segments_.begin(), segments_.end());
+    output_.insert(output_.end(), body_.begin(), body_.end());
+
+    uint32_t crc = oggCrc(output_.data() + start, output_.size() - start);
+    putU32(output_.data() + start + 22, crc);
+
+    segments_.clear();
+    body_.clear();
+    pageStartGranule_ = granule_;
+}
@@ -0,0 +1,64 @@
+#include "../include/OpusBundle.hpp"
+#include <opus/opus.h>
+#include <cstring>
+
+OpusBundler::OpusBundler()
+    : bundle_(opus_repacketizer_create())
+    , splitter_(opus_repacketizer_create()) {}
+
+OpusBundler::~OpusBundler() {
+    if (bundle_) {
+        opus_repacketizer_destroy(bundle_);
+    }
+    if (splitter_) {
+        opus_repacketizer_destroy(splitter_);
+    }
+}
+
+bool OpusBundler::add(const unsigned char* packet, int bytes) {
+    if (!bundle_ || bytes <= 0) return false;
+    if (count_ >= MAX_FRAMES || used_ + bytes > static_cast<int>(storage_.size())) return false;
+
+    unsigned char* copy = storage_.data() + used_;
+    memcpy(copy, packet, bytes);
+
+    // Кадры с другим режимом/длительностью или сверх 120 мс не склеиваются
+    if (opus_repacketizer_cat(bundle_, copy, bytes) != OPUS_OK) return false;
+
+    used_ += bytes;
+    count_ += opus_packet_get_nb_frames(copy, bytes);
+    return true;
+}
+
+int OpusBundler::flush(unsigned char* out, int maxBytes) {
+    if (!bundle_) return OPUS_INVALID_STATE;
+
+    int bytes = opus_repacketizer_out(bundle_, out, maxBytes);
+
+    opus_repacketizer_init(bundle_);
+    used_ = 0;
+    count_ = 0;
+    return bytes;
+}
+
+int OpusBundler::split(const unsigned char* packet, int bytes, unsigned char* out, int maxBytes,
+                       int* frameBytes, int maxFrames) {
+    if (!splitter_) return OPUS_INVALID_STATE;
+
+    opus_repacketizer_init(splitter_);
+    int status = opus_repacketizer_cat(splitter_, packet, bytes);
+    if (status != OPUS_OK) return status;
+
+    int frames = opus_repacketizer_get_nb_frames(splitter_);
+    if (frames > maxFrames) return OPUS_BUFFER_TOO_SMALL;
+
+    int offset = 0;
+    for (int i = 0; i < frames; ++i) {
+        int size = opus_repacketizer_out_range(splitter_, i, i + 1, out + offset, maxBytes - offset);
+        if (size < 0) return size;
+
+        frameBytes[i] = size;
+        offset += size;
+    }
+    return frames;
+}
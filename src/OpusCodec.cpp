@@ -1,15 +1,17 @@
 #include "../include/OpusCodec.hpp"
-#include <opus/opus.h>
+#include "../include/OpusSample.hpp"
 #include <iostream>
 #include <stdexcept>
 
-OpusCodec::OpusCodec()
+template <typename Sample>
+BasicOpusCodec<Sample>::BasicOpusCodec()
     : encoder(nullptr)
     , decoder(nullptr)
     , sampleRate(48000)
     , channels(1) {}
 
-OpusCodec::~OpusCodec() {
+template <typename Sample>
+BasicOpusCodec<Sample>::~BasicOpusCodec() {
     if (encoder) {
         opus_encoder_destroy(encoder);
     }
@@ -18,7 +20,8 @@ OpusCodec::~OpusCodec() {
     }
 }
 
-bool OpusCodec::init(int sr, int ch) {
+template <typename Sample>
+bool BasicOpusCodec<Sample>::init(int sr, int ch) {
     sampleRate = sr;
     channels = ch;
 
@@ -40,10 +43,43 @@ bool OpusCodec::init(int sr, int ch) {
     opus_encoder_ctl(encoder, OPUS_SET_VBR(1));
     opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(10));
 
+    packetBuffer.resize(MAX_PACKET_SIZE);
+    pcmBuffer.resize(getMaxFrameSize() * channels);
+
     return true;
 }
 
-std::vector<unsigned char> OpusCodec::encode(const std::vector<float>& pcm) {
+template <typename Sample>
+int BasicOpusCodec<Sample>::setBitrate(int bitsPerSecond) {
+    if (!encoder) {
+        return OPUS_INVALID_STATE;
+    }
+
+    return opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitsPerSecond));
+}
+
+template <typename Sample>
+int BasicOpusCodec<Sample>::encode(const Sample* pcm, int frameSize,
+                                   unsigned char* packet, int maxBytes) {
+    if (!encoder) {
+        return OPUS_INVALID_STATE;
+    }
+
+    return opusEncode(encoder, pcm, frameSize, packet, maxBytes);
+}
+
+template <typename Sample>
+int BasicOpusCodec<Sample>::decode(const unsigned char* packet, int bytes,
+                                   Sample* pcm, int maxFrameSize) {
+    if (!decoder) {
+        return OPUS_INVALID_STATE;
+    }
+
+    return opusDecode(decoder, packet, bytes, pcm, maxFrameSize, 0);
+}
+
+template <typename Sample>
+std::vector<unsigned char> BasicOpusCodec<Sample>::encode(const std::vector<Sample>& pcm) {
     if (!encoder) {
         throw std::runtime_error("Encoder not initialized");
     }
@@ -52,22 +88,17 @@ std::vector<unsigned char> OpusCodec::encode(const std::vector<float>& pcm) {
         return {};
     }
 
-    std::vector<unsigned char> encoded(4000); // Максимальный размер
     int frameSize = static_cast<int>(pcm.size() / channels);
-
-    int bytes = opus_encode_float(encoder, pcm.data(), frameSize,
-                                 encoded.data(), encoded.size());
-
+    int bytes = encode(pcm.data(), frameSize, packetBuffer.data(), MAX_PACKET_SIZE);
     if (bytes < 0) {
-        std::cerr << "Encode error: " << opus_strerror(bytes) << std::endl;
         return {};
     }
 
-    encoded.resize(bytes);
-    return encoded;
+    return std::vector<unsigned char>(packetBuffer.begin(), packetBuffer.begin() + bytes);
 }
 
-std::vector<float> OpusCodec::decode(const std::vector<unsigned char>& encoded) {
+template <typename Sample>
+std::vector<Sample> BasicOpusCodec<Sample>::decode(const std::vector<unsigned char>& encoded) {
     if (!decoder) {
         throw std::runtime_error("Decoder not initialized");
     }
@@ -76,16 +107,19 @@ std::vector<float> OpusCodec::decode(const std::vector<unsigned char>& encoded)
         return {};
     }
 
-    std::vector<float> pcm(960); // 40ms at 48kHz
-
-    int samples = opus_decode_float(decoder, encoded.data(), encoded.size(),
-                                   pcm.data(), pcm.size() / channels, 0);
-
+    int samples = decode(encoded.data(), static_cast<int>(encoded.size()),
+                         pcmBuffer.data(), getMaxFrameSize());
     if (samples < 0) {
-        std::cerr << "Decode error: " << opus_strerror(samples) << std::endl;
         return {};
     }
 
-    pcm.resize(samples * channels);
-    return pcm;
+    return std::vector<Sample>(pcmBuffer.begin(), pcmBuffer.begin() + samples * channels);
 }
+
+template <typename Sample>
+const char* BasicOpusCodec<Sample>::errorString(int status) {
+    return opus_strerror(status);
+}
+
+template class BasicOpusCodec<float>;
+template class BasicOpusCodec<int16_t>;
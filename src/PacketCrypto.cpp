@@ -0,0 +1,191 @@
+#include "../include/PacketCrypto.hpp"
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    constexpr size_t NONCE_SIZE = 12;
+    constexpr size_t AAD_SIZE = protocol::HEADER_SIZE + PacketCrypto::SALT_SIZE;
+
+    int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+}
+
+PacketCrypto::PacketCrypto()
+    : encrypt_ctx(EVP_CIPHER_CTX_new())
+    , decrypt_ctx(EVP_CIPHER_CTX_new()) {}
+
+PacketCrypto::~PacketCrypto() {
+    EVP_CIPHER_CTX_free(encrypt_ctx);
+    EVP_CIPHER_CTX_free(decrypt_ctx);
+}
+
+bool PacketCrypto::set_key_hex(const std::string& hex) {
+    if (hex.size() % 2 != 0) return false;
+
+    std::vector<unsigned char> key(hex.size() / 2);
+    for (size_t i = 0; i < key.size(); ++i) {
+        int high = hex_value(hex[2 * i]);
+        int low = hex_value(hex[2 * i + 1]);
+        if (high < 0 || low < 0) return false;
+        key[i] = static_cast<unsigned char>(high << 4 | low);
+    }
+
+    bool ok = set_key(key.data(), key.size());
+    std::fill(key.begin(), key.end(), 0);
+    return ok;
+}
+
+bool PacketCrypto::set_key(const unsigned char* key, size_t size) {
+    const EVP_CIPHER* cipher = nullptr;
+    if (size == 16) {
+        cipher = EVP_aes_128_gcm();
+    } else if (size == 32) {
+        cipher = EVP_aes_256_gcm();
+    } else {
+        return false;
+    }
+    if (!encrypt_ctx || !decrypt_ctx) return false;
+
+    // Ключ и длина IV — один раз; на пакет потом задается только IV
+    key_bits = 0;
+    if (EVP_EncryptInit_ex(encrypt_ctx, cipher, nullptr, nullptr, nullptr) != 1 ||
+        EVP_CIPHER_CTX_ctrl(encrypt_ctx, EVP_CTRL_GCM_SET_IVLEN, NONCE_SIZE, nullptr) != 1 ||
+        EVP_EncryptInit_ex(encrypt_ctx, nullptr, nullptr, key, nullptr) != 1 ||
+        EVP_DecryptInit_ex(decrypt_ctx, cipher, nullptr, nullptr, nullptr) != 1 ||
+        EVP_CIPHER_CTX_ctrl(decrypt_ctx, EVP_CTRL_GCM_SET_IVLEN, NONCE_SIZE, nullptr) != 1 ||
+        EVP_DecryptInit_ex(decrypt_ctx, nullptr, nullptr, key, nullptr) != 1) {
+        return false;
+    }
+
+    key_bits = static_cast<int>(size * 8);
+    return true;
+}
+
+uint32_t PacketCrypto::random_salt() {
+    uint32_t salt;
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&salt), sizeof(salt)) != 1) {
+        salt = std::random_device{}();
+    }
+    return salt;
+}
+
+void PacketCrypto::make_nonce(const unsigned char* header, uint32_t salt, unsigned char* nonce) const {
+    // Тип (без флага) и уровень — в старших байтах salt
+    uint8_t type = header[0] & ~protocol::PACKET_ENCRYPTED;
+    uint8_t tier = header[1];
+    protocol::put_u32(nonce, salt ^ (uint32_t(type) << 24 | uint32_t(tier) << 16));
+    memcpy(nonce + 4, header + 4, 8);    // ssrc и sequence
+}
+
+size_t PacketCrypto::seal(const unsigned char* packet, size_t size, uint32_t salt, unsigned char* out) {
+    if (!enabled() || size < protocol::HEADER_SIZE ||
+        size - protocol::HEADER_SIZE > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return 0;
+    }
+
+    memcpy(out, packet, protocol::HEADER_SIZE);
+    out[0] |= protocol::PACKET_ENCRYPTED;
+    protocol::put_u32(out + protocol::HEADER_SIZE, salt);
+
+    unsigned char nonce[NONCE_SIZE];
+    make_nonce(out, salt, nonce);
+
+    const int plain_size = static_cast<int>(size - protocol::HEADER_SIZE);
+    unsigned char* cipher_text = out + AAD_SIZE;
+    int length = 0, final_length = 0;
+    if (EVP_EncryptInit_ex(encrypt_ctx, nullptr, nullptr, nullptr, nonce) != 1 ||
+        EVP_EncryptUpdate(encrypt_ctx, nullptr, &length, out, AAD_SIZE) != 1 ||
+        EVP_EncryptUpdate(encrypt_ctx, cipher_text, &length, packet + protocol::HEADER_SIZE, plain_size) != 1 ||
+        EVP_EncryptFinal_ex(encrypt_ctx, cipher_text + length, &final_length) != 1 ||
+        EVP_CIPHER_CTX_ctrl(encrypt_ctx, EVP_CTRL_GCM_GET_TAG, TAG_SIZE,
+                            cipher_text + plain_size) != 1) {
+        return 0;
+    }
+    return size + OVERHEAD;
+}
+
+size_t PacketCrypto::open(const unsigned char* packet, size_t size, unsigned char* out, uint32_t* salt) {
+    if (!enabled() || size < AAD_SIZE + TAG_SIZE || !(packet[0] & protocol::PACKET_ENCRYPTED)) {
+        return 0;
+    }
+
+    uint32_t packet_salt = protocol::get_u32(packet + protocol::HEADER_SIZE);
+    unsigned char nonce[NONCE_SIZE];
+    make_nonce(packet, packet_salt, nonce);
+
+    const int cipher_size = static_cast<int>(size - AAD_SIZE - TAG_SIZE);
+    const unsigned char* cipher_text = packet + AAD_SIZE;
+    unsigned char tag[TAG_SIZE];
+    memcpy(tag, cipher_text + cipher_size, TAG_SIZE);
+
+    int length = 0, final_length = 0;
+    if (EVP_DecryptInit_ex(decrypt_ctx, nullptr, nullptr, nullptr, nonce) != 1 ||
+        EVP_DecryptUpdate(decrypt_ctx, nullptr, &length, packet, AAD_SIZE) != 1 ||
+        EVP_DecryptUpdate(decrypt_ctx, out + protocol::HEADER_SIZE, &length, cipher_text, cipher_size) != 1 ||
+        EVP_CIPHER_CTX_ctrl(decrypt_ctx, EVP_CTRL_GCM_SET_TAG, TAG_SIZE, tag) != 1 ||
+        EVP_DecryptFinal_ex(decrypt_ctx, out + protocol::HEADER_SIZE + length, &final_length) != 1) {
+        // Непроверенный открытый текст наружу не отдаем
+        memset(out + protocol::HEADER_SIZE, 0, cipher_size);
+        return 0;
+    }
+
+    memcpy(out, packet, protocol::HEADER_SIZE);
+    out[0] &= ~protocol::PACKET_ENCRYPTED;
+    if (salt) *salt = packet_salt;
+    return protocol::HEADER_SIZE + cipher_size;
+}
+
+bool ReplayWindow::accept(uint32_t sequence) {
+    if (!started) {
+        started = true;
+        highest = sequence;
+        seen = 1;
+        return true;
+    }
+
+    // Разность по модулю 2^32: номера заворачиваются
+    int32_t ahead = static_cast<int32_t>(sequence - highest);
+    if (ahead > 0) {
+        seen = ahead >= static_cast<int32_t>(SIZE) ? 0 : seen << ahead;
+        seen |= 1;
+        highest = sequence;
+        return true;
+    }
+
+    uint32_t behind = static_cast<uint32_t>(-ahead);
+    if (behind >= SIZE) return false;
+
+    uint64_t bit = uint64_t(1) << behind;
+    if (seen & bit) return false;
+    seen |= bit;
+    return true;
+}
+
+bool ReplayFilter::accept(const protocol::PacketHeader& header, uint32_t salt) {
+    Stream stream{salt, header.ssrc, static_cast<uint8_t>(header.type & ~protocol::PACKET_ENCRYPTED),
+                  header.tier};
+
+    auto it = windows.find(stream);
+    if (it == windows.end()) {
+        if (windows.size() >= MAX_STREAMS) {
+            auto oldest = std::min_element(windows.begin(), windows.end(), [](const auto& a, const auto& b) {
+                return a.second.last_used < b.second.last_used;
+            });
+            windows.erase(oldest);
+        }
+        it = windows.emplace(stream, Entry()).first;
+    }
+
+    it->second.last_used = ++clock;
+    return it->second.window.accept(header.sequence);
+}
@@ -0,0 +1,87 @@
+#include "../include/PipelineLatency.hpp"
+#include <cstdio>
+
+namespace {
+    constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+}
+
+PipelineLatency::PipelineLatency()
+    : last_report(std::make_unique<Snapshots>())
+    , last_report_ns(LatencyHistogram::now_ns()) {}
+
+std::unique_ptr<PipelineLatency::Snapshots> PipelineLatency::snapshot() const {
+    auto snapshots = std::make_unique<Snapshots>();
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        (*snapshots)[i] = stages[i].snapshot();
+    }
+    return snapshots;
+}
+
+const char* PipelineLatency::stage_name(Stage stage) {
+    switch (stage) {
+        case CAPTURE_PROCESS: return "capture_process";
+        case ENCODE: return "encode";
+        case SEND_QUEUE: return "send_queue";
+        case CAPTURE_TO_SEND: return "capture_to_send";
+        case RECEIVE_WAIT: return "receive_wait";
+        case DECODE: return "decode";
+        case JITTER_BUFFER: return "jitter_buffer";
+        case RECEIVE_TO_PLAYOUT: return "receive_to_playout";
+        case RELAY_SOCKET_WAIT: return "relay_socket_wait";
+        case RELAY_FORWARD: return "relay_forward";
+        case RELAY_TRANSCODE: return "relay_transcode";
+        default: return "unknown";
+    }
+}
+
+void PipelineLatency::write_metrics(metrics::Writer& out) const {
+    auto snapshots = snapshot();
+
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        const LatencyHistogram::Snapshot& s = (*snapshots)[i];
+        // Этапы другой стороны (клиент/ретранслятор) не выводим
+        if (s.count == 0) continue;
+
+        std::vector<std::pair<double, double>> quantiles;
+        for (double q : QUANTILES) {
+            quantiles.emplace_back(q, s.percentile(q) / 1e9);
+        }
+        out.summary("voice_stage_latency_seconds", "Latency of one pipeline stage",
+                    quantiles, s.sum_ns / 1e9, s.count,
+                    std::string("stage=\"") + stage_name(static_cast<Stage>(i)) + "\"");
+    }
+}
+
+std::string PipelineLatency::interval_report() {
+    auto current = snapshot();
+    uint64_t now = LatencyHistogram::now_ns();
+    double seconds = (now - last_report_ns) / 1e9;
+
+    std::string text;
+    char line[160];
+    snprintf(line, sizeof(line), "Stage latency, last %.1f s (ms):\n", seconds);
+    text += line;
+    snprintf(line, sizeof(line), "  %-20s %9s %9s %9s %9s %9s %9s\n",
+             "stage", "count", "mean", "p50", "p99", "p999", "max");
+    text += line;
+
+    bool any = false;
+    for (int i = 0; i < NUM_STAGES; ++i) {
+        LatencyHistogram::Snapshot delta = (*current)[i].since((*last_report)[i]);
+        if (delta.count == 0) continue;
+        any = true;
+
+        snprintf(line, sizeof(line), "  %-20s %9llu %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                 stage_name(static_cast<Stage>(i)), static_cast<unsigned long long>(delta.count),
+                 delta.mean_ns() / 1e6, delta.percentile(0.5) / 1e6, delta.percentile(0.99) / 1e6,
+                 delta.percentile(0.999) / 1e6, delta.max_ns / 1e6);
+        text += line;
+    }
+    if (!any) {
+        text += "  (no samples)\n";
+    }
+
+    last_report = std::move(current);
+    last_report_ns = now;
+    return text;
+}
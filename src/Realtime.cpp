@@ -0,0 +1,292 @@
+#include "../include/Realtime.hpp"
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+namespace realtime {
+
+    namespace {
+        std::mutex report_mutex;
+        std::condition_variable report_arrived;
+        std::vector<std::string> report_lines;
+        std::vector<std::string> expected_roles;
+        std::set<std::string> reported_roles;
+
+        bool all_reported() {
+            for (const auto& role : expected_roles) {
+                if (!reported_roles.count(role)) return false;
+            }
+            return true;
+        }
+
+        void add_report(const std::string& line) {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            report_lines.push_back(line);
+        }
+
+        const char* policy_name(int policy) {
+            switch (policy) {
+                case SCHED_FIFO: return "SCHED_FIFO";
+                case SCHED_RR: return "SCHED_RR";
+                default: return "SCHED_OTHER";
+            }
+        }
+
+        std::string describe(int policy, int priority) {
+            std::string text = policy_name(policy);
+            if (policy != SCHED_OTHER) text += " " + std::to_string(priority);
+            return text;
+        }
+
+        std::string describe(const std::vector<int>& cpus) {
+            if (cpus.empty()) return "any CPU";
+
+            std::string text = "CPUs ";
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                if (i > 0) text += ",";
+                text += std::to_string(cpus[i]);
+            }
+            return text;
+        }
+
+        std::vector<int> cpus_of(const cpu_set_t& set) {
+            std::vector<int> cpus;
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+
+        // Приоритет, который разрешен без CAP_SYS_NICE
+        int rtprio_limit() {
+            rlimit limit{};
+            if (getrlimit(RLIMIT_RTPRIO, &limit) != 0) return 0;
+            return limit.rlim_cur == RLIM_INFINITY ? 99 : static_cast<int>(limit.rlim_cur);
+        }
+
+        // Запрошенный приоритет, затем потолок RLIMIT_RTPRIO, затем обычный поток
+        std::string apply_scheduling(const ThreadPolicy& policy, bool& degraded) {
+            if (policy.policy == SCHED_OTHER) return "";
+
+            int min = sched_get_priority_min(policy.policy);
+            int max = sched_get_priority_max(policy.policy);
+            int priority = std::clamp(policy.priority, min, max);
+
+            sched_param param{};
+            param.sched_priority = priority;
+            int status = pthread_setschedparam(pthread_self(), policy.policy, &param);
+            if (status == 0) return "";
+
+            std::string reason = std::string(strerror(status));
+            int limit = rtprio_limit();
+            if (status == EPERM && limit >= min && limit < priority) {
+                param.sched_priority = limit;
+                if (pthread_setschedparam(pthread_self(), policy.policy, &param) == 0) {
+                    degraded = true;
+                    return "priority capped to RLIMIT_RTPRIO " + std::to_string(limit);
+                }
+            }
+
+            degraded = true;
+            return describe(policy.policy, priority) + " denied (" + reason +
+                   ", RLIMIT_RTPRIO " + std::to_string(limit) + "; need CAP_SYS_NICE)";
+        }
+
+        // Ядра вне разрешенных процессу (cgroup, taskset) отбрасываются
+        std::string apply_affinity(const ThreadPolicy& policy, bool& degraded) {
+            if (policy.cpus.empty()) return "";
+
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            sched_getaffinity(0, sizeof(allowed), &allowed);
+
+            cpu_set_t wanted;
+            CPU_ZERO(&wanted);
+            std::vector<int> dropped;
+            for (int cpu : policy.cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                    CPU_SET(cpu, &wanted);
+                } else {
+                    dropped.push_back(cpu);
+                }
+            }
+
+            if (CPU_COUNT(&wanted) == 0) {
+                degraded = true;
+                return "no requested CPU is available (" + describe(policy.cpus) + "), not pinned";
+            }
+
+            int status = pthread_setaffinity_np(pthread_self(), sizeof(wanted), &wanted);
+            if (status != 0) {
+                degraded = true;
+                return std::string("affinity failed (") + strerror(status) + ")";
+            }
+
+            if (!dropped.empty()) {
+                degraded = true;
+                return "skipped unavailable " + describe(dropped);
+            }
+            return "";
+        }
+
+        bool parse_cpus(const std::string& list, std::vector<int>& cpus) {
+            std::stringstream stream(list);
+            std::string item;
+            while (std::getline(stream, item, ',')) {
+                size_t dash = item.find('-');
+                char* end = nullptr;
+                long first = std::strtol(item.c_str(), &end, 10);
+                long last = first;
+                if (dash != std::string::npos) {
+                    last = std::strtol(item.c_str() + dash + 1, &end, 10);
+                }
+                if (item.empty() || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+                    return false;
+                }
+                for (long cpu = first; cpu <= last; ++cpu) cpus.push_back(static_cast<int>(cpu));
+            }
+            return !cpus.empty();
+        }
+    }
+
+    Config Config::defaults() {
+        Config config;
+        config.audio.policy = SCHED_FIFO;
+        config.audio.priority = 80;
+        config.network.policy = SCHED_FIFO;
+        config.network.priority = 70;
+        config.codec.policy = SCHED_RR;
+        config.codec.priority = 60;
+        config.lock_memory = true;
+        return config;
+    }
+
+    bool parse_policy(const std::string& spec, ThreadPolicy& out) {
+        ThreadPolicy policy;
+
+        size_t at = spec.find('@');
+        std::string head = spec.substr(0, at);
+        if (at != std::string::npos && !parse_cpus(spec.substr(at + 1), policy.cpus)) {
+            return false;
+        }
+
+        size_t colon = head.find(':');
+        std::string name = head.substr(0, colon);
+        if (name == "fifo") policy.policy = SCHED_FIFO;
+        else if (name == "rr") policy.policy = SCHED_RR;
+        else if (name == "other" || name.empty()) policy.policy = SCHED_OTHER;
+        else return false;
+
+        if (policy.policy != SCHED_OTHER) {
+            policy.priority = 50;
+            if (colon != std::string::npos) {
+                char* end = nullptr;
+                long priority = std::strtol(head.c_str() + colon + 1, &end, 10);
+                if (*end != '\0' || priority < 1 || priority > 99) return false;
+                policy.priority = static_cast<int>(priority);
+            }
+        } else if (colon != std::string::npos) {
+            return false;
+        }
+
+        out = policy;
+        return true;
+    }
+
+    void apply(const std::string& role, const ThreadPolicy& policy) {
+        if (!policy.configured()) return;
+
+        bool degraded = false;
+        std::string scheduling = apply_scheduling(policy, degraded);
+        std::string affinity = apply_affinity(policy, degraded);
+
+        // Проверяем, что действует на самом деле
+        int actual_policy = SCHED_OTHER;
+        sched_param param{};
+        pthread_getschedparam(pthread_self(), &actual_policy, &param);
+
+        cpu_set_t actual_cpus;
+        CPU_ZERO(&actual_cpus);
+        pthread_getaffinity_np(pthread_self(), sizeof(actual_cpus), &actual_cpus);
+
+        std::string line = std::string(degraded ? "⚠️  " : "⚡ ") + role + ": " +
+                           describe(actual_policy, param.sched_priority) + ", " +
+                           (policy.cpus.empty() ? "any CPU" : describe(cpus_of(actual_cpus)));
+        for (const std::string* note : {&scheduling, &affinity}) {
+            if (!note->empty()) line += " — " + *note;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            report_lines.push_back(line);
+            reported_roles.insert(role);
+        }
+        report_arrived.notify_all();
+    }
+
+    void expect(const std::string& role, const ThreadPolicy& policy) {
+        if (!policy.configured()) return;
+
+        std::lock_guard<std::mutex> lock(report_mutex);
+        expected_roles.push_back(role);
+    }
+
+    void lock_memory() {
+        rlimit limit{};
+        getrlimit(RLIMIT_MEMLOCK, &limit);
+        if (limit.rlim_cur != limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_MEMLOCK, &limit);
+        }
+
+        std::string allowed = limit.rlim_cur == RLIM_INFINITY
+            ? "unlimited" : std::to_string(limit.rlim_cur / 1024) + " KB";
+
+        // С ограниченным RLIMIT_MEMLOCK MCL_FUTURE опасен: стек нового потока
+        // или буфер сверх лимита уже не выделится. Тогда — только текущее
+        bool unlimited = limit.rlim_cur == RLIM_INFINITY || geteuid() == 0;
+        int flags = unlimited ? (MCL_CURRENT | MCL_FUTURE) : MCL_CURRENT;
+
+        if (mlockall(flags) == 0) {
+            add_report(unlimited ? "🔒 memory: locked (mlockall)"
+                                 : "⚠️  memory: current pages locked, future allocations not "
+                                   "(RLIMIT_MEMLOCK " + allowed + ")");
+            return;
+        }
+
+        add_report(std::string("⚠️  memory: mlockall failed (") + strerror(errno) +
+                   ", RLIMIT_MEMLOCK " + allowed + "), pages may fault");
+    }
+
+    void print_report(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(report_mutex);
+        report_arrived.wait_for(lock, timeout, all_reported);
+
+        std::vector<std::string> missing;
+        for (const auto& role : expected_roles) {
+            if (!reported_roles.count(role)) missing.push_back(role);
+        }
+        if (report_lines.empty() && missing.empty()) return;
+
+        std::cout << "Real-time settings:" << std::endl;
+        for (const auto& line : report_lines) {
+            std::cout << "  " << line << std::endl;
+        }
+        for (const auto& role : missing) {
+            std::cout << "  ⚠️  " << role << ": no report within " << timeout.count()
+                      << " ms, thread not started — settings unverified" << std::endl;
+        }
+        report_lines.clear();
+        expected_roles.clear();
+    }
+}
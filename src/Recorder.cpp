@@ -0,0 +1,176 @@
+#include "../include/Recorder.hpp"
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+namespace {
+    // Данные говорящего в начале записи: первая секунда не перераспределяет буфер
+    constexpr size_t INITIAL_BUFFER_BYTES = 256 * 1024;
+}
+
+Recorder::Recorder(std::string dir, std::vector<uint16_t> room_list)
+    : directory(std::move(dir))
+    , rooms(room_list.begin(), room_list.end())
+    , running(false)
+    , dropped_packets(0)
+    , idle_closed_streams(0)
+    , open_stream_count(0) {}
+
+bool Recorder::start() {
+    if (running) return true;
+
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "❌ Cannot create recording directory " << directory
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    incoming.reserve(INITIAL_BUFFER_BYTES);
+    writing.reserve(INITIAL_BUFFER_BYTES);
+
+    running = true;
+    thread = std::thread(&Recorder::io_loop, this);
+    std::cout << "⏺️  Recording to " << directory << std::endl;
+    return true;
+}
+
+void Recorder::stop() {
+    if (!running) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    // Поток уже остановлен: остаток и закрытие — здесь
+    write_batch(incoming, Clock::now());
+    incoming.clear();
+    for (auto& [key, stream] : streams) {
+        if (stream.writer) stream.writer->close();
+    }
+    streams.clear();
+    open_stream_count = 0;
+
+    if (dropped_packets > 0) {
+        std::cerr << "⚠️  Recorder dropped " << dropped_packets << " packets (disk too slow)" << std::endl;
+    }
+}
+
+void Recorder::record(const protocol::PacketHeader& header, const unsigned char* payload, size_t size) {
+    if (!running || size == 0 || size > UINT16_MAX || !records_room(header.room)) return;
+
+    Entry entry{header.ssrc, header.timestamp, header.room, static_cast<uint16_t>(size)};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (incoming.size() + sizeof(entry) + size > MAX_PENDING_BYTES) {
+        dropped_packets++;
+        return;
+    }
+
+    size_t offset = incoming.size();
+    incoming.resize(offset + sizeof(entry) + size);
+    memcpy(incoming.data() + offset, &entry, sizeof(entry));
+    memcpy(incoming.data() + offset + sizeof(entry), payload, size);
+}
+
+void Recorder::io_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, FLUSH_INTERVAL, [this] { return !running; });
+            if (!running) return;
+
+            writing.clear();
+            std::swap(incoming, writing);
+        }
+
+        Clock::time_point now = Clock::now();
+        write_batch(writing, now);
+        close_idle(now);
+    }
+}
+
+void Recorder::close_idle(Clock::time_point now) {
+    for (auto it = streams.begin(); it != streams.end();) {
+        if (now - it->second.last_packet < IDLE_TIMEOUT) {
+            ++it;
+            continue;
+        }
+
+        // Записи, которые не открылись, тоже забываются: ssrc мог вернуться
+        if (it->second.writer) {
+            it->second.writer->close();
+            idle_closed_streams++;
+            open_stream_count--;
+        }
+        it = streams.erase(it);
+    }
+}
+
+void Recorder::write_batch(const std::vector<unsigned char>& batch, Clock::time_point now) {
+    std::unordered_set<OggOpusWriter*> touched;
+
+    size_t offset = 0;
+    while (offset + sizeof(Entry) <= batch.size()) {
+        Entry entry;
+        memcpy(&entry, batch.data() + offset, sizeof(entry));
+        const unsigned char* payload = batch.data() + offset + sizeof(entry);
+        offset += sizeof(entry) + entry.size;
+
+        OggOpusWriter* stream = stream_for(entry, payload, now);
+        if (stream) {
+            stream->write(payload, entry.size, entry.timestamp);
+            touched.insert(stream);
+        }
+    }
+
+    // Один сброс на файл за пачку
+    for (OggOpusWriter* stream : touched) {
+        stream->flush();
+    }
+}
+
+OggOpusWriter* Recorder::stream_for(const Entry& entry, const unsigned char* payload, Clock::time_point now) {
+    uint64_t key = (uint64_t(entry.room) << 32) | entry.ssrc;
+    auto it = streams.find(key);
+    if (it != streams.end()) {
+        it->second.last_packet = now;
+        return it->second.writer.get();
+    }
+
+    char started[32];
+    time_t wall = time(nullptr);
+    tm local{};
+    localtime_r(&wall, &local);
+    strftime(started, sizeof(started), "%Y%m%d-%H%M%S", &local);
+
+    char name[96];
+    snprintf(name, sizeof(name), "/room%u-%08x-%s.opus", entry.room, entry.ssrc, started);
+    std::string path = directory + name;
+
+    // Каналы — из флага стерео в TOC первого пакета
+    int channels = (payload[0] & 0x04) ? 2 : 1;
+    std::vector<std::string> comments = {
+        "ROOM=" + std::to_string(entry.room),
+        "SSRC=" + std::to_string(entry.ssrc)
+    };
+
+    auto writer = std::make_unique<OggOpusWriter>();
+    if (!writer->open(path, entry.ssrc, channels, comments)) {
+        std::cerr << "❌ Cannot open " << path << ": " << strerror(errno) << std::endl;
+        // Не пытаемся открыть заново на каждом пакете
+        streams.emplace(key, Stream{nullptr, now});
+        return nullptr;
+    }
+
+    std::cout << "⏺️  Recording room " << entry.room << " speaker " << std::hex << entry.ssrc
+              << std::dec << " -> " << path << std::endl;
+    open_stream_count++;
+    return streams.emplace(key, Stream{std::move(writer), now}).first->second.writer.get();
+}
@@ -0,0 +1,830 @@
+#include "../include/Relay.hpp"
+#include <time.h>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <opus/opus.h>
+
+namespace {
+    // Длительность тика перекодирования — кадр 10 мс
+    constexpr auto TICK = std::chrono::milliseconds(10);
+    constexpr int MAX_FRAME_SAMPLES = 48000 * OpusCodec::MAX_FRAME_MS / 1000;
+    // Тысячи клиентов за миллисекунду опроса не должны переполнить сокет
+    constexpr int SOCKET_BUFFER_BYTES = 8 * 1024 * 1024;
+}
+
+Relay::Relay(size_t codec_threads, const realtime::Config& rt)
+    : running(false)
+    , rt_config(rt)
+    , node_id(PacketCrypto::random_salt())
+    // Конверт с ключом не длиннее датаграммы, которую примет сосед
+    , trunk_packet(DatagramBatch::MAX_DATAGRAM - PacketCrypto::OVERHEAD)
+    , scheduler(codec_threads, 48000, 1, [rt](size_t index) {
+        realtime::apply("relay codec " + std::to_string(index), rt.codec);
+        TRACE_THREAD("relay codec " + std::to_string(index));
+    }) {
+    for (size_t i = 0; i < scheduler.getThreadCount(); ++i) {
+        realtime::expect("relay codec " + std::to_string(i), rt.codec);
+    }
+}
+
+bool Relay::listen(int port) {
+    if (!network.start_server(port)) return false;
+
+    network.set_buffer_size(SOCKET_BUFFER_BYTES);
+    network.enable_timestamps();
+    return true;
+}
+
+bool Relay::add_peer(const std::string& address) {
+    size_t colon = address.rfind(':');
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    if (colon == std::string::npos ||
+        inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "❌ Invalid peer address '" << address << "' (expected IP:PORT)" << std::endl;
+        return false;
+    }
+
+    int port = std::atoi(address.c_str() + colon + 1);
+    if (port <= 0 || port > 65535) {
+        std::cerr << "❌ Invalid peer port in '" << address << "'" << std::endl;
+        return false;
+    }
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    Peer& peer = peers[client_key(addr)];
+    peer.addr = addr;
+    peer.key = client_key(addr);
+    std::cout << "🔗 Trunk peer " << describe(addr) << std::endl;
+    return true;
+}
+
+bool Relay::set_key(const std::string& hex) {
+    if (!crypto.set_key_hex(hex)) {
+        std::cerr << "❌ Session key must be 32 or 64 hex digits (AES-128/256)" << std::endl;
+        return false;
+    }
+
+    salt = PacketCrypto::random_salt();
+    opened = std::make_unique<OpenedBatch>();
+    trunk_opened.resize(DatagramBatch::MAX_DATAGRAM);
+    // Самый длинный исходящий пакет — перекодированная пачка
+    sealed_packet.resize(protocol::HEADER_SIZE + OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES +
+                         PacketCrypto::OVERHEAD);
+    std::cout << "🔒 Packets encrypted with AES-" << crypto.bits() << "-GCM" << std::endl;
+    return true;
+}
+
+void Relay::start() {
+    if (running) return;
+
+    if (recorder && !recorder->start()) {
+        std::cerr << "⚠️  Relaying without recording" << std::endl;
+        recorder.reset();
+    }
+
+    running = true;
+    realtime::expect("relay network", rt_config.network);
+    thread = std::thread(&Relay::network_loop, this);
+    thread_handle = thread.native_handle();
+}
+
+void Relay::stop() {
+    if (!running) return;
+
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    network.stop();
+
+    if (recorder) {
+        recorder->stop();
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    rooms.clear();
+    clients.clear();
+    for (auto& [key, peer] : peers) {
+        peer.up = false;
+        peer.rooms.clear();
+    }
+}
+
+size_t Relay::client_count() const {
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    return clients.size();
+}
+
+size_t Relay::peers_up() const {
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    size_t up = 0;
+    for (const auto& [key, peer] : peers) {
+        if (peer.up) up++;
+    }
+    return up;
+}
+
+double Relay::network_cpu_seconds() const {
+    if (!running) return 0.0;
+
+    clockid_t clock;
+    timespec ts{};
+    if (pthread_getcpuclockid(thread_handle, &clock) != 0 ||
+        clock_gettime(clock, &ts) != 0) {
+        return 0.0;
+    }
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void Relay::write_metrics(metrics::Writer& out) const {
+    out.counter("voice_relay_packets_received_total", "Datagrams received by the relay",
+                counters.packets_received.get());
+    out.counter("voice_relay_bytes_received_total", "Bytes received by the relay",
+                counters.bytes_received.get());
+    out.counter("voice_relay_invalid_packets_total", "Datagrams dropped with a malformed header",
+                counters.invalid_packets.get());
+    out.counter("voice_relay_packets_forwarded_total", "Datagrams sent to listeners",
+                counters.packets_forwarded.get());
+    out.counter("voice_relay_bytes_forwarded_total", "Bytes sent to listeners",
+                counters.bytes_forwarded.get());
+    out.counter("voice_relay_send_errors_total", "Datagrams the socket refused to send",
+                counters.send_errors.get());
+    if (crypto.enabled()) {
+        out.counter("voice_relay_auth_failures_total", "Datagrams dropped for a bad or missing authentication tag",
+                    counters.auth_failures.get());
+        out.counter("voice_relay_replayed_packets_total", "Authenticated datagrams dropped as replays",
+                    counters.replayed_packets.get());
+    }
+    out.counter("voice_relay_trunk_packets_sent_total", "Datagrams sent to peer relays",
+                counters.trunk_packets_sent.get());
+    out.counter("voice_relay_trunk_bytes_sent_total", "Bytes sent to peer relays",
+                counters.trunk_bytes_sent.get());
+    out.counter("voice_relay_trunk_rejected_total",
+                "Trunk packets from an address that is not a peer, or non-trunk packets from a peer",
+                counters.trunk_rejected.get());
+    out.counter("voice_relay_trunk_loops_total", "Trunk packets that came back to the node that sent them",
+                counters.trunk_loops.get());
+    out.counter("voice_relay_transcode_missed_total", "Transcode jobs that missed their tick",
+                transcode_missed());
+    out.counter("voice_relay_codec_streams_freed_total", "Opus decoder/encoder states freed after their speaker went idle",
+                counters.codec_streams_freed.get());
+    if (recorder) {
+        out.counter("voice_relay_recorder_dropped_total", "Packets the recorder could not keep up with",
+                    recorder->dropped());
+        out.counter("voice_relay_recorder_idle_closed_total", "Recordings closed after their speaker went idle",
+                    recorder->idle_closed());
+        out.gauge("voice_relay_recorder_open_files", "Recordings currently open",
+                  static_cast<double>(recorder->open_streams()));
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    out.gauge("voice_relay_clients", "Connected clients", static_cast<double>(clients.size()));
+    out.gauge("voice_relay_rooms", "Rooms with at least one client", static_cast<double>(rooms.size()));
+    for (const auto& [room, members] : rooms) {
+        out.gauge("voice_relay_room_clients", "Clients per room", static_cast<double>(members.size()),
+                  "room=\"" + std::to_string(room) + "\"");
+    }
+
+    // По метрике за проход: строки одного имени должны идти подряд
+    struct PerClient {
+        const char* name;
+        const char* help;
+        const metrics::Counter Client::*counter;
+    };
+    static const PerClient per_client[] = {
+        {"voice_relay_client_packets_received_total", "Datagrams received from the client", &Client::packets_in},
+        {"voice_relay_client_bytes_received_total", "Bytes received from the client", &Client::bytes_in},
+        {"voice_relay_client_packets_sent_total", "Datagrams forwarded to the client", &Client::packets_out},
+        {"voice_relay_client_bytes_sent_total", "Bytes forwarded to the client", &Client::bytes_out},
+    };
+
+    std::vector<std::pair<std::string, const Client*>> labelled;
+    labelled.reserve(clients.size());
+    for (const auto& [key, client] : clients) {
+        labelled.emplace_back("client=\"" + describe(client.addr) + "\",room=\"" +
+                              std::to_string(client.room) + "\"", &client);
+    }
+
+    for (const PerClient& metric : per_client) {
+        for (const auto& [labels, client] : labelled) {
+            out.counter(metric.name, metric.help, (client->*metric.counter).get(), labels);
+        }
+    }
+    for (const auto& [labels, client] : labelled) {
+        out.gauge("voice_relay_client_tier", "Bitrate tier sent to the client (0 = original)",
+                  client->tier, labels);
+    }
+
+    if (!peers.empty()) {
+        struct PerPeer {
+            const char* name;
+            const char* help;
+            const metrics::Counter Peer::*counter;
+        };
+        static const PerPeer per_peer[] = {
+            {"voice_relay_peer_packets_received_total", "Datagrams received over the trunk", &Peer::packets_in},
+            {"voice_relay_peer_bytes_received_total", "Bytes received over the trunk", &Peer::bytes_in},
+            {"voice_relay_peer_packets_sent_total", "Datagrams sent over the trunk", &Peer::packets_out},
+            {"voice_relay_peer_bytes_sent_total", "Bytes sent over the trunk", &Peer::bytes_out},
+        };
+
+        for (const PerPeer& metric : per_peer) {
+            for (const auto& [key, peer] : peers) {
+                out.counter(metric.name, metric.help, (peer.*metric.counter).get(),
+                            "peer=\"" + describe(peer.addr) + "\"");
+            }
+        }
+        for (const auto& [key, peer] : peers) {
+            out.gauge("voice_relay_peer_up", "Peer relay announced its rooms recently",
+                      peer.up ? 1.0 : 0.0, "peer=\"" + describe(peer.addr) + "\"");
+        }
+        for (const auto& [key, peer] : peers) {
+            out.gauge("voice_relay_peer_rooms", "Rooms with listeners on the peer relay",
+                      static_cast<double>(peer.rooms.size()), "peer=\"" + describe(peer.addr) + "\"");
+        }
+    }
+
+    stage_latency.write_metrics(out);
+}
+
+int Relay::tier_for_loss(int loss_permille) {
+    if (loss_permille < 20) return 0;
+    if (loss_permille < 80) return 1;
+    return 2;
+}
+
+std::string Relay::describe(const sockaddr_in& addr) {
+    char ip_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, ip_str, INET_ADDRSTRLEN);
+    return std::string(ip_str) + ":" + std::to_string(ntohs(addr.sin_port));
+}
+
+void Relay::network_loop() {
+    realtime::apply("relay network", rt_config.network);
+    TRACE_THREAD("relay network");
+
+    if (!batch) batch = std::make_unique<DatagramBatch>();
+
+    while (running) {
+        TRACE_BEGIN("relay_iteration");
+
+        // Забираем все, что накопилось, пачками recvmmsg; перекодируем пачкой
+        while (network.receive_batch(*batch) > 0) {
+            uint64_t received_ns = LatencyHistogram::now_ns();
+            if (crypto.enabled()) {
+                open_batch();
+            }
+
+            for (int i = 0; i < batch->count; ++i) {
+                if (batch->queued_ns[i] >= 0) {
+                    stage_latency.record(PipelineLatency::RELAY_SOCKET_WAIT,
+                                         static_cast<uint64_t>(batch->queued_ns[i]));
+                }
+
+                Incoming packet{batch->data[i], batch->size[i], batch->data[i], batch->size[i], 0};
+                if (crypto.enabled()) {
+                    packet.data = opened->data[i];
+                    packet.size = opened->size[i];
+                    packet.salt = opened->salt[i];
+                }
+                handle_packet(packet, batch->from[i], received_ns);
+            }
+
+            if (batch->count < DatagramBatch::CAPACITY) break;
+        }
+
+        if (pending_count > 0) {
+            transcode_pending();
+        }
+
+        if (!codec_last_used.empty()) {
+            expire_idle_codecs();
+        }
+
+        if (!peers.empty()) {
+            maintain_trunks();
+        }
+
+        TRACE_END("relay_iteration");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Relay::open_batch() {
+    TRACE_SCOPE("relay_open");
+    for (int i = 0; i < batch->count; ++i) {
+        opened->size[i] = crypto.open(batch->data[i], batch->size[i], opened->data[i], &opened->salt[i]);
+    }
+}
+
+bool Relay::seal(const unsigned char*& data, size_t& size) {
+    if (!crypto.enabled()) return true;
+    if (size + PacketCrypto::OVERHEAD > sealed_packet.size()) return false;
+
+    size = crypto.seal(data, size, salt, sealed_packet.data());
+    data = sealed_packet.data();
+    return size > 0;
+}
+
+void Relay::handle_packet(const Incoming& packet, const sockaddr_in& from, uint64_t received_ns) {
+    counters.packets_received.add();
+    counters.bytes_received.add(packet.wire_size);
+
+    // С ключом непроверенный пакет не заводит даже клиента
+    if (crypto.enabled() && packet.size == 0) {
+        counters.auth_failures.add();
+        return;
+    }
+
+    protocol::PacketHeader header;
+    if (!protocol::read_header(packet.data, packet.size, header)) {
+        counters.invalid_packets.add();
+        return;
+    }
+
+    if (crypto.enabled() && !replay.accept(header, packet.salt)) {
+        counters.replayed_packets.add();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+
+    ClientKey key = client_key(from);
+    if (!peers.empty()) {
+        auto peer = peers.find(key);
+        if (peer != peers.end()) {
+            handle_trunk_packet(peer->second, header, packet, received_ns);
+            return;
+        }
+    }
+    if (header.type == protocol::PACKET_TRUNK_ROOMS || header.type == protocol::PACKET_TRUNK_AUDIO) {
+        // Пакет транка не от настроенного соседа: клиента из него не заводим
+        counters.trunk_rejected.add();
+        return;
+    }
+
+    auto it = clients.find(key);
+    if (it == clients.end()) {
+        Client client;
+        client.addr = from;
+        client.key = key;
+        it = clients.emplace(key, client).first;
+        auto& lobby = rooms[0];
+        rooms_changed = rooms_changed || lobby.empty();
+        lobby.push_back(&it->second);
+        std::cout << "📱 New client connected: " << describe(from) << std::endl;
+    }
+
+    Client& client = it->second;
+    client.packets_in.add();
+    client.bytes_in.add(packet.wire_size);
+    if (client.room != header.room) {
+        join_room(client, header.room);
+    }
+
+    if (header.type == protocol::PACKET_RECEIVER_REPORT) {
+        protocol::ReceiverReport report;
+        if (protocol::read_report(packet.data + protocol::HEADER_SIZE,
+                                  packet.size - protocol::HEADER_SIZE, report)) {
+            handle_report(client, report);
+        }
+    } else if (header.type == protocol::PACKET_AUDIO && packet.size > protocol::HEADER_SIZE) {
+        handle_audio(header, packet, client.key, false, received_ns);
+    }
+}
+
+void Relay::handle_trunk_packet(Peer& peer, const protocol::PacketHeader& header,
+                                const Incoming& packet, uint64_t received_ns) {
+    peer.packets_in.add();
+    peer.bytes_in.add(packet.wire_size);
+    peer.last_heard = std::chrono::steady_clock::now();
+
+    if (header.type == protocol::PACKET_TRUNK_ROOMS) {
+        protocol::RoomAnnouncement announcement;
+        if (protocol::read_announcement(packet.data + protocol::HEADER_SIZE,
+                                        packet.size - protocol::HEADER_SIZE, announcement)) {
+            handle_announcement(peer, header, announcement);
+        } else {
+            counters.invalid_packets.add();
+        }
+    } else if (header.type == protocol::PACKET_TRUNK_AUDIO) {
+        handle_trunk_audio(peer, header, packet, received_ns);
+    } else {
+        // С адреса соседа принимаем только пакеты транка
+        counters.trunk_rejected.add();
+    }
+}
+
+void Relay::handle_trunk_audio(Peer& peer, const protocol::PacketHeader& envelope,
+                               const Incoming& packet, uint64_t received_ns) {
+    // Свой же пакет вернулся: узел указан соседом самому себе или адреса перепутаны
+    if (envelope.ssrc == node_id) {
+        counters.trunk_loops.add();
+        return;
+    }
+
+    const unsigned char* wire = packet.data + protocol::HEADER_SIZE;
+    const size_t wire_size = packet.size - protocol::HEADER_SIZE;
+    Incoming inner{wire, wire_size, wire, wire_size, 0};
+    if (crypto.enabled()) {
+        inner.data = trunk_opened.data();
+        inner.size = crypto.open(wire, wire_size, trunk_opened.data(), &inner.salt);
+        if (inner.size == 0) {
+            counters.auth_failures.add();
+            return;
+        }
+    }
+
+    protocol::PacketHeader header;
+    if (!protocol::read_header(inner.data, inner.size, header) ||
+        header.type != protocol::PACKET_AUDIO || inner.size <= protocol::HEADER_SIZE) {
+        counters.invalid_packets.add();
+        return;
+    }
+    if (crypto.enabled() && !replay.accept(header, inner.salt)) {
+        counters.replayed_packets.add();
+        return;
+    }
+
+    handle_audio(header, inner, peer.key, true, received_ns);
+}
+
+bool Relay::send_to_peers(const protocol::PacketHeader& header, const Incoming& packet) {
+    bool wanted = false;
+    for (const auto& [key, peer] : peers) {
+        wanted = wanted || (peer.up && peer.rooms.count(header.room));
+    }
+    if (!wanted) return false;
+
+    const size_t size = protocol::HEADER_SIZE + packet.wire_size;
+    if (size > trunk_packet.size()) {
+        counters.send_errors.add();
+        return false;
+    }
+
+    // Конверт один на всех соседей; исходные байты говорящего внутри
+    protocol::PacketHeader envelope;
+    envelope.type = protocol::PACKET_TRUNK_AUDIO;
+    envelope.room = header.room;
+    envelope.ssrc = node_id;
+    envelope.sequence = ++trunk_sequence;
+    envelope.timestamp = header.timestamp;
+    protocol::write_header(trunk_packet.data(), envelope);
+    memcpy(trunk_packet.data() + protocol::HEADER_SIZE, packet.wire, packet.wire_size);
+
+    const unsigned char* data = trunk_packet.data();
+    size_t sealed_size = size;
+    if (!seal(data, sealed_size)) {
+        counters.send_errors.add();
+        return false;
+    }
+
+    for (auto& [key, peer] : peers) {
+        if (peer.up && peer.rooms.count(header.room)) {
+            forward(peer, data, sealed_size);
+        }
+    }
+    return true;
+}
+
+void Relay::handle_announcement(Peer& peer, const protocol::PacketHeader& header,
+                                const protocol::RoomAnnouncement& announcement) {
+    // Новое объявление вытесняет недособранное старое
+    if (header.sequence != peer.incoming_generation || announcement.parts != peer.incoming_parts) {
+        peer.incoming_generation = header.sequence;
+        peer.incoming_parts = announcement.parts;
+        peer.incoming_received.assign(announcement.parts, false);
+        peer.incoming_rooms.clear();
+    }
+    if (peer.incoming_received[announcement.part]) return;
+
+    peer.incoming_received[announcement.part] = true;
+    for (size_t i = 0; i < announcement.room_count; ++i) {
+        peer.incoming_rooms.insert(announcement.room(i));
+    }
+
+    if (std::find(peer.incoming_received.begin(), peer.incoming_received.end(), false)
+        != peer.incoming_received.end()) {
+        return;
+    }
+
+    peer.rooms.swap(peer.incoming_rooms);
+    peer.incoming_rooms.clear();
+    // Следующая часть с тем же номером — повтор, не начало нового сбора
+    std::fill(peer.incoming_received.begin(), peer.incoming_received.end(), true);
+
+    if (!peer.up) {
+        peer.up = true;
+        // Сосед мог перезапуститься: пусть сразу узнает и наши комнаты
+        rooms_changed = true;
+        std::cout << "🔗 Trunk up: " << describe(peer.addr) << " (" << peer.rooms.size()
+                  << " rooms)" << std::endl;
+    }
+}
+
+void Relay::forward(Client& client, const unsigned char* data, size_t size) {
+    if (!network.send_to(data, size, client.addr)) {
+        counters.send_errors.add();
+        return;
+    }
+
+    counters.packets_forwarded.add();
+    counters.bytes_forwarded.add(size);
+    client.packets_out.add();
+    client.bytes_out.add(size);
+}
+
+void Relay::forward(Peer& peer, const unsigned char* data, size_t size) {
+    if (!network.send_to(data, size, peer.addr)) {
+        counters.send_errors.add();
+        return;
+    }
+
+    counters.trunk_packets_sent.add();
+    counters.trunk_bytes_sent.add(size);
+    peer.packets_out.add();
+    peer.bytes_out.add(size);
+}
+
+void Relay::join_room(Client& client, uint16_t room) {
+    auto& members = rooms[client.room];
+    members.erase(std::remove(members.begin(), members.end(), &client), members.end());
+    if (members.empty()) {
+        rooms.erase(client.room);
+        rooms_changed = true;
+    }
+
+    client.room = room;
+    auto& joined = rooms[room];
+    rooms_changed = rooms_changed || joined.empty();
+    joined.push_back(&client);
+}
+
+void Relay::maintain_trunks() {
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    for (auto& [key, peer] : peers) {
+        if (peer.up && now - peer.last_heard > PEER_TIMEOUT) {
+            peer.up = false;
+            peer.rooms.clear();
+            std::cout << "🔌 Trunk down: " << describe(peer.addr) << std::endl;
+        }
+    }
+
+    if (rooms_changed || now - last_announcement >= ANNOUNCE_INTERVAL) {
+        announce_rooms();
+        rooms_changed = false;
+        last_announcement = now;
+    }
+}
+
+void Relay::announce_rooms() {
+    std::vector<uint16_t> local_rooms;
+    local_rooms.reserve(rooms.size());
+    for (const auto& [room, members] : rooms) {
+        local_rooms.push_back(room);
+    }
+
+    const size_t parts = std::max<size_t>(1, (local_rooms.size() + protocol::ANNOUNCEMENT_MAX_ROOMS - 1)
+                                                 / protocol::ANNOUNCEMENT_MAX_ROOMS);
+    protocol::PacketHeader header;
+    header.type = protocol::PACKET_TRUNK_ROOMS;
+    header.sequence = ++announcement_generation;
+
+    unsigned char packet[protocol::HEADER_SIZE + protocol::ANNOUNCEMENT_HEADER_SIZE +
+                         2 * protocol::ANNOUNCEMENT_MAX_ROOMS];
+
+    for (size_t part = 0; part < parts; ++part) {
+        // ssrc — номер части: у частей одного поколения разные nonce и окна повторов
+        header.ssrc = static_cast<uint32_t>(part);
+        protocol::write_header(packet, header);
+        size_t first = part * protocol::ANNOUNCEMENT_MAX_ROOMS;
+        size_t count = std::min(protocol::ANNOUNCEMENT_MAX_ROOMS, local_rooms.size() - std::min(first, local_rooms.size()));
+        size_t size = protocol::HEADER_SIZE +
+                      protocol::write_announcement(packet + protocol::HEADER_SIZE, static_cast<uint16_t>(part),
+                                                   static_cast<uint16_t>(parts), local_rooms.data() + first, count);
+        const unsigned char* data = packet;
+        if (!seal(data, size)) continue;
+
+        for (auto& [key, peer] : peers) {
+            forward(peer, data, size);
+        }
+    }
+}
+
+void Relay::handle_report(Client& client, const protocol::ReceiverReport& report) {
+    int target = tier_for_loss(report.loss_permille);
+
+    // Вниз — сразу, вверх — на один уровень после серии хороших отчетов
+    if (target > client.tier) {
+        client.tier = target;
+        client.good_reports = 0;
+    } else if (target < client.tier) {
+        if (++client.good_reports >= UPGRADE_REPORTS) {
+            client.tier--;
+            client.good_reports = 0;
+        }
+    } else {
+        client.good_reports = 0;
+    }
+}
+
+void Relay::handle_audio(const protocol::PacketHeader& header, const Incoming& packet,
+                         ClientKey sender, bool from_trunk, uint64_t received_ns) {
+    if (recorder) {
+        recorder->record(header, packet.data + protocol::HEADER_SIZE, packet.size - protocol::HEADER_SIZE);
+    }
+
+    TRACE_SCOPE("relay_fanout");
+    unsigned tier_mask = 0;
+    bool forwarded = false;
+
+    // Соседям — исходные байты в конверте, один раз; перекодирует узел слушателя
+    if (!from_trunk && !peers.empty()) {
+        forwarded = send_to_peers(header, packet);
+    }
+
+    auto members = rooms.find(header.room);
+    if (members == rooms.end()) {
+        if (forwarded) {
+            stage_latency.record_since(PipelineLatency::RELAY_FORWARD, received_ns);
+        }
+        return;
+    }
+
+    for (Client* client : members->second) {
+        if (client->key == sender) continue;
+
+        if (client->tier == 0) {
+            forward(*client, packet.wire, packet.wire_size);
+            forwarded = true;
+        } else {
+            tier_mask |= 1u << client->tier;
+        }
+    }
+    if (forwarded) {
+        stage_latency.record_since(PipelineLatency::RELAY_FORWARD, received_ns);
+    }
+
+    if (tier_mask == 0) return;
+
+    if (pending_count == pending.size()) {
+        pending.emplace_back();
+    }
+
+    Transcode& job = pending[pending_count];
+    job.payload.resize(OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES);
+    job.frames = bundler.split(packet.data + protocol::HEADER_SIZE,
+                               static_cast<int>(packet.size - protocol::HEADER_SIZE),
+                               job.payload.data(), static_cast<int>(job.payload.size()),
+                               job.frame_bytes.data(), OpusBundler::MAX_FRAMES);
+    if (job.frames <= 0) return;
+
+    job.header = header;
+    job.sender = sender;
+    job.tier_mask = tier_mask;
+    job.received_ns = received_ns;
+    job.decoded = false;
+    pending_count++;
+}
+
+void Relay::transcode_pending() {
+    TRACE_SCOPE("relay_transcode");
+    auto now = CodecScheduler::Clock::now();
+    auto deadline = now + TICK;
+
+    // 1. Декодируем исходные кадры, подряд в pcm
+    for (size_t i = 0; i < pending_count; ++i) {
+        Transcode& job = pending[i];
+        job.pcm.resize(MAX_FRAME_SAMPLES);
+        codec_last_used[job.header.ssrc] = now;
+
+        const unsigned char* frame = job.payload.data();
+        int offset = 0;
+        for (int f = 0; f < job.frames; ++f) {
+            job.frame_samples[f] = opus_packet_get_nb_samples(frame, job.frame_bytes[f], 48000);
+            if (job.frame_samples[f] <= 0 || offset + job.frame_samples[f] > MAX_FRAME_SAMPLES) {
+                job.frames = f;
+                break;
+            }
+
+            job.decode_jobs[f] = scheduler.addDecode(codec_key(job.header.ssrc, 0), frame, job.frame_bytes[f],
+                                                     job.pcm.data() + offset, job.frame_samples[f]);
+            frame += job.frame_bytes[f];
+            offset += job.frame_samples[f];
+        }
+    }
+    scheduler.run(deadline);
+
+    for (size_t i = 0; i < pending_count; ++i) {
+        Transcode& job = pending[i];
+        job.decoded = job.frames > 0;
+        for (int f = 0; f < job.frames; ++f) {
+            const CodecScheduler::Job& decoded = scheduler.job(job.decode_jobs[f]);
+            job.decoded = job.decoded && decoded.status == CodecScheduler::Job::DONE
+                          && decoded.result == job.frame_samples[f];
+        }
+    }
+
+    // 2. Кодируем по одному разу на каждый нужный уровень
+    for (size_t i = 0; i < pending_count; ++i) {
+        Transcode& job = pending[i];
+        if (!job.decoded) continue;
+
+        for (int tier = 1; tier < NUM_TIERS; ++tier) {
+            if (!(job.tier_mask & (1u << tier))) continue;
+
+            uint64_t key = codec_key(job.header.ssrc, tier);
+            if (configured_encoders.insert(key).second) {
+                scheduler.codec(key).setBitrate(TIER_BITRATES[tier]);
+            }
+
+            auto& out = job.encoded[tier];
+            out.resize(OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES);
+            int offset = 0;
+            for (int f = 0; f < job.frames; ++f) {
+                job.encode_jobs[tier][f] = scheduler.addEncode(key, job.pcm.data() + offset, job.frame_samples[f],
+                                                               out.data() + f * OpusBundler::MAX_FRAME_BYTES,
+                                                               OpusBundler::MAX_FRAME_BYTES);
+                offset += job.frame_samples[f];
+            }
+        }
+    }
+    scheduler.run(deadline);
+
+    // 3. Склеиваем кадры уровня и рассылаем; опоздавшие пакеты не отправляем
+    out_packet.resize(protocol::HEADER_SIZE + OpusBundler::MAX_FRAMES * OpusBundler::MAX_FRAME_BYTES);
+
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    for (size_t i = 0; i < pending_count; ++i) {
+        Transcode& job = pending[i];
+        if (!job.decoded) continue;
+
+        for (int tier = 1; tier < NUM_TIERS; ++tier) {
+            if (!(job.tier_mask & (1u << tier))) continue;
+
+            bool complete = true;
+            for (int f = 0; f < job.frames && complete; ++f) {
+                const CodecScheduler::Job& encoded = scheduler.job(job.encode_jobs[tier][f]);
+                complete = encoded.status == CodecScheduler::Job::DONE && encoded.result > 0
+                           && bundler.add(job.encoded[tier].data() + f * OpusBundler::MAX_FRAME_BYTES,
+                                          encoded.result);
+            }
+
+            int bytes = bundler.flush(out_packet.data() + protocol::HEADER_SIZE,
+                                      static_cast<int>(out_packet.size() - protocol::HEADER_SIZE));
+            if (!complete || bytes <= 0) continue;
+
+            protocol::PacketHeader header = job.header;
+            header.tier = static_cast<uint8_t>(tier);
+            protocol::write_header(out_packet.data(), header);
+            size_t size = protocol::HEADER_SIZE + bytes;
+            const unsigned char* data = out_packet.data();
+            if (!seal(data, size)) continue;
+
+            // Комната могла опустеть за тик: пустую не создаем, ее бы объявили соседям
+            auto members = rooms.find(job.header.room);
+            if (members == rooms.end()) continue;
+
+            for (Client* client : members->second) {
+                if (client->tier == tier && client->key != job.sender) {
+                    forward(*client, data, size);
+                }
+            }
+            stage_latency.record_since(PipelineLatency::RELAY_TRANSCODE, job.received_ns);
+        }
+    }
+
+    pending_count = 0;
+}
+
+void Relay::expire_idle_codecs() {
+    auto now = CodecScheduler::Clock::now();
+    if (now - last_codec_sweep < CODEC_SWEEP_INTERVAL) return;
+    last_codec_sweep = now;
+
+    for (auto it = codec_last_used.begin(); it != codec_last_used.end();) {
+        if (now - it->second < CODEC_IDLE_TIMEOUT) {
+            ++it;
+            continue;
+        }
+
+        // Декодер (уровень 0) и кодеры тех уровней, что заводились
+        scheduler.removeStream(codec_key(it->first, 0));
+        uint64_t freed = 1;
+        for (int tier = 1; tier < NUM_TIERS; ++tier) {
+            uint64_t key = codec_key(it->first, tier);
+            if (configured_encoders.erase(key) > 0) {
+                scheduler.removeStream(key);
+                freed++;
+            }
+        }
+        counters.codec_streams_freed.add(freed);
+        it = codec_last_used.erase(it);
+    }
+}
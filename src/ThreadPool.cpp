@@ -0,0 +1,113 @@
+#include "../include/ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads, std::function<void(size_t)> threadInit)
+    : threadInit_(std::move(threadInit)) {
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->ring.resize(INITIAL_CAPACITY);
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Worker::pushBack(std::function<void()>&& task) {
+    if (count == ring.size()) {
+        // Переполнение: кольцо удваивается, задачи переносятся по порядку
+        std::vector<std::function<void()>> grown(ring.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(ring[(head + i) & (ring.size() - 1)]);
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+
+    ring[(head + count) & (ring.size() - 1)] = std::move(task);
+    count++;
+}
+
+void ThreadPool::Worker::popBack(std::function<void()>& task) {
+    count--;
+    task = std::move(ring[(head + count) & (ring.size() - 1)]);
+    ring[(head + count) & (ring.size() - 1)] = nullptr;
+}
+
+void ThreadPool::Worker::popFront(std::function<void()>& task) {
+    task = std::move(ring[head]);
+    ring[head] = nullptr;
+    head = (head + 1) & (ring.size() - 1);
+    count--;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Внешние задачи раскладываем по очередям по кругу
+    size_t index = nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    // Счетчик растет раньше вставки, чтобы не уйти в минус при мгновенной краже
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->pushBack(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::popTask(size_t index, std::function<void()>& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.count == 0) return false;
+
+    worker.popBack(task);
+    return true;
+}
+
+bool ThreadPool::stealTask(size_t thief, std::function<void()>& task) {
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim = *workers_[(thief + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.count == 0) continue;
+
+        victim.popFront(task);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    if (threadInit_) threadInit_(index);
+
+    std::function<void()> task;
+
+    while (true) {
+        if (popTask(index, task) || stealTask(index, task)) {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || pending_.load(std::memory_order_relaxed) > 0; });
+        if (stopping_ && pending_.load(std::memory_order_relaxed) == 0) return;
+    }
+}
@@ -0,0 +1,223 @@
+#include "../include/Trace.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trace {
+
+    namespace detail {
+        std::atomic<bool> enabled(false);
+    }
+
+    namespace {
+        constexpr size_t MAX_NAME = 32;
+
+        struct Event {
+            uint64_t ns;
+            const char* name;
+            Phase phase;
+        };
+
+        // Кольцо одного потока. head пишет только владелец; читатель
+        // сверяет head до и после копирования
+        struct Buffer {
+            std::vector<Event> events;
+            std::atomic<uint64_t> head{0};
+            uint32_t tid = 0;
+            char name[MAX_NAME] = {};    // под registry_mutex после публикации
+            std::atomic<bool> claimed{false};   // имя записано, кольцо читаемо
+        };
+
+        // Кольца выделяет enable() и они живут до конца процесса: поток мог
+        // завершиться до выгрузки. Потоки разбирают их по next_buffer
+        std::mutex registry_mutex;
+        std::unique_ptr<Buffer[]> registry;
+        std::atomic<size_t> registry_size(0);
+        std::atomic<size_t> next_buffer(0);
+        std::atomic<size_t> untraced(0);
+
+        thread_local Buffer* local = nullptr;
+        thread_local bool local_untraced = false;
+        thread_local char local_name[MAX_NAME] = {};
+
+        uint64_t now_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void copy_name(char* out, const std::string& name) {
+            size_t length = std::min(name.size(), MAX_NAME - 1);
+            memcpy(out, name.data(), length);
+            out[length] = '\0';
+        }
+
+        // Забрать готовое кольцо: без блокировок и выделения памяти
+        Buffer* claim_buffer() {
+            if (local_untraced) return nullptr;
+
+            size_t index = next_buffer.fetch_add(1, std::memory_order_relaxed);
+            if (index >= registry_size.load(std::memory_order_acquire)) {
+                local_untraced = true;
+                untraced.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Buffer* buffer = &registry[index];
+            if (local_name[0]) {
+                memcpy(buffer->name, local_name, MAX_NAME);
+            } else {
+                snprintf(buffer->name, MAX_NAME, "thread %u", buffer->tid);
+            }
+            buffer->claimed.store(true, std::memory_order_release);
+            return buffer;
+        }
+
+        void write_escaped(FILE* file, const char* text) {
+            for (; *text; ++text) {
+                char c = *text;
+                if (c == '"' || c == '\\') fputc('\\', file);
+                if (static_cast<unsigned char>(c) >= 0x20) fputc(c, file);
+            }
+        }
+    }
+
+    namespace detail {
+        void record(Phase phase, const char* name) {
+            if (!local && !(local = claim_buffer())) return;
+
+            uint64_t head = local->head.load(std::memory_order_relaxed);
+            local->events[head % local->events.size()] = Event{now_ns(), name, phase};
+            local->head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    void enable(size_t events_per_thread, size_t threads) {
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            if (!registry) {
+                const size_t capacity = events_per_thread > 0 ? events_per_thread : DEFAULT_CAPACITY;
+                const size_t count = threads > 0 ? threads : std::thread::hardware_concurrency() + EXTRA_THREADS;
+
+                registry.reset(new Buffer[count]);
+                for (size_t i = 0; i < count; ++i) {
+                    registry[i].events.resize(capacity);
+                    registry[i].tid = static_cast<uint32_t>(i + 1);
+                }
+                registry_size.store(count, std::memory_order_release);
+            }
+        }
+        detail::enabled = true;
+    }
+
+    void disable() {
+        detail::enabled = false;
+    }
+
+    void set_thread_name(const std::string& name) {
+        copy_name(local_name, name);
+
+        // Еще без кольца: имя попадет в него при захвате
+        if (!local) {
+            if (enabled()) local = claim_buffer();
+            return;
+        }
+
+        // Переименование опубликованного кольца — под блокировкой читателя
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        memcpy(local->name, local_name, MAX_NAME);
+    }
+
+    size_t untraced_threads() {
+        return untraced.load(std::memory_order_relaxed);
+    }
+
+    long write_json(const std::string& path) {
+        struct ThreadEvents {
+            uint32_t tid;
+            std::string name;
+            std::vector<Event> events;
+        };
+        std::vector<ThreadEvents> threads;
+
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            const size_t count = registry_size.load(std::memory_order_acquire);
+            for (size_t b = 0; b < count; ++b) {
+                const Buffer& buffer = registry[b];
+                if (!buffer.claimed.load(std::memory_order_acquire)) continue;
+
+                ThreadEvents copy{buffer.tid, buffer.name, {}};
+                const size_t size = buffer.events.size();
+
+                uint64_t head = buffer.head.load(std::memory_order_acquire);
+                uint64_t first = head > size ? head - size : 0;
+                copy.events.reserve(head - first);
+                for (uint64_t i = first; i < head; ++i) {
+                    copy.events.push_back(buffer.events[i % size]);
+                }
+
+                // Что владелец успел перезаписать, пока мы копировали, — мусор.
+                // Слот after % size мог писаться в момент чтения (head еще не
+                // сдвинут), поэтому доверяем только индексам от after + 1 - size.
+                // Барьер: чтение событий выше не переставляется за второе чтение head
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t after = buffer.head.load(std::memory_order_relaxed);
+                uint64_t valid = after + 1 > size ? after + 1 - size : 0;
+                if (valid > first) {
+                    size_t skip = static_cast<size_t>(std::min<uint64_t>(valid - first, copy.events.size()));
+                    copy.events.erase(copy.events.begin(), copy.events.begin() + skip);
+                }
+                threads.push_back(std::move(copy));
+            }
+        }
+
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) return -1;
+
+        // Отсчет от самого раннего события — короче числа в файле
+        uint64_t origin = UINT64_MAX;
+        for (const auto& thread : threads) {
+            if (!thread.events.empty()) origin = std::min(origin, thread.events.front().ns);
+        }
+
+        const int pid = static_cast<int>(getpid());
+        long written = 0;
+        const char* separator = "\n";
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        for (const auto& thread : threads) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"",
+                    separator, pid, thread.tid);
+            write_escaped(file, thread.name.c_str());
+            fprintf(file, "\"}}");
+            separator = ",\n";
+
+            // Начало кольца могло срезать begin: непарные end пропускаем
+            int depth = 0;
+            for (const Event& event : thread.events) {
+                if (event.phase == BEGIN) {
+                    depth++;
+                } else if (event.phase == END) {
+                    if (depth == 0) continue;
+                    depth--;
+                }
+
+                double us = (event.ns - origin) / 1e3;
+                fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u%s}",
+                        separator, event.name, static_cast<char>(event.phase), us, pid, thread.tid,
+                        event.phase == INSTANT ? ",\"s\":\"t\"" : "");
+                written++;
+            }
+        }
+        fprintf(file, "\n]}\n");
+
+        bool ok = fclose(file) == 0;
+        return ok ? written : -1;
+    }
+}
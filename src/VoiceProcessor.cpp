@@ -1,4 +1,5 @@
 #include "../include/VoiceProcessor.hpp"
+#include "../include/DspKernels.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -14,37 +15,40 @@ VoiceProcessor::VoiceProcessor(int sampleRate, int frameSize)
 void VoiceProcessor::setMode(ProcessingMode mode) {
     mode_ = mode;
 
-    switch (mode) {
-        case MODE_AGGRESSIVE:
-            setNoiseReduction(20.0f);
-            if (noiseSuppressor_) {
-                noiseSuppressor_->setSmoothing(0.95f, 0.5f);
-                noiseSuppressor_->setSuppressionType(NoiseSuppressor::WIENER);
-            }
-            break;
-        case MODE_STANDARD:
-            setNoiseReduction(15.0f);
-            if (noiseSuppressor_) {
-                noiseSuppressor_->setSmoothing(0.98f, 0.7f);
-                noiseSuppressor_->setSuppressionType(NoiseSuppressor::MMSE);
-            }
-            break;
-        case MODE_CONSERVATIVE:
-            setNoiseReduction(10.0f);
-            if (noiseSuppressor_) {
-                noiseSuppressor_->setSmoothing(0.99f, 0.8f);
-                noiseSuppressor_->setSuppressionType(NoiseSuppressor::SPECTRAL_GATING);
-            }
-            break;
-        case MODE_AUTO:
-            setNoiseReduction(12.0f);
-            if (noiseSuppressor_) {
-                noiseSuppressor_->setSmoothing(0.97f, 0.6f);
-            }
-            break;
+    ModeSettings settings = settingsFor(mode);
+    setNoiseReduction(settings.reductionDb);
+    if (noiseSuppressor_) {
+        noiseSuppressor_->setSmoothing(settings.timeSmoothing, settings.freqSmoothing);
+        if (settings.setsType) {
+            noiseSuppressor_->setSuppressionType(settings.type);
+        }
     }
 }
 
+bool VoiceProcessor::enableBandSplit(bool enable) {
+    if (enable == isBandSplitEnabled()) return true;
+
+    if (enable) {
+        if (sampleRate_ != 48000 || frameSize_ % BandSplitter::DECIMATION != 0) {
+            return false;
+        }
+
+        const int lowSize = frameSize_ / BandSplitter::DECIMATION;
+        noiseSuppressor_ = std::make_unique<NoiseSuppressor>(sampleRate_ / BandSplitter::DECIMATION, lowSize);
+        // Верхняя полоса ждет подавитель нижней
+        bandSplitter_ = std::make_unique<BandSplitter>(frameSize_, noiseSuppressor_->getLatency());
+        lowBand_.resize(lowSize);
+    } else {
+        bandSplitter_.reset();
+        lowBand_.clear();
+        noiseSuppressor_ = std::make_unique<NoiseSuppressor>(sampleRate_, frameSize_);
+    }
+
+    // Новый подавитель получает настройки текущего режима
+    setMode(mode_);
+    return true;
+}
+
 void VoiceProcessor::setNoiseReduction(float db) {
     if (noiseSuppressor_) {
         noiseSuppressor_->setReduction(db);
@@ -54,11 +58,25 @@ void VoiceProcessor::setNoiseReduction(float db) {
 void VoiceProcessor::setMinGain(float gain) {
     // Метод для совместимости, но minGain теперь в NoiseSuppressor
     // Можно добавить если нужно
+    (void)gain;
 }
 
 void VoiceProcessor::calibrateNoise(const std::vector<float>& noiseSample) {
-    if (noiseSuppressor_) {
-        noiseSuppressor_->calibrateNoise(noiseSample);
+    if (noiseSample.size() != static_cast<size_t>(frameSize_)) return;
+    calibrateNoise(noiseSample.data());
+}
+
+void VoiceProcessor::calibrateNoise(const float* noiseSample) {
+    if (!noiseSuppressor_) return;
+
+    if (bandSplitter_) {
+        // Отдельный банк фильтров, чтобы не сбить состояние основного
+        BandSplitter splitter(frameSize_);
+        std::vector<float> lowBand(splitter.getLowBandSize());
+        splitter.analyze(noiseSample, lowBand.data());
+        noiseSuppressor_->calibrateNoise(lowBand);
+    } else {
+        noiseSuppressor_->calibrateNoise(std::vector<float>(noiseSample, noiseSample + frameSize_));
     }
 }
 
@@ -67,111 +85,48 @@ std::vector<float> VoiceProcessor::process(const std::vector<float>& frame) {
         return frame;
     }
 
-    std::vector<float> processed = frame;
+    std::vector<float> processed(frameSize_);
+    process(frame.data(), processed.data());
+    return processed;
+}
+
+void VoiceProcessor::process(const float* in, float* out) {
+    if (in != out) {
+        std::copy(in, in + frameSize_, out);
+    }
 
     // 1. DC фильтр
-    applyDcFilter(processed);
+    dsp::dcFilter(out, frameSize_, dcOffset_, dcAlpha_);
 
     // 2. Измерение входного уровня
-    inputLevelDb_ = calculateRmsDb(processed);
+    inputLevelDb_ = dsp::rmsDb(out, frameSize_);
 
     // 3. Подавление шума
     if (nsEnabled_ && noiseSuppressor_) {
-        processed = noiseSuppressor_->process(processed);
+        if (bandSplitter_) {
+            // Полная обработка только в полосе речи, верхняя — общим усилением
+            bandSplitter_->analyze(out, lowBand_.data());
+            std::vector<float> lowBand = noiseSuppressor_->process(lowBand_);
+            bandSplitter_->synthesize(lowBand.data(), noiseSuppressor_->getUpperBandGain(), out);
+        } else {
+            std::vector<float> denoised = noiseSuppressor_->process(std::vector<float>(out, out + frameSize_));
+            std::copy(denoised.begin(), denoised.end(), out);
+        }
     }
 
     // 4. Автогейн
     if (agcEnabled_) {
-        applyAutoGain(processed);
+        dsp::autoGain(out, frameSize_, targetLevelDb_, minGainDb_, maxGainDb_, currentGain_);
     }
 
     // 5. Лимитер
     if (limiterEnabled_) {
-        applyLimiter(processed);
+        dsp::limiter(out, frameSize_, limiterEnvelope_, clipCount_);
     }
 
     // 6. Измерение выходного уровня
-    outputLevelDb_ = calculateRmsDb(processed);
-    peakLevelDb_ = std::max(peakLevelDb_, calculatePeakDb(processed));
-
-    return processed;
-}
-
-void VoiceProcessor::applyDcFilter(std::vector<float>& frame) {
-    for (float& sample : frame) {
-        dcOffset_ = dcAlpha_ * dcOffset_ + (1.0f - dcAlpha_) * sample;
-        sample -= dcOffset_;
-    }
-}
-
-void VoiceProcessor::applyAutoGain(std::vector<float>& frame) {
-    float currentDb = calculateRmsDb(frame);
-
-    // Вычисляем желаемое усиление
-    float desiredGainDb = targetLevelDb_ - currentDb;
-
-    // Ограничиваем максимальное усиление
-    desiredGainDb = std::clamp(desiredGainDb, minGainDb_, maxGainDb_);
-
-    // Плавное изменение gain
-    float targetGain = powf(10.0f, desiredGainDb / 20.0f);
-    float alpha = (targetGain > currentGain_) ? 0.1f : 0.01f; // Разные скорости
-
-    currentGain_ = alpha * targetGain + (1.0f - alpha) * currentGain_;
-
-    // Применяем gain
-    for (float& sample : frame) {
-        sample *= currentGain_;
-    }
-}
-
-void VoiceProcessor::applyLimiter(std::vector<float>& frame) {
-    const float threshold = 0.9f;
-    const float release = 0.999f;
-
-    static float envelope = 0.0f;
-
-    for (float& sample : frame) {
-        float absSample = std::abs(sample);
-
-        if (absSample > envelope) {
-            envelope = absSample;
-        } else {
-            envelope = release * envelope + (1.0f - release) * absSample;
-        }
-
-        if (envelope > threshold) {
-            float reduction = threshold / envelope;
-            sample *= reduction;
-
-            if (reduction < 0.99f) {
-                clipCount_++;
-            }
-        }
-    }
-}
-
-float VoiceProcessor::calculateRmsDb(const std::vector<float>& frame) const {
-    if (frame.empty()) return MIN_DB;
-
-    float sum = 0.0f;
-    for (float sample : frame) {
-        sum += sample * sample;
-    }
-
-    float rms = sqrtf(sum / frame.size());
-    return 20.0f * log10f(rms + 1e-10f);
-}
-
-float VoiceProcessor::calculatePeakDb(const std::vector<float>& frame) const {
-    if (frame.empty()) return MIN_DB;
-
-    float peak = 0.0f;
-    for (float sample : frame) {
-        peak = std::max(peak, std::abs(sample));
-    }
-
-    return 20.0f * log10f(peak + 1e-10f);
+    outputLevelDb_ = dsp::rmsDb(out, frameSize_);
+    peakLevelDb_ = std::max(peakLevelDb_, dsp::peakDb(out, frameSize_));
 }
 
 VoiceProcessor::Stats VoiceProcessor::getStats() const {
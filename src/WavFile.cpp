@@ -0,0 +1,272 @@
+#include "../include/WavFile.hpp"
+#include "../include/SampleFormat.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr uint16_t FORMAT_PCM = 1;
+    constexpr uint16_t FORMAT_FLOAT = 3;
+    constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+    constexpr size_t HEADER_SIZE = 44;
+
+    // WAV всегда little-endian
+    uint16_t readU16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    uint32_t readU32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    void writeU16(unsigned char* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+    void writeU32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; ++i) p[i] = (v >> (8 * i)) & 0xFF;
+    }
+
+    struct WavFormat {
+        int sampleRate = 0;
+        int channels = 0;
+        int bitsPerSample = 0;
+        bool isFloat = false;
+    };
+
+    // Чанк fmt: поддерживаются PCM 16 бит и IEEE float 32 бит
+    bool parseFormat(const unsigned char* fmt, size_t size, WavFormat& out) {
+        if (size < 16) return false;
+
+        uint16_t format = readU16(fmt);
+        out.channels = readU16(fmt + 2);
+        out.sampleRate = static_cast<int>(readU32(fmt + 4));
+        out.bitsPerSample = readU16(fmt + 14);
+        if (format == FORMAT_EXTENSIBLE && size >= 26) {
+            format = readU16(fmt + 24);  // первые 2 байта SubFormat GUID
+        }
+
+        out.isFloat = (format == FORMAT_FLOAT && out.bitsPerSample == 32);
+        return out.channels > 0 &&
+               (out.isFloat || (format == FORMAT_PCM && out.bitsPerSample == 16));
+    }
+}
+
+// ==================== READER ====================
+
+bool WavReader::open(const std::string& path) {
+    close();
+
+    file_ = fopen(path.c_str(), "rb");
+    if (!file_) return false;
+
+    unsigned char riff[12];
+    if (fread(riff, 1, sizeof(riff), file_) != sizeof(riff) ||
+        memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        close();
+        return false;
+    }
+
+    // Идем по чанкам до data, по пути разбираем fmt
+    bool haveFormat = false;
+    unsigned char chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), file_) == sizeof(chunk)) {
+        uint32_t size = readU32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[40] = {};
+            size_t toRead = std::min<size_t>(size, sizeof(fmt));
+            if (fread(fmt, 1, toRead, file_) != toRead) break;
+            if (size > toRead) fseek(file_, size - toRead, SEEK_CUR);
+
+            WavFormat parsed;
+            haveFormat = parseFormat(fmt, toRead, parsed);
+            channels_ = parsed.channels;
+            sampleRate_ = parsed.sampleRate;
+            bitsPerSample_ = parsed.bitsPerSample;
+            isFloat_ = parsed.isFloat;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) break;
+
+            frameCount_ = size / (channels_ * (bitsPerSample_ / 8));
+            remaining_ = frameCount_;
+            return true;
+        } else {
+            fseek(file_, size + (size & 1), SEEK_CUR);
+        }
+    }
+
+    close();
+    return false;
+}
+
+void WavReader::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    frameCount_ = remaining_ = 0;
+}
+
+size_t WavReader::read(float* out, size_t frames) {
+    if (!file_) return 0;
+
+    frames = std::min(frames, remaining_);
+    const size_t samples = frames * channels_;
+
+    if (isFloat_) {
+        frames = fread(out, sizeof(float) * channels_, frames, file_);
+    } else {
+        pcm_.resize(samples);
+        frames = fread(pcm_.data(), sizeof(int16_t) * channels_, frames, file_);
+        for (size_t i = 0; i < frames * channels_; ++i) {
+            out[i] = SampleTraits<int16_t>::toFloat(pcm_[i]);
+        }
+    }
+
+    remaining_ -= frames;
+    return frames;
+}
+
+// ==================== MAPPED ====================
+
+bool MappedWav::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < 12) {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    map_ = static_cast<const unsigned char*>(map);
+    mapSize_ = static_cast<size_t>(info.st_size);
+
+    if (memcmp(map_, "RIFF", 4) != 0 || memcmp(map_ + 8, "WAVE", 4) != 0) {
+        close();
+        return false;
+    }
+
+    // Чанки до data; обрезанный data (файл дописывается) — берем что есть
+    bool haveFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= mapSize_) {
+        const unsigned char* chunk = map_ + offset;
+        size_t size = readU32(chunk + 4);
+        size_t available = std::min(size, mapSize_ - offset - 8);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            WavFormat parsed;
+            haveFormat = parseFormat(chunk + 8, available, parsed);
+            channels_ = parsed.channels;
+            sampleRate_ = parsed.sampleRate;
+            isFloat_ = parsed.isFloat;
+            frameBytes_ = static_cast<size_t>(channels_) * (parsed.bitsPerSample / 8);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) break;
+
+            data_ = chunk + 8;
+            frameCount_ = available / frameBytes_;
+            return true;
+        }
+        offset += 8 + size + (size & 1);
+    }
+
+    close();
+    return false;
+}
+
+void MappedWav::close() {
+    if (map_) {
+        munmap(const_cast<unsigned char*>(map_), mapSize_);
+        map_ = nullptr;
+    }
+    data_ = nullptr;
+    mapSize_ = frameCount_ = 0;
+}
+
+size_t MappedWav::readMono(size_t first, size_t frames, float* out) const {
+    if (!data_ || first >= frameCount_) return 0;
+
+    frames = std::min(frames, frameCount_ - first);
+    const unsigned char* in = data_ + first * frameBytes_;
+    const float scale = 1.0f / channels_;
+
+    // Данные в файле не выровнены: читаем через memcpy
+    for (size_t i = 0; i < frames; ++i, in += frameBytes_) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels_; ++c) {
+            if (isFloat_) {
+                float sample;
+                memcpy(&sample, in + c * sizeof(float), sizeof(sample));
+                sum += sample;
+            } else {
+                sum += SampleTraits<int16_t>::toFloat(static_cast<int16_t>(readU16(in + c * 2)));
+            }
+        }
+        out[i] = sum * scale;
+    }
+    return frames;
+}
+
+// ==================== WRITER ====================
+
+bool WavWriter::open(const std::string& path, int sampleRate, int channels) {
+    close();
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    channels_ = channels;
+    dataBytes_ = 0;
+
+    unsigned char header[HEADER_SIZE] = {};
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    writeU32(header + 16, 16);
+    writeU16(header + 20, FORMAT_PCM);
+    writeU16(header + 22, static_cast<uint16_t>(channels));
+    writeU32(header + 24, static_cast<uint32_t>(sampleRate));
+    writeU32(header + 28, static_cast<uint32_t>(sampleRate * channels * 2));
+    writeU16(header + 32, static_cast<uint16_t>(channels * 2));
+    writeU16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+
+    return fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+}
+
+size_t WavWriter::write(const float* in, size_t frames) {
+    if (!file_) return 0;
+
+    const size_t samples = frames * channels_;
+    pcm_.resize(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm_[i] = SampleTraits<int16_t>::fromFloat(in[i]);
+    }
+
+    size_t written = fwrite(pcm_.data(), sizeof(int16_t) * channels_, frames, file_);
+    dataBytes_ += written * sizeof(int16_t) * channels_;
+    return written;
+}
+
+void WavWriter::close() {
+    if (!file_) return;
+
+    // Дописываем размеры RIFF и data
+    unsigned char size[4];
+    writeU32(size, static_cast<uint32_t>(HEADER_SIZE - 8 + dataBytes_));
+    fseek(file_, 4, SEEK_SET);
+    fwrite(size, 1, 4, file_);
+
+    writeU32(size, static_cast<uint32_t>(dataBytes_));
+    fseek(file_, 40, SEEK_SET);
+    fwrite(size, 1, 4, file_);
+
+    fclose(file_);
+    file_ = nullptr;
+}
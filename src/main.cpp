@@ -1,31 +1,160 @@
 #include "AudioSystem.hpp"
+#include "WavAudioBackend.hpp"
+#include "Trace.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <csignal>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 std::atomic<bool> running(true);
+std::atomic<bool> dump_device_stats(false);
+std::atomic<bool> dump_trace(false);
 
 void signal_handler(int) {
     running = false;
 }
 
+// kill -USR1 <pid>: отчет по xrun, таймингу устройства и задержкам этапов на ходу
+void device_stats_handler(int) {
+    dump_device_stats = true;
+}
+
+// kill -USR2 <pid>: выгрузить трассировку (--trace) на ходу
+void trace_handler(int) {
+    dump_trace = true;
+}
+
+void write_trace(const std::string& path) {
+    long events = trace::write_json(path);
+    if (events < 0) {
+        std::cerr << "\n❌ Cannot write trace to " << path << std::endl;
+    } else {
+        std::cout << "\n🧵 Trace: " << events << " events in " << path << std::endl;
+    }
+    if (size_t untraced = trace::untraced_threads()) {
+        std::cerr << "⚠️  " << untraced << " thread(s) started after all trace rings were taken, not traced" << std::endl;
+    }
+}
+
+template <typename Sample>
+void print_device_stats(const BasicAudioSystem<Sample>& audio) {
+    const DeviceStats* stats = audio.device_stats();
+    if (!stats) return;
+    std::cout << "\n" << DeviceStats::report(stats->snapshot(), audio.device_name()) << std::flush;
+}
+
+// Задержки по этапам с прошлого отчета. До stop(): у сервера они в ретрансляторе
+template <typename Sample>
+void print_stage_latency(BasicAudioSystem<Sample>& audio) {
+    std::cout << "\n" << audio.pipeline_latency().interval_report() << std::flush;
+}
+
+// Звук без устройства: null или WAV файлы
+struct BackendOptions {
+    bool null_device = false;
+    std::string wav_in;
+    std::string wav_out;
+    bool fast = false;       // WAV: без паузы между кадрами
+
+    bool headless() const { return null_device || !wav_in.empty() || !wav_out.empty(); }
+};
+
+// Запись комнат на сервере
+struct RecordOptions {
+    std::string directory;
+    std::vector<uint16_t> rooms;   // пусто — все комнаты
+};
+
+// "1,2,5" -> {1, 2, 5}
+bool parse_rooms(const std::string& list, std::vector<uint16_t>& rooms) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+
+        std::string item = list.substr(start, end - start);
+        char* tail = nullptr;
+        long room = std::strtol(item.c_str(), &tail, 10);
+        if (item.empty() || *tail != '\0' || room < 0 || room > 65535) return false;
+
+        rooms.push_back(static_cast<uint16_t>(room));
+        start = end + 1;
+    }
+    return true;
+}
+
+// Ключ сессии из файла: hex, пробелы и переводы строк не считаются
+bool read_key_file(const std::string& path, std::string& key) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    key.clear();
+    for (char c : contents.str()) {
+        if (!std::isspace(static_cast<unsigned char>(c))) key += c;
+    }
+    return !key.empty();
+}
+
 void print_usage() {
     std::cout << "\n🔥 UDP VOICE CHAT SERVER/CLIENT 🔥\n" << std::endl;
     std::cout << "Usage:" << std::endl;
     std::cout << "  Local echo test:  ./voice" << std::endl;
     std::cout << "  Server (relay):   ./voice server" << std::endl;
     std::cout << "  Client:           ./voice client <server_ip>" << std::endl;
+    std::cout << "\nOptions:" << std::endl;
+    std::cout << "  --int16           Native int16 audio path (default: float32)" << std::endl;
+    std::cout << "  --low-latency[=5|2.5]" << std::endl;
+    std::cout << "                    5 or 2.5 ms frames, restricted-lowdelay Opus," << std::endl;
+    std::cout << "                    minimum device latency, 5 ms jitter target" << std::endl;
+    std::cout << "                    (at least 2 frames)" << std::endl;
+    std::cout << "  --bundle=N        Send N (2-6) Opus frames per datagram;" << std::endl;
+    std::cout << "                    fewer packets, N-1 frames more latency" << std::endl;
+    std::cout << "  --room=N          Join relay room N (0-65535, default 0)" << std::endl;
+    std::cout << "  --port=N          Relay UDP port (default " << NETWORK_PORT << ")" << std::endl;
+    std::cout << "  --record=DIR      Server: record each speaker to DIR as Ogg Opus" << std::endl;
+    std::cout << "  --record-rooms=1,2  Server: record only these rooms" << std::endl;
+    std::cout << "  --peer=IP:PORT    Server: trunk to another relay so rooms span both;" << std::endl;
+    std::cout << "                    repeat for each peer, configure on every node" << std::endl;
+    std::cout << "  --key-file=FILE   Encrypt packets with AES-GCM using the hex session key" << std::endl;
+    std::cout << "                    in FILE (openssl rand -hex 32); same on every node" << std::endl;
+    std::cout << "  --rt              Real-time priorities for audio/network/codec threads" << std::endl;
+    std::cout << "                    and mlockall (falls back and reports if not permitted)" << std::endl;
+    std::cout << "  --rt-audio=SPEC   Audio callback thread, SPEC = fifo|rr|other[:PRIO][@CPUS]," << std::endl;
+    std::cout << "                    e.g. fifo:80@2 or rr:60@4-7" << std::endl;
+    std::cout << "  --rt-network=SPEC Network threads" << std::endl;
+    std::cout << "  --rt-codec=SPEC   Server transcoding workers" << std::endl;
+    std::cout << "  --mlock           Lock all memory to avoid page faults" << std::endl;
+    std::cout << "  --metrics=ADDR    Prometheus metrics at http://ADDR/metrics;" << std::endl;
+    std::cout << "                    ADDR = PORT (localhost), IP:PORT or unix:/path" << std::endl;
+    std::cout << "  --trace[=FILE]    Record an event timeline, write Chrome trace JSON on" << std::endl;
+    std::cout << "                    SIGUSR2 and at exit (default voice-trace.json)" << std::endl;
+    std::cout << "  --audio=null      No sound card: silent input, discarded output" << std::endl;
+    std::cout << "  --wav-in=FILE     Read microphone from WAV (48 kHz mono)" << std::endl;
+    std::cout << "  --wav-out=FILE    Write speaker output to WAV" << std::endl;
+    std::cout << "  --fast            With WAV files: run as fast as possible" << std::endl;
     std::cout << "\nFeatures:" << std::endl;
     std::cout << "  • Server only relays audio (no echo)" << std::endl;
     std::cout << "  • Clients hear each other via server" << std::endl;
     std::cout << "  • Multiple clients supported" << std::endl;
     std::cout << "  • Low latency (~30-50ms)" << std::endl;
+    std::cout << "  • Acoustic echo cancellation on clients" << std::endl;
+    std::cout << "  • Per-listener bitrate tiers (server transcodes for lossy links)" << std::endl;
+    std::cout << "  • Rooms spanning several relays over trunks (--peer)" << std::endl;
+    std::cout << "  • Authenticated encryption with replay protection (--key-file)" << std::endl;
     std::cout << "\nExample:" << std::endl;
     std::cout << "  On server PC:    ./voice server" << std::endl;
     std::cout << "  On client PC 1:  ./voice client 192.168.1.100" << std::endl;
     std::cout << "  On client PC 2:  ./voice client 192.168.1.100" << std::endl;
+    std::cout << "  Two relays:      ./voice server --peer=10.0.0.2:" << NETWORK_PORT << "   (on 10.0.0.1)" << std::endl;
+    std::cout << "                   ./voice server --peer=10.0.0.1:" << NETWORK_PORT << "   (on 10.0.0.2)" << std::endl;
     std::cout << "\nConfig:" << std::endl;
     std::cout << "  Port: " << NETWORK_PORT << std::endl;
     std::cout << "  Sample rate: " << SAMPLE_RATE << " Hz" << std::endl;
@@ -33,43 +162,35 @@ void print_usage() {
     std::cout << "  Opus bitrate: " << (OPUS_BITRATE/1000) << " kbps\n" << std::endl;
 }
 
-int main(int argc, char* argv[]) {
-    std::signal(SIGINT, signal_handler);
-
-    AudioSystem::Mode mode = AudioSystem::MODE_LOCAL_ECHO;
-    std::string remote_ip = "";
-
-    if (argc > 1) {
-        std::string mode_str(argv[1]);
+template <typename Sample>
+int run(AudioMode::Mode mode, const std::string& remote_ip, const AudioProfile& profile,
+        const BackendOptions& backend, uint16_t room, int port, const RecordOptions& record,
+        const std::vector<std::string>& peers, const std::string& key,
+        const realtime::Config& rt, const std::string& metrics_address, const std::string& trace_path) {
+    // До создания потоков и буферов: MCL_FUTURE закрепит и их
+    if (rt.lock_memory) {
+        realtime::lock_memory();
+    }
 
-        if (mode_str == "server") {
-            mode = AudioSystem::MODE_SERVER;
-            std::cout << "🚀 Starting SERVER (relay only)..." << std::endl;
-        }
-        else if (mode_str == "client") {
-            if (argc > 2) {
-                mode = AudioSystem::MODE_CLIENT;
-                remote_ip = argv[2];
-                std::cout << "🚀 Starting CLIENT..." << std::endl;
-            } else {
-                std::cerr << "❌ Error: Client mode requires server IP address" << std::endl;
-                print_usage();
-                return 1;
-            }
-        }
-        else {
-            std::cerr << "❌ Error: Unknown mode '" << mode_str << "'" << std::endl;
-            print_usage();
-            return 1;
-        }
-    } else {
-        std::cout << "🚀 Starting LOCAL ECHO test..." << std::endl;
+    BasicAudioSystem<Sample> audio;
+    audio.set_realtime(rt);
+    audio.set_room(room);
+    audio.set_port(port);
+    audio.set_recording(record.directory, record.rooms);
+    audio.set_peers(peers);
+    if (!key.empty() && !audio.set_key(key)) {
+        return 1;
     }
 
-    AudioSystem audio;
+    if (backend.null_device) {
+        audio.set_audio_backend(std::make_unique<NullAudioBackend<Sample>>());
+    } else if (backend.headless()) {
+        audio.set_audio_backend(std::make_unique<WavAudioBackend<Sample>>(
+            backend.wav_in, backend.wav_out, !backend.fast));
+    }
 
     std::cout << "Initializing... ";
-    if (!audio.init(mode, remote_ip)) {
+    if (!audio.init(mode, remote_ip, profile)) {
         std::cerr << "❌ FAILED" << std::endl;
         return 1;
     }
@@ -90,7 +211,7 @@ int main(int argc, char* argv[]) {
             std::cout << "        VOICE CHAT SERVER             " << std::endl;
             std::cout << "        (Relay Mode - No Echo)        " << std::endl;
             std::cout << "========================================\n" << std::endl;
-            std::cout << "📡 Listening on port " << NETWORK_PORT << std::endl;
+            std::cout << "📡 Listening on port " << port << std::endl;
             std::cout << "🔄 Relaying audio between clients" << std::endl;
             std::cout << "🔇 Server does NOT hear audio" << std::endl;
             break;
@@ -98,22 +219,44 @@ int main(int argc, char* argv[]) {
         case AudioSystem::MODE_CLIENT:
             std::cout << "        VOICE CHAT CLIENT             " << std::endl;
             std::cout << "========================================\n" << std::endl;
-            std::cout << "📡 Connected to: " << remote_ip << ":" << NETWORK_PORT << std::endl;
+            std::cout << "📡 Connected to: " << remote_ip << ":" << port
+                      << " (room " << room << ")" << std::endl;
             std::cout << "🎤 Speak to talk to others" << std::endl;
             std::cout << "🔊 Hear other clients via server" << std::endl;
             break;
     }
 
+    // Потоки настраивают себя при старте: отчет ждет каждую запущенную роль
+    realtime::print_report(std::chrono::seconds(2));
+
+    // Сервер метрик читает счетчики audio: останавливается раньше него
+    metrics::Server metrics_server([&audio] {
+        metrics::Writer writer;
+        audio.write_metrics(writer);
+        return writer.str();
+    });
+    if (!metrics_address.empty() && !metrics_server.start(metrics_address)) {
+        std::cerr << "⚠️  Running without metrics endpoint" << std::endl;
+    }
+
     std::cout << "\n⏹️  Press Ctrl+C to exit\n" << std::endl;
 
-    // Статистика
-    int frames_sent = 0;
-    int frames_received = 0;
+    // Скорости за последнюю секунду по счетчикам
+    const auto& counters = audio.counters();
+    uint64_t last_sent = 0, last_received = 0, last_captured = 0, last_forwarded = 0;
     auto start_time = std::chrono::steady_clock::now();
 
-    while (running) {
+    while (running && !audio.audio_finished()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
+        if (dump_device_stats.exchange(false)) {
+            print_device_stats(audio);
+            print_stage_latency(audio);
+        }
+        if (dump_trace.exchange(false) && !trace_path.empty()) {
+            write_trace(trace_path);
+        }
+
         auto now = std::chrono::steady_clock::now();
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
 
@@ -121,25 +264,43 @@ int main(int argc, char* argv[]) {
             std::cout << "\r";
             std::cout << "⏱️  Time: " << elapsed << "s";
 
-            if (mode == AudioSystem::MODE_CLIENT || mode == AudioSystem::MODE_LOCAL_ECHO) {
-                std::cout << " | 📤 Sent: " << (frames_sent / elapsed) << " fps";
-                std::cout << " | 📥 Recv: " << (frames_received / elapsed) << " fps";
+            if (mode == AudioSystem::MODE_CLIENT) {
+                uint64_t sent = counters.packets_sent.get();
+                uint64_t received = counters.packets_received.get();
+                std::cout << " | 📤 Sent: " << (sent - last_sent) << " pkt/s";
+                std::cout << " | 📥 Recv: " << (received - last_received) << " pkt/s";
+                last_sent = sent;
+                last_received = received;
+            } else if (mode == AudioSystem::MODE_LOCAL_ECHO) {
+                uint64_t captured = counters.frames_captured.get();
+                std::cout << " | 🎤 Frames: " << (captured - last_captured) << "/s";
+                last_captured = captured;
             } else if (mode == AudioSystem::MODE_SERVER) {
-                std::cout << " | 📡 Clients: " << frames_sent; // Будем использовать как счетчик клиентов
-                frames_sent++;
+                uint64_t forwarded = audio.relay_forwarded();
+                std::cout << " | 📡 Clients: " << audio.relay_clients();
+                if (!peers.empty()) {
+                    std::cout << " | 🔗 Peers: " << audio.relay_peers_up() << "/" << peers.size();
+                }
+                std::cout << " | 🔁 Fwd: " << (forwarded - last_forwarded) << " pkt/s";
+                last_forwarded = forwarded;
             }
 
-            std::cout << "     " << std::flush;
-
-            if (elapsed >= 10) {
-                frames_sent = frames_received = 0;
-                start_time = now;
+            if (const DeviceStats* stats = audio.device_stats()) {
+                std::cout << " | ⚠️  Xruns: " << stats->snapshot().xruns();
             }
+
+            std::cout << "     " << std::flush;
         }
     }
 
     std::cout << "\n\n🛑 Stopping..." << std::endl;
+    metrics_server.stop();
+    print_stage_latency(audio);
     audio.stop();
+    print_device_stats(audio);
+    if (!trace_path.empty()) {
+        write_trace(trace_path);
+    }
 
     std::cout << "\n========================================" << std::endl;
     std::cout << "           SESSION ENDED              " << std::endl;
@@ -148,3 +309,166 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGUSR1, device_stats_handler);
+    std::signal(SIGUSR2, trace_handler);
+
+    AudioSystem::Mode mode = AudioSystem::MODE_LOCAL_ECHO;
+    std::string remote_ip = "";
+    bool use_int16 = false;
+    AudioProfile profile = AudioProfile::standard();
+    int bundle_frames = 1;
+    int room = 0;
+    int port = NETWORK_PORT;
+    BackendOptions backend;
+    RecordOptions record;
+    std::vector<std::string> peers;
+    std::string key;
+    realtime::Config rt;
+    std::string metrics_address;
+    std::string trace_path;
+
+    // Опции могут стоять где угодно, остальное — позиционные аргументы
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--int16") {
+            use_int16 = true;
+        } else if (arg == "--low-latency" || arg == "--low-latency=5") {
+            profile = AudioProfile::low_latency(SAMPLE_RATE / 200);
+        } else if (arg == "--low-latency=2.5") {
+            profile = AudioProfile::low_latency(SAMPLE_RATE / 400);
+        } else if (arg == "--audio=null") {
+            backend.null_device = true;
+        } else if (arg.rfind("--wav-in=", 0) == 0) {
+            backend.wav_in = arg.substr(9);
+        } else if (arg.rfind("--wav-out=", 0) == 0) {
+            backend.wav_out = arg.substr(10);
+        } else if (arg == "--fast") {
+            backend.fast = true;
+        } else if (arg.rfind("--bundle=", 0) == 0) {
+            bundle_frames = std::atoi(arg.c_str() + 9);
+            if (bundle_frames < 2 || bundle_frames > OpusBundler::MAX_FRAMES) {
+                std::cerr << "❌ Error: Bundle size must be 2-" << OpusBundler::MAX_FRAMES << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg.rfind("--room=", 0) == 0) {
+            room = std::atoi(arg.c_str() + 7);
+            if (room < 0 || room > 65535) {
+                std::cerr << "❌ Error: Room must be 0-65535" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg.rfind("--port=", 0) == 0) {
+            port = std::atoi(arg.c_str() + 7);
+            if (port < 1 || port > 65535) {
+                std::cerr << "❌ Error: Port must be 1-65535" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg == "--rt") {
+            rt = realtime::Config::defaults();
+        } else if (arg == "--mlock") {
+            rt.lock_memory = true;
+        } else if (arg.rfind("--rt-audio=", 0) == 0 || arg.rfind("--rt-network=", 0) == 0 ||
+                   arg.rfind("--rt-codec=", 0) == 0) {
+            size_t eq = arg.find('=');
+            std::string role = arg.substr(5, eq - 5);
+            realtime::ThreadPolicy& policy = role == "audio" ? rt.audio
+                                           : role == "network" ? rt.network : rt.codec;
+            if (!realtime::parse_policy(arg.substr(eq + 1), policy)) {
+                std::cerr << "❌ Error: Bad thread policy '" << arg.substr(eq + 1) << "'" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg.rfind("--metrics=", 0) == 0) {
+            metrics_address = arg.substr(10);
+        } else if (arg == "--trace" || arg.rfind("--trace=", 0) == 0) {
+            trace_path = arg.size() > 8 ? arg.substr(8) : "voice-trace.json";
+        } else if (arg.rfind("--record=", 0) == 0) {
+            record.directory = arg.substr(9);
+        } else if (arg.rfind("--record-rooms=", 0) == 0) {
+            if (!parse_rooms(arg.substr(15), record.rooms)) {
+                std::cerr << "❌ Error: Record rooms must be a comma-separated list of 0-65535" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg.rfind("--peer=", 0) == 0) {
+            peers.push_back(arg.substr(7));
+        } else if (arg.rfind("--key-file=", 0) == 0) {
+            if (!read_key_file(arg.substr(11), key)) {
+                std::cerr << "❌ Error: Cannot read session key from '" << arg.substr(11) << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--low-latency=", 0) == 0) {
+            std::cerr << "❌ Error: Low-latency frame must be 5 or 2.5 ms" << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (!args.empty()) {
+        const std::string& mode_str = args[0];
+
+        if (mode_str == "server") {
+            mode = AudioSystem::MODE_SERVER;
+            std::cout << "🚀 Starting SERVER (relay only)..." << std::endl;
+        }
+        else if (mode_str == "client") {
+            if (args.size() > 1) {
+                mode = AudioSystem::MODE_CLIENT;
+                remote_ip = args[1];
+                std::cout << "🚀 Starting CLIENT..." << std::endl;
+            } else {
+                std::cerr << "❌ Error: Client mode requires server IP address" << std::endl;
+                print_usage();
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "❌ Error: Unknown mode '" << mode_str << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+    } else {
+        std::cout << "🚀 Starting LOCAL ECHO test..." << std::endl;
+    }
+
+    profile.bundle_frames = bundle_frames;
+
+    std::cout << "🎚️  Sample format: " << (use_int16 ? SampleTraits<int16_t>::name
+                                                  : SampleTraits<float>::name) << std::endl;
+    std::cout << "⏱️  Frame: " << profile.frame_ms() << " ms"
+              << (profile.low_latency_device ? " (low-latency profile)" : "") << std::endl;
+    if (profile.bundle_frames > 1) {
+        std::cout << "📦 Bundling " << profile.bundle_frames << " frames per datagram" << std::endl;
+    }
+
+    if (!record.directory.empty() && mode != AudioSystem::MODE_SERVER) {
+        std::cerr << "⚠️  --record only applies to server mode, ignoring" << std::endl;
+        record = RecordOptions();
+    }
+    if (!peers.empty() && mode != AudioSystem::MODE_SERVER) {
+        std::cerr << "⚠️  --peer only applies to server mode, ignoring" << std::endl;
+        peers.clear();
+    }
+
+    if (!trace_path.empty()) {
+        if (trace::COMPILED_IN) {
+            trace::enable();
+            TRACE_THREAD("main");
+            std::cout << "🧵 Tracing to " << trace_path << " (kill -USR2 to dump now)" << std::endl;
+        } else {
+            std::cerr << "⚠️  Built without VOICE_TRACE, --trace ignored" << std::endl;
+            trace_path.clear();
+        }
+    }
+
+    return use_int16 ? run<int16_t>(mode, remote_ip, profile, backend, room, port, record, peers, key, rt, metrics_address, trace_path)
+                     : run<float>(mode, remote_ip, profile, backend, room, port, record, peers, key, rt, metrics_address, trace_path);
+}
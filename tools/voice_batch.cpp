@@ -0,0 +1,386 @@
+// Пакетная обработка записей тем же DSP, что и в реальном времени.
+// Входные WAV отображаются в память; длинные файлы режутся на куски,
+// куски всех файлов обрабатываются пулом потоков. Кусок начинается с
+// разогрева (перекрытие с предыдущим) — состояние шумоподавителя и АРУ
+// успевает сойтись, а на стыке кусков выходы сводятся кроссфейдом.
+// Готовые куски дописываются в выходной файл по порядку, не дожидаясь конца.
+#include "../include/FixedVoiceProcessor.hpp"
+#include "../include/ThreadPool.hpp"
+#include "../include/WavFile.hpp"
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Стык кусков: столько выхода сводится кроссфейдом
+    constexpr int CROSSFADE_MS = 20;
+    // Кусков в работе на поток: ограничивает память под неупорядоченные куски
+    constexpr size_t CHUNKS_IN_FLIGHT_PER_THREAD = 2;
+    // Проверка уровня: выход тише входа больше чем на столько — обработка сломана
+    // (шумоподавитель режет не больше 20 дБ, АРУ поднимает речь обратно)
+    constexpr double MAX_LEVEL_DROP_DB = 30.0;
+    // Вход тише этого не проверяем: тишине нечего терять
+    constexpr double MIN_CHECKED_LEVEL_DBFS = -60.0;
+
+    struct Options {
+        std::vector<std::string> inputs;
+        std::string out_dir;
+        std::string suffix = ".processed";
+        FrameProcessor::ProcessingMode mode = FrameProcessor::MODE_STANDARD;
+        size_t threads = 0;
+        double chunk_seconds = 30.0;
+        int overlap_ms = 1000;
+        bool band_split = false;
+    };
+
+    struct Chunk {
+        size_t start = 0;        // первый кадр, попадающий в выход
+        size_t end = 0;          // конец выхода куска
+        size_t warmup_start = 0; // с него начинается обработка
+        size_t fade_end = 0;     // выход дальше end — под кроссфейд со следующим
+    };
+
+    struct FileJob {
+        std::string input;
+        std::string output;
+        MappedWav wav;
+        WavWriter writer;
+        std::vector<Chunk> chunks;
+
+        // Запись по порядку: готовые, но еще не записанные куски
+        std::mutex mutex;
+        std::map<size_t, std::vector<float>> finished;
+        size_t next_chunk = 0;
+        std::vector<float> tail;            // хвост предыдущего куска под кроссфейд
+        double input_energy = 0.0;          // сумма квадратов, под mutex
+        double output_energy = 0.0;
+        std::atomic<uint64_t> cpu_ns{0};
+        Clock::time_point started;
+    };
+
+    uint64_t thread_cpu_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    bool parse_mode(const std::string& name, FrameProcessor::ProcessingMode& mode) {
+        if (name == "aggressive") mode = FrameProcessor::MODE_AGGRESSIVE;
+        else if (name == "standard") mode = FrameProcessor::MODE_STANDARD;
+        else if (name == "conservative") mode = FrameProcessor::MODE_CONSERVATIVE;
+        else if (name == "auto") mode = FrameProcessor::MODE_AUTO;
+        else return false;
+        return true;
+    }
+
+    double energy(const float* samples, size_t count) {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) sum += static_cast<double>(samples[i]) * samples[i];
+        return sum;
+    }
+
+    double level_dbfs(double energy, size_t count) {
+        return count > 0 ? 10.0 * std::log10(energy / count + 1e-20) : -200.0;
+    }
+
+    std::string output_path(const Options& options, const std::string& input) {
+        size_t slash = input.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : input.substr(0, slash);
+        std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+
+        size_t dot = name.find_last_of('.');
+        std::string stem = dot == std::string::npos ? name : name.substr(0, dot);
+
+        if (!options.out_dir.empty()) {
+            return options.out_dir + "/" + stem + ".wav";
+        }
+        return dir + "/" + stem + options.suffix + ".wav";
+    }
+
+    class BatchProcessor {
+    public:
+        explicit BatchProcessor(const Options& options)
+            : options_(options)
+            , pool_(options.threads) {}
+
+        int run() {
+            for (const auto& input : options_.inputs) {
+                auto job = std::make_unique<FileJob>();
+                if (!prepare(*job, input)) continue;
+                jobs_.push_back(std::move(job));
+            }
+            if (jobs_.empty()) return 1;
+
+            std::cout << "🧵 " << pool_.size() << " threads, " << jobs_.size() << " files, "
+                      << total_chunks() << " chunks" << std::endl;
+
+            const auto started = Clock::now();
+            const size_t max_in_flight = pool_.size() * CHUNKS_IN_FLIGHT_PER_THREAD;
+
+            for (auto& job : jobs_) {
+                job->started = Clock::now();
+                for (size_t c = 0; c < job->chunks.size(); ++c) {
+                    {
+                        std::unique_lock<std::mutex> lock(flight_mutex_);
+                        flight_done_.wait(lock, [&] { return in_flight_ < max_in_flight; });
+                        in_flight_++;
+                    }
+
+                    FileJob* file = job.get();
+                    pool_.submit([this, file, c] {
+                        process_chunk(*file, c);
+                        {
+                            std::lock_guard<std::mutex> lock(flight_mutex_);
+                            in_flight_--;
+                        }
+                        flight_done_.notify_all();
+                    });
+                }
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(flight_mutex_);
+                flight_done_.wait(lock, [&] { return in_flight_ == 0; });
+            }
+
+            double wall = std::chrono::duration<double>(Clock::now() - started).count();
+            print_summary(wall);
+            return failed_ ? 1 : 0;
+        }
+
+    private:
+        bool prepare(FileJob& job, const std::string& input) {
+            job.input = input;
+            job.output = output_path(options_, input);
+
+            if (!job.wav.open(input)) {
+                std::cerr << "❌ " << input << ": not a PCM16/float32 WAV file" << std::endl;
+                failed_ = true;
+                return false;
+            }
+
+            const int sample_rate = job.wav.getSampleRate();
+            if (sample_rate % 100 != 0) {
+                std::cerr << "❌ " << input << ": sample rate " << sample_rate
+                          << " Hz has no whole 10 ms frame" << std::endl;
+                failed_ = true;
+                return false;
+            }
+
+            if (!job.writer.open(job.output, sample_rate, 1)) {
+                std::cerr << "❌ Cannot write " << job.output << std::endl;
+                failed_ = true;
+                return false;
+            }
+
+            // Границы кусков кратны кадру: куски обрабатываются теми же кадрами
+            const size_t frame = sample_rate / 100;
+            const size_t total = job.wav.getFrameCount();
+            const size_t chunk_frames = std::max<size_t>(
+                1, static_cast<size_t>(options_.chunk_seconds * 100.0)) * frame;
+            const size_t warmup = static_cast<size_t>(options_.overlap_ms / 10) * frame;
+            const size_t fade = static_cast<size_t>(CROSSFADE_MS / 10) * frame;
+
+            for (size_t start = 0; start < total || start == 0; start += chunk_frames) {
+                Chunk chunk;
+                chunk.start = start;
+                chunk.end = std::min(start + chunk_frames, total);
+                chunk.warmup_start = start > warmup ? start - warmup : 0;
+                chunk.fade_end = std::min(chunk.end + fade, total);
+                job.chunks.push_back(chunk);
+                if (total == 0) break;
+            }
+            return true;
+        }
+
+        size_t total_chunks() const {
+            size_t count = 0;
+            for (const auto& job : jobs_) count += job->chunks.size();
+            return count;
+        }
+
+        void process_chunk(FileJob& job, size_t index) {
+            const uint64_t cpu_start = thread_cpu_ns();
+            const Chunk& chunk = job.chunks[index];
+            const int sample_rate = job.wav.getSampleRate();
+
+            auto processor = createFrameProcessor(sample_rate, sample_rate / 100);
+            processor->setMode(options_.mode);
+            if (options_.band_split) processor->enableBandSplit(true);
+
+            // Последний кадр дополняется тишиной
+            const size_t frame = processor->getFrameSize();
+            const size_t length = chunk.fade_end - chunk.warmup_start;
+            std::vector<float> audio((length + frame - 1) / frame * frame, 0.0f);
+            job.wav.readMono(chunk.warmup_start, length, audio.data());
+            const double input_energy = energy(audio.data() + (chunk.start - chunk.warmup_start),
+                                               chunk.end - chunk.start);
+
+            for (size_t offset = 0; offset < audio.size(); offset += frame) {
+                processor->process(audio.data() + offset, audio.data() + offset);
+            }
+
+            // Разогрев в выход не идет
+            std::vector<float> output(audio.begin() + (chunk.start - chunk.warmup_start),
+                                      audio.begin() + length);
+
+            job.cpu_ns += thread_cpu_ns() - cpu_start;
+            commit(job, index, std::move(output), input_energy);
+        }
+
+        // Кусок готов: дописываем в файл все куски, готовые по порядку
+        void commit(FileJob& job, size_t index, std::vector<float> output, double input_energy) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.finished.emplace(index, std::move(output));
+            job.input_energy += input_energy;
+
+            while (!job.finished.empty() && job.finished.begin()->first == job.next_chunk) {
+                std::vector<float>& out = job.finished.begin()->second;
+                const Chunk& chunk = job.chunks[job.next_chunk];
+
+                // Начало куска сводим с хвостом предыдущего
+                const size_t fade = std::min(job.tail.size(), out.size());
+                for (size_t i = 0; i < fade; ++i) {
+                    float w = static_cast<float>(i + 1) / (fade + 1);
+                    out[i] = job.tail[i] * (1.0f - w) + out[i] * w;
+                }
+
+                const size_t body = chunk.end - chunk.start;
+                job.writer.write(out.data(), body);
+                job.output_energy += energy(out.data(), body);
+                job.tail.assign(out.begin() + body, out.end());
+
+                job.finished.erase(job.finished.begin());
+                job.next_chunk++;
+            }
+
+            if (job.next_chunk == job.chunks.size()) {
+                finish(job);
+            }
+        }
+
+        void finish(FileJob& job) {
+            job.writer.close();
+
+            const double audio = static_cast<double>(job.wav.getFrameCount()) / job.wav.getSampleRate();
+            const double cpu = job.cpu_ns / 1e9;
+            const double wall = std::chrono::duration<double>(Clock::now() - job.started).count();
+            const double input_db = level_dbfs(job.input_energy, job.wav.getFrameCount());
+            const double output_db = level_dbfs(job.output_energy, job.wav.getFrameCount());
+            job.wav.close();
+
+            std::lock_guard<std::mutex> lock(report_mutex_);
+            total_audio_ += audio;
+            total_cpu_ += cpu;
+            std::cout << "✅ " << job.output << std::fixed << std::setprecision(1)
+                      << "  " << audio << " s audio, " << job.chunks.size() << " chunks, "
+                      << (cpu > 0.0 ? audio / cpu : 0.0) << "x realtime per core, "
+                      << wall << " s wall, " << input_db << " -> " << output_db << " dBFS" << std::endl;
+
+            if (input_db > MIN_CHECKED_LEVEL_DBFS && input_db - output_db > MAX_LEVEL_DROP_DB) {
+                std::cerr << "❌ " << job.output << ": output is " << (input_db - output_db)
+                          << " dB below input (limit " << MAX_LEVEL_DROP_DB << " dB)" << std::endl;
+                failed_ = true;
+            }
+        }
+
+        void print_summary(double wall) const {
+            std::cout << "\n========================================" << std::endl;
+            std::cout << "            BATCH SUMMARY               " << std::endl;
+            std::cout << "========================================" << std::endl;
+            std::cout << std::fixed << std::setprecision(1);
+            std::cout << "Audio:      " << total_audio_ << " s in " << jobs_.size() << " files" << std::endl;
+            std::cout << "Wall time:  " << std::setprecision(2) << wall << " s" << std::endl;
+            std::cout << "CPU time:   " << total_cpu_ << " s on " << pool_.size() << " threads" << std::endl;
+            std::cout << std::setprecision(1);
+            std::cout << "Realtime:   " << (wall > 0.0 ? total_audio_ / wall : 0.0) << "x total, "
+                      << (total_cpu_ > 0.0 ? total_audio_ / total_cpu_ : 0.0) << "x per core" << std::endl;
+        }
+
+    private:
+        Options options_;
+        std::vector<std::unique_ptr<FileJob>> jobs_;
+
+        std::mutex flight_mutex_;
+        std::condition_variable flight_done_;
+        size_t in_flight_ = 0;
+
+        std::mutex report_mutex_;
+        double total_audio_ = 0.0;
+        double total_cpu_ = 0.0;
+        bool failed_ = false;
+
+        // Последним: рабочие потоки останавливаются раньше, чем умирают задания
+        ThreadPool pool_;
+    };
+
+    void print_usage() {
+        std::cout << "\n🗂️  OFFLINE VOICE PROCESSING\n" << std::endl;
+        std::cout << "Usage: ./voice_batch [options] input.wav..." << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --mode=M          aggressive | standard | conservative | auto" << std::endl;
+        std::cout << "  --out-dir=DIR     Write results to DIR (default: next to input," << std::endl;
+        std::cout << "                    with a .processed suffix)" << std::endl;
+        std::cout << "  --threads=N       Worker threads (default: all cores)" << std::endl;
+        std::cout << "  --chunk=S         Split files into S-second chunks (default 30)" << std::endl;
+        std::cout << "  --overlap-ms=MS   Warm-up before each chunk (default 1000)" << std::endl;
+        std::cout << "  --band-split      Suppress noise in the 0-8 kHz band only (48 kHz)" << std::endl;
+        std::cout << "\nOutput is mono 16-bit PCM at the input sample rate. A file whose output" << std::endl;
+        std::cout << "is more than 30 dB quieter than its input is reported and fails the run.\n" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg.rfind("--mode=", 0) == 0) {
+            if (!parse_mode(arg.substr(7), options.mode)) {
+                std::cerr << "❌ Error: Unknown mode '" << arg.substr(7) << "'" << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg.rfind("--out-dir=", 0) == 0) {
+            options.out_dir = arg.substr(10);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = static_cast<size_t>(std::max(0, std::atoi(arg.c_str() + 10)));
+        } else if (arg.rfind("--chunk=", 0) == 0) {
+            options.chunk_seconds = std::atof(arg.c_str() + 8);
+        } else if (arg.rfind("--overlap-ms=", 0) == 0) {
+            options.overlap_ms = std::max(0, std::atoi(arg.c_str() + 13));
+        } else if (arg == "--band-split") {
+            options.band_split = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "❌ Error: Unknown option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.inputs.empty() || options.chunk_seconds < 0.01) {
+        print_usage();
+        return 1;
+    }
+
+    BatchProcessor batch(options);
+    return batch.run();
+}
@@ -0,0 +1,424 @@
+// Микробенчмарки горячих путей: FFT, шумоподавление, VoiceProcessor,
+// Opus, шифрование пакетов и передача кадров в callback воспроизведения. Каждый замер крутит
+// тело, пока не наберется --min-time, и сообщает ns на кадр и запас по
+// реальному времени (длительность кадра / время обработки). --json —
+// машиночитаемый вывод для сравнения между версиями.
+#include "../include/FFT.hpp"
+#include "../include/FixedVoiceProcessor.hpp"
+#include "../include/NoiseSuppressor.hpp"
+#include "../include/OpusCodec.hpp"
+#include "../include/PacketCrypto.hpp"
+#include "../include/PlaybackQueue.hpp"
+#include "../include/VoiceProcessor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr int FRAME_SIZE = 960;            // 20 мс, как в профиле по умолчанию
+    constexpr int SIGNAL_SECONDS = 1;          // тестовый сигнал крутится по кругу
+    constexpr int WARMUP_ITERATIONS = 16;
+
+    struct Options {
+        double min_seconds = 0.5;
+        std::string filter;
+        bool json = false;
+    };
+
+    struct Result {
+        std::string name;
+        int frame_size;          // сэмплов на одну итерацию
+        uint64_t iterations;
+        double ns_per_frame;
+        double realtime;         // во сколько раз быстрее реального времени
+    };
+
+    // Речь-подобный сигнал с шумом: фиксированное зерно, прогоны сравнимы
+    std::vector<float> make_signal() {
+        std::mt19937 rng(12345);
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+
+        std::vector<float> signal(SAMPLE_RATE * SIGNAL_SECONDS);
+        for (size_t i = 0; i < signal.size(); ++i) {
+            float t = static_cast<float>(i) / SAMPLE_RATE;
+            // Тон с огибающей слогов ~4 Гц
+            float envelope = 0.5f + 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 4.0f * t);
+            float voice = 0.2f * std::sin(2.0f * static_cast<float>(M_PI) * 220.0f * t) +
+                          0.1f * std::sin(2.0f * static_cast<float>(M_PI) * 660.0f * t) +
+                          0.05f * std::sin(2.0f * static_cast<float>(M_PI) * 1760.0f * t);
+            signal[i] = envelope * voice + noise(rng);
+        }
+        return signal;
+    }
+
+    const char* mode_name(FrameProcessor::ProcessingMode mode) {
+        switch (mode) {
+            case FrameProcessor::MODE_AGGRESSIVE: return "aggressive";
+            case FrameProcessor::MODE_CONSERVATIVE: return "conservative";
+            case FrameProcessor::MODE_AUTO: return "auto";
+            case FrameProcessor::MODE_STANDARD:
+            default: return "standard";
+        }
+    }
+
+    const char* suppression_name(NoiseSuppressor::SuppressionType type) {
+        switch (type) {
+            case NoiseSuppressor::SUBTRACTION: return "subtraction";
+            case NoiseSuppressor::WIENER: return "wiener";
+            case NoiseSuppressor::SPECTRAL_GATING: return "gating";
+            case NoiseSuppressor::MMSE:
+            default: return "mmse";
+        }
+    }
+
+    class BenchRunner {
+    public:
+        explicit BenchRunner(const Options& options)
+            : options_(options)
+            , signal_(make_signal()) {}
+
+        int run() {
+            // В JSON режиме stdout — только для результата: сообщения
+            // модулей (инициализация и т.п.) уходят в stderr
+            std::ostream out(std::cout.rdbuf());
+            if (options_.json) std::cout.rdbuf(std::cerr.rdbuf());
+
+            bench_fft();
+            bench_noise_suppressor();
+            bench_voice_processor();
+            bool ok = bench_opus();
+            if (ok) bench_playback_queue();
+            if (ok) ok = bench_crypto();
+
+            std::cout.rdbuf(out.rdbuf());
+            if (ok && options_.json) print_json(out);
+            return ok ? 0 : 1;
+        }
+
+    private:
+        // Кадр index тестового сигнала (по кругу)
+        const float* frame(size_t index) const {
+            size_t frames = signal_.size() / FRAME_SIZE;
+            return signal_.data() + (index % frames) * FRAME_SIZE;
+        }
+
+        bool selected(const std::string& name) const {
+            return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+        }
+
+        // Тело получает номер итерации. Итерации наращиваются пачками,
+        // пока не наберется min_seconds: часы не читаются в каждой итерации
+        template <typename Body>
+        void measure(const std::string& name, int frame_size, Body&& body) {
+            if (!selected(name)) return;
+
+            size_t index = 0;
+            for (int i = 0; i < WARMUP_ITERATIONS; ++i) body(index++);
+
+            uint64_t iterations = 0;
+            uint64_t batch = 1;
+            Clock::duration elapsed{};
+            while (std::chrono::duration<double>(elapsed).count() < options_.min_seconds) {
+                auto started = Clock::now();
+                for (uint64_t i = 0; i < batch; ++i) body(index++);
+                elapsed += Clock::now() - started;
+
+                iterations += batch;
+                batch = std::min<uint64_t>(batch * 2, 1u << 20);
+            }
+
+            Result result;
+            result.name = name;
+            result.frame_size = frame_size;
+            result.iterations = iterations;
+            result.ns_per_frame = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+            double frame_ns = 1e9 * frame_size / SAMPLE_RATE;
+            result.realtime = result.ns_per_frame > 0.0 ? frame_ns / result.ns_per_frame : 0.0;
+            results_.push_back(result);
+
+            if (!options_.json) print_result(result);
+        }
+
+        // Кадр — N сэмплов сигнала, прямое преобразование
+        void bench_fft() {
+            for (int n : {256, 512, 1024, 2048}) {
+                std::vector<std::complex<float>> data(n);
+                measure("fft/iterative/" + std::to_string(n), n, [&](size_t index) {
+                    const float* in = frame(index);
+                    for (int i = 0; i < n; ++i) data[i] = in[i % FRAME_SIZE];
+                    dsp::iterativeFFT(data.data(), n);
+                    sink_ += data[1].real();
+                });
+            }
+
+            bench_fixed_fft<1024>();
+            bench_fixed_fft<2048>();
+        }
+
+        template <int N>
+        void bench_fixed_fft() {
+            dsp::FixedFFT<N> fft;
+            std::vector<std::complex<float>> data(N);
+            measure("fft/fixed/" + std::to_string(N), N, [&](size_t index) {
+                const float* in = frame(index);
+                for (int i = 0; i < N; ++i) data[i] = in[i % FRAME_SIZE];
+                fft.forward(data.data());
+                sink_ += data[1].real();
+            });
+        }
+
+        void bench_noise_suppressor() {
+            for (auto type : {NoiseSuppressor::SUBTRACTION, NoiseSuppressor::WIENER,
+                              NoiseSuppressor::MMSE, NoiseSuppressor::SPECTRAL_GATING}) {
+                std::string name = std::string("ns/") + suppression_name(type);
+                if (!selected(name)) continue;
+
+                NoiseSuppressor suppressor(SAMPLE_RATE, FRAME_SIZE);
+                suppressor.setSuppressionType(type);
+
+                std::vector<float> input(FRAME_SIZE);
+                measure(name, FRAME_SIZE, [&](size_t index) {
+                    std::copy(frame(index), frame(index) + FRAME_SIZE, input.begin());
+                    std::vector<float> output = suppressor.process(input);
+                    sink_ += output[0];
+                });
+            }
+        }
+
+        void bench_voice_processor() {
+            const FrameProcessor::ProcessingMode modes[] = {
+                FrameProcessor::MODE_AGGRESSIVE, FrameProcessor::MODE_STANDARD,
+                FrameProcessor::MODE_CONSERVATIVE, FrameProcessor::MODE_AUTO
+            };
+
+            std::vector<float> output(FRAME_SIZE);
+            for (auto mode : modes) {
+                std::string name = std::string("vp/") + mode_name(mode);
+                if (!selected(name)) continue;
+
+                VoiceProcessor processor(SAMPLE_RATE, FRAME_SIZE);
+                processor.setMode(mode);
+                measure(name, FRAME_SIZE, [&](size_t index) {
+                    processor.process(frame(index), output.data());
+                    sink_ += output[0];
+                });
+            }
+
+            // То, что работает в реальном времени: специализация под размер кадра
+            for (auto mode : modes) {
+                std::string name = std::string("vp-fixed/") + mode_name(mode);
+                if (!selected(name)) continue;
+
+                std::unique_ptr<FrameProcessor> processor = createFrameProcessor(SAMPLE_RATE, FRAME_SIZE);
+                processor->setMode(mode);
+                measure(name, FRAME_SIZE, [&](size_t index) {
+                    processor->process(frame(index), output.data());
+                    sink_ += output[0];
+                });
+            }
+        }
+
+        bool bench_opus() {
+            if (!selected("opus/encode") && !selected("opus/decode")) return true;
+
+            OpusCodec codec;
+            if (!codec.init(SAMPLE_RATE, 1)) {
+                std::cerr << "❌ Opus init failed" << std::endl;
+                return false;
+            }
+            codec.setBitrate(32000);
+
+            unsigned char packet[OpusCodec::MAX_PACKET_SIZE];
+            measure("opus/encode", FRAME_SIZE, [&](size_t index) {
+                int bytes = codec.encode(frame(index), FRAME_SIZE, packet, sizeof(packet));
+                sink_ += bytes;
+            });
+
+            // Декодируем заранее закодированную секунду
+            std::vector<std::vector<unsigned char>> packets;
+            for (size_t i = 0; i < signal_.size() / FRAME_SIZE; ++i) {
+                int bytes = codec.encode(frame(i), FRAME_SIZE, packet, sizeof(packet));
+                if (bytes <= 0) {
+                    std::cerr << "❌ Opus encode failed: " << OpusCodec::errorString(bytes) << std::endl;
+                    return false;
+                }
+                packets.emplace_back(packet, packet + bytes);
+            }
+
+            std::vector<float> pcm(codec.getMaxFrameSize());
+            measure("opus/decode", FRAME_SIZE, [&](size_t index) {
+                const auto& encoded = packets[index % packets.size()];
+                int samples = codec.decode(encoded.data(), static_cast<int>(encoded.size()),
+                                           pcm.data(), static_cast<int>(pcm.size()));
+                sink_ += samples;
+            });
+            return true;
+        }
+
+        // Путь сеть -> callback: кадр из декодера в очередь, период из очереди в выход
+        void bench_playback_queue() {
+            std::vector<float> output(FRAME_SIZE);
+
+            PlaybackQueue<float> queue;
+            measure("queue/handoff", FRAME_SIZE, [&](size_t index) {
+                queue.push(std::vector<float>(frame(index), frame(index) + FRAME_SIZE), 0);
+                queue.fill(output.data(), FRAME_SIZE);
+                sink_ += output[0];
+            });
+
+            // Период устройства вдвое короче кадра: остаток копируется в голову очереди
+            PlaybackQueue<float> split_queue;
+            measure("queue/handoff-half-period", FRAME_SIZE, [&](size_t index) {
+                split_queue.push(std::vector<float>(frame(index), frame(index) + FRAME_SIZE), 0);
+                split_queue.fill(output.data(), FRAME_SIZE / 2);
+                split_queue.fill(output.data(), FRAME_SIZE / 2);
+                sink_ += output[0];
+            });
+
+            // Сетевой поток пишет без остановки: callback конкурирует за мьютекс
+            if (!selected("queue/contended")) return;
+
+            PlaybackQueue<float> contended;
+            std::atomic<bool> producing(true);
+            std::thread producer([&] {
+                size_t index = 0;
+                while (producing.load(std::memory_order_relaxed)) {
+                    contended.push(std::vector<float>(frame(index), frame(index) + FRAME_SIZE), 4);
+                    ++index;
+                }
+            });
+            measure("queue/contended", FRAME_SIZE, [&](size_t) {
+                contended.fill(output.data(), FRAME_SIZE);
+                sink_ += output[0];
+            });
+            producing = false;
+            producer.join();
+        }
+
+        // Пакет на кадр: ns на кадр — ns на пакет. Open — того же пакета,
+        // поэтому окно повторов здесь не участвует
+        bool bench_crypto() {
+            for (int bits : {128, 256}) {
+                for (size_t payload : {80, 1200}) {
+                    std::string suffix = "/aes" + std::to_string(bits) + "-" + std::to_string(payload) + "B";
+                    if (!selected("crypto/seal" + suffix) && !selected("crypto/open" + suffix)) continue;
+
+                    std::vector<unsigned char> key(bits / 8, 0x5A);
+                    PacketCrypto crypto;
+                    if (!crypto.set_key(key.data(), key.size())) {
+                        std::cerr << "❌ AES-GCM init failed" << std::endl;
+                        return false;
+                    }
+
+                    std::vector<unsigned char> packet(protocol::HEADER_SIZE + payload, 0x11);
+                    protocol::PacketHeader header;
+                    std::vector<unsigned char> sealed(packet.size() + PacketCrypto::OVERHEAD);
+                    std::vector<unsigned char> opened(sealed.size());
+                    uint32_t salt = PacketCrypto::random_salt();
+
+                    measure("crypto/seal" + suffix, FRAME_SIZE, [&](size_t index) {
+                        header.sequence = static_cast<uint32_t>(index);
+                        protocol::write_header(packet.data(), header);
+                        sink_ += crypto.seal(packet.data(), packet.size(), salt, sealed.data());
+                    });
+
+                    crypto.seal(packet.data(), packet.size(), salt, sealed.data());
+                    measure("crypto/open" + suffix, FRAME_SIZE, [&](size_t) {
+                        sink_ += crypto.open(sealed.data(), sealed.size(), opened.data());
+                    });
+                }
+            }
+            return true;
+        }
+
+        static void print_result(const Result& result) {
+            std::cout << std::left << std::setw(28) << result.name << std::right
+                      << std::setw(6) << result.frame_size << " samples"
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(12) << result.ns_per_frame << " ns/frame"
+                      << std::setprecision(0)
+                      << std::setw(10) << result.realtime << "x realtime"
+                      << std::defaultfloat << std::endl;
+        }
+
+        void print_json(std::ostream& out) const {
+            out << "{\"sample_rate\": " << SAMPLE_RATE
+                      << ", \"min_time\": " << options_.min_seconds
+                      << ", \"results\": [";
+            for (size_t i = 0; i < results_.size(); ++i) {
+                const Result& result = results_[i];
+                out << (i > 0 ? "," : "") << "\n  {\"name\": \"" << result.name << "\""
+                          << ", \"frame_size\": " << result.frame_size
+                          << ", \"iterations\": " << result.iterations
+                          << std::fixed << std::setprecision(1)
+                          << ", \"ns_per_frame\": " << result.ns_per_frame
+                          << ", \"realtime\": " << result.realtime
+                          << std::defaultfloat << "}";
+            }
+            out << "\n]}" << std::endl;
+        }
+
+    private:
+        Options options_;
+        std::vector<float> signal_;
+        std::vector<Result> results_;
+
+        // Результаты тел копятся сюда, чтобы компилятор их не выбросил
+        volatile double sink_ = 0.0;
+    };
+
+    void print_usage() {
+        std::cout << "\n⏱️  VOICE MICROBENCHMARKS\n" << std::endl;
+        std::cout << "Usage: ./voice_bench [options]" << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --min-time=S      Measure each benchmark for at least S seconds (default 0.5)" << std::endl;
+        std::cout << "  --filter=TEXT     Run only benchmarks whose name contains TEXT" << std::endl;
+        std::cout << "                    (fft, ns/, vp/, vp-fixed/, opus/, queue/, crypto/)" << std::endl;
+        std::cout << "  --json            Machine-readable output" << std::endl;
+        std::cout << "\nFrames are " << FRAME_SIZE << " samples at " << SAMPLE_RATE
+                  << " Hz unless the name says otherwise.\n" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            options.min_seconds = std::atof(arg.c_str() + 11);
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = arg.substr(9);
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            std::cerr << "❌ Error: Unknown option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (options.min_seconds <= 0.0) {
+        print_usage();
+        return 1;
+    }
+
+    BenchRunner bench(options);
+    return bench.run();
+}
@@ -0,0 +1,241 @@
+// Самопроверка шифрования пакетов: PacketCrypto seal/open туда и обратно
+// (AES-128 и AES-256), отказ при подмене любого байта, уникальность nonce
+// у потоков с общими ssrc и номерами (звук и receiver reports клиента,
+// уровни перекодирования ретранслятора) и края ReplayWindow/ReplayFilter:
+// дубли, номера старше окна, переход номера через 2^32.
+// Код возврата 0, если все проверки прошли.
+#include "../include/PacketCrypto.hpp"
+#include "../include/Protocol.hpp"
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    const char* KEY_128 = "000102030405060708090a0b0c0d0e0f";
+    const char* KEY_256 = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+    const char* OTHER_KEY_256 = "ff0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+
+    constexpr uint32_t SALT = 0x5a17c0de;
+    constexpr uint32_t SSRC = 0x01020304;
+    // Пакетов на поток в проверке nonce: звук и отчеты с одними номерами
+    constexpr uint32_t NONCE_PACKETS = 4096;
+    // Нули за заголовком: шифротекст нулей — это и есть ключевой поток,
+    // совпадение ключевого потока означает повтор nonce
+    constexpr size_t KEYSTREAM_BYTES = 16;
+
+    int failures = 0;
+
+    void report(bool ok, const std::string& name, const std::string& detail) {
+        std::cout << (ok ? "  ✅ " : "  ❌ ") << name << ": " << detail << std::endl;
+        if (!ok) failures++;
+    }
+
+    std::vector<unsigned char> make_packet(uint8_t type, uint8_t tier, uint32_t sequence, size_t payload) {
+        protocol::PacketHeader header;
+        header.type = type;
+        header.tier = tier;
+        header.room = 7;
+        header.ssrc = SSRC;
+        header.sequence = sequence;
+        header.timestamp = sequence * 960;
+
+        std::vector<unsigned char> packet(protocol::HEADER_SIZE + payload);
+        protocol::write_header(packet.data(), header);
+        for (size_t i = 0; i < payload; ++i) {
+            packet[protocol::HEADER_SIZE + i] = static_cast<unsigned char>(i * 31 + sequence);
+        }
+        return packet;
+    }
+
+    std::vector<unsigned char> seal(PacketCrypto& crypto, const std::vector<unsigned char>& packet) {
+        std::vector<unsigned char> sealed(packet.size() + PacketCrypto::OVERHEAD);
+        sealed.resize(crypto.seal(packet.data(), packet.size(), SALT, sealed.data()));
+        return sealed;
+    }
+
+    size_t open(PacketCrypto& crypto, const std::vector<unsigned char>& sealed, std::vector<unsigned char>& out,
+                uint32_t* salt = nullptr) {
+        out.assign(sealed.size(), 0);
+        return crypto.open(sealed.data(), sealed.size(), out.data(), salt);
+    }
+
+    void check_round_trip(const char* key, const std::string& name) {
+        PacketCrypto crypto;
+        if (!crypto.set_key_hex(key)) {
+            report(false, name, "key rejected");
+            return;
+        }
+
+        int passed = 0;
+        int total = 0;
+        for (size_t payload : {size_t(0), size_t(1), size_t(60), size_t(1276)}) {
+            std::vector<unsigned char> packet = make_packet(protocol::PACKET_AUDIO, 0, 42, payload);
+            std::vector<unsigned char> sealed = seal(crypto, packet);
+            std::vector<unsigned char> opened;
+            uint32_t salt = 0;
+            size_t size = open(crypto, sealed, opened, &salt);
+
+            total++;
+            bool ok = sealed.size() == packet.size() + PacketCrypto::OVERHEAD &&
+                      (sealed[0] & protocol::PACKET_ENCRYPTED) &&
+                      size == packet.size() && salt == SALT &&
+                      memcmp(opened.data(), packet.data(), packet.size()) == 0;
+            if (ok) passed++;
+        }
+        report(passed == total, name + " round trip",
+               std::to_string(passed) + "/" + std::to_string(total) + " payload sizes (0, 1, 60, 1276 bytes)");
+    }
+
+    void check_tamper() {
+        PacketCrypto crypto;
+        crypto.set_key_hex(KEY_256);
+        std::vector<unsigned char> sealed = seal(crypto, make_packet(protocol::PACKET_AUDIO, 0, 7, 60));
+        std::vector<unsigned char> opened;
+
+        // Каждый байт: заголовок и salt (AAD), шифротекст, тег. Флаг
+        // шифрования в type не трогаем — без него пакет и так отвергается
+        int accepted = 0;
+        for (size_t i = 0; i < sealed.size(); ++i) {
+            for (unsigned char bit : {0x01, 0x40}) {
+                std::vector<unsigned char> tampered = sealed;
+                tampered[i] ^= bit;
+                if (open(crypto, tampered, opened) != 0) accepted++;
+            }
+        }
+        report(accepted == 0, "tamper",
+               std::to_string(accepted) + " of " + std::to_string(sealed.size() * 2) + " single-bit flips accepted");
+
+        std::vector<unsigned char> truncated(sealed.begin(), sealed.end() - 1);
+        std::vector<unsigned char> plain = make_packet(protocol::PACKET_AUDIO, 0, 7, 60);
+        PacketCrypto other;
+        other.set_key_hex(OTHER_KEY_256);
+        bool rejected = open(crypto, truncated, opened) == 0 &&
+                        open(crypto, plain, opened) == 0 &&
+                        open(other, sealed, opened) == 0 &&
+                        open(crypto, sealed, opened) != 0;
+        report(rejected, "reject", "truncated, unencrypted and wrong-key packets refused, original opens");
+    }
+
+    // Ключевой поток пакета: шифротекст нулевой нагрузки
+    std::string keystream(PacketCrypto& crypto, uint8_t type, uint8_t tier, uint32_t sequence) {
+        std::vector<unsigned char> packet = make_packet(type, tier, sequence, KEYSTREAM_BYTES);
+        std::fill(packet.begin() + protocol::HEADER_SIZE, packet.end(), 0);
+        std::vector<unsigned char> sealed = seal(crypto, packet);
+        const unsigned char* cipher_text = sealed.data() + protocol::HEADER_SIZE + PacketCrypto::SALT_SIZE;
+        return std::string(reinterpret_cast<const char*>(cipher_text), KEYSTREAM_BYTES);
+    }
+
+    void check_nonce_uniqueness() {
+        PacketCrypto crypto;
+        crypto.set_key_hex(KEY_256);
+
+        // Клиент: звук и отчеты с одним salt и ssrc, номера обоих счетчиков
+        // идут с нуля; ретранслятор: уровни перекодирования того же говорящего
+        struct Stream {
+            uint8_t type;
+            uint8_t tier;
+        };
+        const Stream streams[] = {
+            {protocol::PACKET_AUDIO, 0}, {protocol::PACKET_RECEIVER_REPORT, 0},
+            {protocol::PACKET_AUDIO, 1}, {protocol::PACKET_AUDIO, 2},
+            {protocol::PACKET_TRUNK_ROOMS, 0}, {protocol::PACKET_TRUNK_AUDIO, 0},
+        };
+
+        std::set<std::string> seen;
+        size_t total = 0;
+        for (const Stream& stream : streams) {
+            for (uint32_t sequence = 0; sequence < NONCE_PACKETS; ++sequence) {
+                seen.insert(keystream(crypto, stream.type, stream.tier, sequence));
+                total++;
+            }
+        }
+        report(seen.size() == total, "nonce",
+               std::to_string(total - seen.size()) + " keystream repeats in " + std::to_string(total) +
+               " packets (audio + reports + tiers + trunk, sequences 0.." + std::to_string(NONCE_PACKETS - 1) + ")");
+
+        // Проверка чувствительна: тот же поток и номер дают тот же ключевой поток
+        bool repeats = keystream(crypto, protocol::PACKET_AUDIO, 0, 5) ==
+                       keystream(crypto, protocol::PACKET_AUDIO, 0, 5);
+        report(repeats, "nonce detector", "same (type, tier, sequence) reproduces its keystream");
+    }
+
+    void check_replay_window() {
+        {
+            ReplayWindow window;
+            bool ok = window.accept(100) && !window.accept(100) &&
+                      window.accept(98) && !window.accept(98) &&
+                      window.accept(101) && !window.accept(100);
+            report(ok, "replay duplicates", "first copy accepted, repeats refused, in and out of order");
+        }
+        {
+            ReplayWindow window;
+            window.accept(1000);
+            bool ok = window.accept(1000 - (ReplayWindow::SIZE - 1)) &&
+                      !window.accept(1000 - ReplayWindow::SIZE) &&
+                      !window.accept(1000 - ReplayWindow::SIZE - 1) &&
+                      !window.accept(0);
+            report(ok, "replay window edge", "63 behind accepted, 64 and older refused");
+        }
+        {
+            ReplayWindow window;
+            window.accept(10);
+            window.accept(9);
+            // Скачок дальше окна: старые номера уже не различить — отказ
+            bool ok = window.accept(10 + ReplayWindow::SIZE + 5) &&
+                      !window.accept(10) && !window.accept(9) &&
+                      window.accept(10 + ReplayWindow::SIZE + 4);
+            report(ok, "replay jump", "jump past the window forgets old sequences, neighbours still accepted");
+        }
+        {
+            ReplayWindow window;
+            bool ok = window.accept(0xFFFFFFF0u) &&
+                      window.accept(5) &&                 // через 2^32 — вперед
+                      window.accept(0xFFFFFFF8u) &&       // 13 позади, не виден
+                      !window.accept(0xFFFFFFF0u) &&
+                      !window.accept(5) &&
+                      window.accept(0xFFFFFFFFu) &&
+                      window.accept(0) &&
+                      !window.accept(0xFFFFFFFFu) &&
+                      !window.accept(5 - ReplayWindow::SIZE);   // 0xFFFFFFC5: 64 позади
+            report(ok, "replay wraparound", "sequences across 2^32 ordered by signed distance");
+        }
+        {
+            ReplayFilter filter;
+            protocol::PacketHeader audio;
+            audio.type = protocol::PACKET_AUDIO;
+            audio.ssrc = SSRC;
+            audio.sequence = 3;
+            protocol::PacketHeader report_header = audio;
+            report_header.type = protocol::PACKET_RECEIVER_REPORT;
+            protocol::PacketHeader tier = audio;
+            tier.tier = 1;
+            protocol::PacketHeader sealed_flag = audio;
+            sealed_flag.type |= protocol::PACKET_ENCRYPTED;
+
+            bool ok = filter.accept(audio, SALT) && filter.accept(report_header, SALT) &&
+                      filter.accept(tier, SALT) && filter.accept(audio, SALT + 1) &&
+                      !filter.accept(audio, SALT) && !filter.accept(sealed_flag, SALT) &&
+                      filter.streams() == 4;
+            report(ok, "replay streams", "audio, reports, tiers and salts keep separate windows");
+        }
+    }
+}
+
+int main() {
+    std::cout << "\n🧪 PACKET CRYPTO SELF-CHECK\n" << std::endl;
+
+    check_round_trip(KEY_128, "aes-128");
+    check_round_trip(KEY_256, "aes-256");
+    check_tamper();
+    check_nonce_uniqueness();
+    check_replay_window();
+
+    if (failures > 0) {
+        std::cout << "\n❌ " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "\n✅ All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,408 @@
+// Самопроверка DSP: специализации по размеру кадра (FixedNoiseSuppressor,
+// FixedBandSplitter, FixedVoiceProcessor) против runtime-классов на одном
+// сигнале, прозрачность BandSplitter (в том числе с задержкой подавителя
+// нижней полосы), одинаковая задержка полос тракта с разделением, уровень
+// выхода тракта — шумоподавитель не должен глушить речь — и сходимость
+// EchoCanceller на всех размерах кадра, включая 2.5/5 мс профиля --low-latency. Код возврата 0, если все проверки прошли.
+#include "../include/BandSplitter.hpp"
+#include "../include/EchoCanceller.hpp"
+#include "../include/FFT.hpp"
+#include "../include/FixedBandSplitter.hpp"
+#include "../include/FixedNoiseSuppressor.hpp"
+#include "../include/FixedVoiceProcessor.hpp"
+#include "../include/NoiseSuppressor.hpp"
+#include "../include/VoiceProcessor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr int SIGNAL_SECONDS = 2;
+
+    // Расхождение специализации и runtime-класса: порядок операций FFT
+    // разный (таблица поворотов против рекурсии), -ffast-math
+    constexpr float MAX_DIFFERENCE = 1e-4f;
+    // Выход подавителя относительно входа после сходимости, дБ
+    constexpr float MIN_SUPPRESSOR_LEVEL_DB = -12.0f;
+    constexpr float MAX_SUPPRESSOR_LEVEL_DB = 1.0f;
+    // Тракт с АРУ: вход на цели АРУ (-18 dBFS) должен остаться около нее.
+    // Допуск широкий: АРУ быстро поднимает усиление в провалах огибающей
+    constexpr float INPUT_LEVEL_DB = -18.0f;
+    constexpr float MAX_CHAIN_DEVIATION_DB = 10.0f;
+
+    // Задержка по полосам при разделении: белый шум, взаимная корреляция
+    // входа и выхода только в полосе ниже и выше среза BandSplitter
+    constexpr float LOW_BAND_MAX_HZ = 6000.0f;
+    constexpr float HIGH_BAND_MIN_HZ = 10000.0f;
+    constexpr int MAX_BAND_LAG = 2048;
+
+    // Эхо: линейный тракт (задержка 5 мс, хвост 20 мс) с фоном на
+    // ECHO_TO_NOISE_DB ниже эха; ERLE меряется за последние секунды
+    constexpr int ECHO_SECONDS = 8;
+    constexpr int ECHO_MEASURE_SECONDS = 3;
+    constexpr int ECHO_DELAY = SAMPLE_RATE * 5 / 1000;
+    constexpr int ECHO_TAIL = SAMPLE_RATE * 20 / 1000;
+    constexpr float ECHO_TO_NOISE_DB = 40.0f;
+    constexpr float MIN_ERLE_DB = 30.0f;
+
+    const NoiseSuppressor::SuppressionType TYPES[] = {
+        NoiseSuppressor::SUBTRACTION, NoiseSuppressor::WIENER,
+        NoiseSuppressor::MMSE, NoiseSuppressor::SPECTRAL_GATING
+    };
+
+    int failures = 0;
+
+    void report(bool ok, const std::string& name, const std::string& detail) {
+        std::cout << (ok ? "  ✅ " : "  ❌ ") << name << ": " << detail << std::endl;
+        if (!ok) failures++;
+    }
+
+    const char* suppression_name(NoiseSuppressor::SuppressionType type) {
+        switch (type) {
+            case NoiseSuppressor::SUBTRACTION: return "subtraction";
+            case NoiseSuppressor::WIENER: return "wiener";
+            case NoiseSuppressor::SPECTRAL_GATING: return "gating";
+            case NoiseSuppressor::MMSE:
+            default: return "mmse";
+        }
+    }
+
+    // Гармоники 220 Гц со слоговой огибающей и белый шум на 20 дБ ниже
+    struct TestSignal {
+        std::vector<float> noisy;
+        std::vector<float> noise;
+    };
+
+    float rms_db(const float* x, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) sum += static_cast<double>(x[i]) * x[i];
+        return static_cast<float>(10.0 * std::log10(sum / n + 1e-20));
+    }
+
+    TestSignal make_signal(float level_db) {
+        std::mt19937 rng(7);
+        std::normal_distribution<float> white(0.0f, 1.0f);
+
+        TestSignal signal;
+        signal.noisy.resize(SAMPLE_RATE * SIGNAL_SECONDS);
+        signal.noise.resize(SAMPLE_RATE);
+        for (size_t i = 0; i < signal.noisy.size(); ++i) {
+            float t = static_cast<float>(i) / SAMPLE_RATE;
+            float envelope = 0.6f + 0.4f * std::sin(2.0f * static_cast<float>(M_PI) * 4.0f * t);
+            signal.noisy[i] = envelope * (0.7f * std::sin(2.0f * static_cast<float>(M_PI) * 220.0f * t) +
+                                          0.4f * std::sin(2.0f * static_cast<float>(M_PI) * 660.0f * t) +
+                                          0.2f * std::sin(2.0f * static_cast<float>(M_PI) * 1760.0f * t));
+        }
+
+        // Речь на level_db, шум на 20 дБ ниже
+        float voice_gain = std::pow(10.0f, (level_db - rms_db(signal.noisy.data(), signal.noisy.size())) / 20.0f);
+        float noise_rms = std::pow(10.0f, (level_db - 20.0f) / 20.0f);
+        for (float& sample : signal.noisy) sample = voice_gain * sample + noise_rms * white(rng);
+        for (float& sample : signal.noise) sample = noise_rms * white(rng);
+        return signal;
+    }
+
+    // Дальний конец — белый шум, ближний — его эхо плюс фон
+    struct EchoSignal {
+        std::vector<float> far;
+        std::vector<float> near;
+    };
+
+    EchoSignal make_echo() {
+        std::mt19937 rng(11);
+        std::normal_distribution<float> white(0.0f, 1.0f);
+
+        std::vector<float> path(ECHO_DELAY + ECHO_TAIL, 0.0f);
+        for (int i = ECHO_DELAY; i < static_cast<int>(path.size()); ++i) {
+            path[i] = 0.01f * white(rng) * std::exp(-static_cast<float>(i - ECHO_DELAY) / (ECHO_TAIL / 4));
+        }
+
+        EchoSignal signal;
+        signal.far.resize(SAMPLE_RATE * ECHO_SECONDS);
+        signal.near.resize(signal.far.size());
+        for (float& sample : signal.far) sample = 0.1f * white(rng);
+
+        for (size_t n = 0; n < signal.near.size(); ++n) {
+            float acc = 0.0f;
+            for (size_t k = 0; k < path.size() && k <= n; ++k) {
+                acc += path[k] * signal.far[n - k];
+            }
+            signal.near[n] = acc;
+        }
+
+        float noise_rms = std::pow(10.0f, (rms_db(signal.near.data(), signal.near.size()) - ECHO_TO_NOISE_DB) / 20.0f);
+        for (float& sample : signal.near) sample += noise_rms * white(rng);
+        return signal;
+    }
+
+    // Опорный кадр уходит в динамики перед захватом того же кадра, как в callback
+    void check_echo_canceller(const EchoSignal& signal, int frameSize) {
+        EchoCanceller canceller(SAMPLE_RATE, frameSize);
+        std::vector<float> out(frameSize);
+        const size_t measure_from = signal.near.size() - SAMPLE_RATE * ECHO_MEASURE_SECONDS;
+
+        double near_energy = 0.0, out_energy = 0.0;
+        for (size_t offset = 0; offset + frameSize <= signal.near.size(); offset += frameSize) {
+            canceller.pushReference(signal.far.data() + offset, frameSize);
+            canceller.process(signal.near.data() + offset, out.data());
+            if (offset < measure_from) continue;
+
+            for (int i = 0; i < frameSize; ++i) {
+                near_energy += static_cast<double>(signal.near[offset + i]) * signal.near[offset + i];
+                out_energy += static_cast<double>(out[i]) * out[i];
+            }
+        }
+
+        float erle = static_cast<float>(10.0 * std::log10(near_energy / (out_energy + 1e-20)));
+        report(erle >= MIN_ERLE_DB, "aec/" + std::to_string(frameSize) + " ERLE",
+               std::to_string(erle) + " dB (noise floor at " +
+               std::to_string(static_cast<int>(ECHO_TO_NOISE_DB)) + " dB)");
+    }
+
+    float max_difference(const std::vector<float>& a, const std::vector<float>& b) {
+        float diff = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i) diff = std::max(diff, std::abs(a[i] - b[i]));
+        return diff;
+    }
+
+    // Уровень выхода относительно входа во второй секунде (после сходимости)
+    float level_change_db(const std::vector<float>& input, const std::vector<float>& output) {
+        size_t start = SAMPLE_RATE;
+        size_t n = output.size() - start;
+        return rms_db(output.data() + start, n) - rms_db(input.data() + start, n);
+    }
+
+    template <int N>
+    void check_noise_suppressor(const TestSignal& signal) {
+        const size_t frames = signal.noisy.size() / N;
+
+        for (auto type : TYPES) {
+            NoiseSuppressor runtime(SAMPLE_RATE, N);
+            FixedNoiseSuppressor<N> fixed(SAMPLE_RATE);
+            runtime.setSuppressionType(type);
+            fixed.setSuppressionType(type);
+            runtime.calibrateNoise(std::vector<float>(signal.noise.begin(), signal.noise.begin() + N));
+            fixed.calibrateNoise(signal.noise.data());
+
+            std::vector<float> a(frames * N), b(frames * N), input(N);
+            for (size_t f = 0; f < frames; ++f) {
+                const float* in = signal.noisy.data() + f * N;
+                std::copy(in, in + N, input.begin());
+                std::vector<float> out = runtime.process(input);
+                std::copy(out.begin(), out.end(), a.begin() + f * N);
+                fixed.process(in, b.data() + f * N);
+            }
+
+            std::string name = "ns/" + std::string(suppression_name(type)) + "/" + std::to_string(N);
+            float diff = max_difference(a, b);
+            report(diff <= MAX_DIFFERENCE, name + " fixed == runtime", "max diff " + std::to_string(diff));
+
+            float level = level_change_db(signal.noisy, a);
+            report(level >= MIN_SUPPRESSOR_LEVEL_DB && level <= MAX_SUPPRESSOR_LEVEL_DB,
+                   name + " level", std::to_string(level) + " dB");
+        }
+    }
+
+    // Без изменения нижней полосы и с единичным усилением верхней
+    // выход — вход с задержкой DELAY
+    template <int N>
+    void check_band_splitter(const TestSignal& signal) {
+        const size_t frames = signal.noisy.size() / N;
+        BandSplitter runtime(N);
+        FixedBandSplitter<N> fixed;
+
+        std::vector<float> a(frames * N), b(frames * N);
+        std::vector<float> low(N / BandSplitter::DECIMATION);
+        for (size_t f = 0; f < frames; ++f) {
+            const float* in = signal.noisy.data() + f * N;
+            runtime.analyze(in, low.data());
+            runtime.synthesize(low.data(), 1.0f, a.data() + f * N);
+            fixed.analyze(in, low.data());
+            fixed.synthesize(low.data(), 1.0f, b.data() + f * N);
+        }
+
+        float error = 0.0f;
+        for (size_t i = BandSplitter::DELAY; i < a.size(); ++i) {
+            error = std::max(error, std::abs(a[i] - signal.noisy[i - BandSplitter::DELAY]));
+        }
+
+        std::string name = "split/" + std::to_string(N);
+        report(error <= MAX_DIFFERENCE, name + " reconstruction", "max error " + std::to_string(error));
+        float diff = max_difference(a, b);
+        report(diff <= MAX_DIFFERENCE, name + " fixed == runtime", "max diff " + std::to_string(diff));
+    }
+
+    // С подавителем нижней полосы в цикле (SUBTRACTION — единичные усиления)
+    // выход — вход с задержкой DELAY плюс кадр подавителя: верхняя полоса и
+    // вычитаемая нижняя должны ждать его столько же
+    template <int N>
+    void check_band_split_latency(const TestSignal& signal) {
+        constexpr int LOW = N / BandSplitter::DECIMATION;
+        const size_t frames = signal.noisy.size() / N;
+
+        NoiseSuppressor runtimeNs(SAMPLE_RATE / BandSplitter::DECIMATION, LOW);
+        BandSplitter runtime(N, runtimeNs.getLatency());
+        FixedNoiseSuppressor<LOW> fixedNs(SAMPLE_RATE / BandSplitter::DECIMATION);
+        FixedBandSplitter<N, FixedNoiseSuppressor<LOW>::LATENCY> fixed;
+        runtimeNs.setSuppressionType(NoiseSuppressor::SUBTRACTION);
+        fixedNs.setSuppressionType(NoiseSuppressor::SUBTRACTION);
+
+        std::vector<float> a(frames * N), b(frames * N), low(LOW);
+        for (size_t f = 0; f < frames; ++f) {
+            const float* in = signal.noisy.data() + f * N;
+            runtime.analyze(in, low.data());
+            std::vector<float> processed = runtimeNs.process(low);
+            runtime.synthesize(processed.data(), 1.0f, a.data() + f * N);
+            fixed.analyze(in, low.data());
+            fixedNs.process(low.data(), low.data());
+            fixed.synthesize(low.data(), 1.0f, b.data() + f * N);
+        }
+
+        const int delay = BandSplitter::DELAY + N;
+        float error = 0.0f;
+        for (size_t i = delay; i < a.size(); ++i) {
+            error = std::max(error, std::abs(a[i] - signal.noisy[i - delay]));
+        }
+
+        std::string name = "split+ns/" + std::to_string(N);
+        report(runtime.getDelay() == delay && fixed.DELAY == delay, name + " delay",
+               std::to_string(runtime.getDelay()) + " samples");
+        report(error <= MAX_DIFFERENCE, name + " reconstruction", "max error " + std::to_string(error));
+        float diff = max_difference(a, b);
+        report(diff <= MAX_DIFFERENCE, name + " fixed == runtime", "max diff " + std::to_string(diff));
+    }
+
+    // Задержка y относительно x по взаимной корреляции в полосе [lo, hi) Гц
+    int band_lag(const std::vector<float>& x, const std::vector<float>& y, float lo_hz, float hi_hz) {
+        const int n = dsp::nextPowerOfTwo(static_cast<int>(x.size()) * 2);
+        std::vector<std::complex<float>> fx(n), fy(n);
+        for (size_t i = 0; i < x.size(); ++i) {
+            fx[i] = x[i];
+            fy[i] = y[i];
+        }
+        dsp::iterativeFFT(fx);
+        dsp::iterativeFFT(fy);
+
+        // Кросс-спектр только в полосе, зеркальная половина — сопряженная
+        const int lo = static_cast<int>(lo_hz * n / SAMPLE_RATE);
+        const int hi = static_cast<int>(hi_hz * n / SAMPLE_RATE);
+        std::vector<std::complex<float>> cross(n, 0.0f);
+        for (int k = lo; k < hi; ++k) {
+            cross[k] = std::conj(fx[k]) * fy[k];
+            cross[n - k] = std::conj(cross[k]);
+        }
+        dsp::iterativeFFT(cross, true);
+
+        int best = 0;
+        for (int lag = 1; lag <= MAX_BAND_LAG; ++lag) {
+            if (cross[lag].real() > cross[best].real()) best = lag;
+        }
+        return best;
+    }
+
+    // Тракт с разделением полос, АРУ и лимитер выключены: нижняя и верхняя
+    // полосы выходят с одной задержкой
+    template <int N>
+    void check_band_lag() {
+        std::mt19937 rng(13);
+        std::normal_distribution<float> white(0.0f, 0.1f);
+        const size_t frames = SAMPLE_RATE / N;
+        std::vector<float> input(frames * N);
+        for (float& sample : input) sample = white(rng);
+
+        VoiceProcessor runtime(SAMPLE_RATE, N);
+        FixedVoiceProcessor<N> fixed(SAMPLE_RATE);
+        runtime.enableBandSplit(true);
+        fixed.enableBandSplit(true);
+        runtime.enableAutoGain(false);
+        fixed.enableAutoGain(false);
+        runtime.enableLimiter(false);
+        fixed.enableLimiter(false);
+
+        std::vector<float> a(input.size()), b(input.size());
+        for (size_t f = 0; f < frames; ++f) {
+            runtime.process(input.data() + f * N, a.data() + f * N);
+            fixed.process(input.data() + f * N, b.data() + f * N);
+        }
+
+        const int expected = BandSplitter::DELAY + N;
+        auto check = [&](const std::vector<float>& output, const std::string& variant) {
+            int low = band_lag(input, output, 0.0f, LOW_BAND_MAX_HZ);
+            int high = band_lag(input, output, HIGH_BAND_MIN_HZ, SAMPLE_RATE / 2.0f);
+            report(low == expected && high == expected,
+                   "vp/" + std::to_string(N) + "/split " + variant + " band lag",
+                   "low " + std::to_string(low) + ", high " + std::to_string(high) +
+                   " samples (expected " + std::to_string(expected) + ")");
+        };
+        check(a, "runtime");
+        check(b, "fixed");
+    }
+
+    // Весь тракт по умолчанию (с АРУ и лимитером), с разделением полос и без
+    template <int N>
+    void check_voice_processor(const TestSignal& signal) {
+        const size_t frames = signal.noisy.size() / N;
+
+        for (bool split : {false, true}) {
+            VoiceProcessor runtime(SAMPLE_RATE, N);
+            std::unique_ptr<FrameProcessor> fixed = createFrameProcessor(SAMPLE_RATE, N);
+            runtime.enableBandSplit(split);
+            fixed->enableBandSplit(split);
+            runtime.calibrateNoise(signal.noise.data());
+            fixed->calibrateNoise(signal.noise.data());
+
+            std::vector<float> a(frames * N), b(frames * N);
+            for (size_t f = 0; f < frames; ++f) {
+                const float* in = signal.noisy.data() + f * N;
+                runtime.process(in, a.data() + f * N);
+                fixed->process(in, b.data() + f * N);
+            }
+
+            std::string name = "vp/" + std::to_string(N) + (split ? "/split" : "");
+            float diff = max_difference(a, b);
+            report(diff <= MAX_DIFFERENCE, name + " fixed == runtime", "max diff " + std::to_string(diff));
+
+            float level = rms_db(a.data() + SAMPLE_RATE, a.size() - SAMPLE_RATE);
+            report(std::abs(level - INPUT_LEVEL_DB) <= MAX_CHAIN_DEVIATION_DB,
+                   name + " output level", std::to_string(level) + " dBFS for " +
+                   std::to_string(static_cast<int>(INPUT_LEVEL_DB)) + " dBFS input");
+        }
+    }
+
+    template <int N>
+    void check_frame_size(const TestSignal& signal) {
+        check_noise_suppressor<N>(signal);
+        check_band_splitter<N>(signal);
+        check_band_split_latency<N>(signal);
+        check_voice_processor<N>(signal);
+        check_band_lag<N>();
+    }
+}
+
+int main() {
+    std::cout << "\n🧪 DSP SELF-CHECK\n" << std::endl;
+
+    TestSignal signal = make_signal(INPUT_LEVEL_DB);
+    check_frame_size<120>(signal);
+    check_frame_size<240>(signal);
+    check_frame_size<480>(signal);
+    check_frame_size<960>(signal);
+
+    EchoSignal echo = make_echo();
+    for (int frameSize : {120, 240, 480, 960}) {
+        check_echo_canceller(echo, frameSize);
+    }
+
+    if (failures > 0) {
+        std::cout << "\n❌ " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "\n✅ All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,808 @@
+// Нагрузочный клиент ретранслятора: тысячи синтетических клиентов без звука.
+// Каждый клиент — свой UDP сокет (ретранслятор различает клиентов по адресу
+// и порту), каждые 10 мс шлет заранее закодированный кадр Opus в свою комнату.
+// Клиенты добавляются ступенями; по каждой ступени — потери, задержка и
+// джиттер у получателей, в конце — точка насыщения ретранслятора.
+// С --ports клиенты одной комнаты расходятся по нескольким ретрансляторам,
+// связанным транками: звук идет через соседний узел.
+#include "../include/OpusCodec.hpp"
+#include "../include/Protocol.hpp"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr int FRAME_SIZE = SAMPLE_RATE / 100;
+    constexpr auto TICK = std::chrono::milliseconds(10);
+    // Заранее закодированный звук — 1 с, дальше по кругу
+    constexpr int PRECODED_FRAMES = 100;
+    // Время отправки последних пакетов клиента: 5 с при 10 мс
+    constexpr uint32_t SEND_RING = 512;
+    // Гистограмма задержки: шаг 100 мкс, все дольше 1 с — в последней ячейке
+    constexpr int LATENCY_BUCKET_US = 100;
+    constexpr int LATENCY_BUCKETS = 10000;
+    // Пакеты опоздавшие дольше — в статистику ступени не попадают
+    constexpr auto REPORT_GRACE = std::chrono::milliseconds(500);
+    constexpr int RECV_BATCH = 32;
+    constexpr int MAX_DATAGRAM = 1500;
+    constexpr int SOCKET_BUFFER_BYTES = 256 * 1024;
+
+    std::atomic<bool> running(true);
+
+    void signal_handler(int) {
+        running = false;
+    }
+
+    uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+    }
+
+    struct Options {
+        std::string server_ip = "127.0.0.1";
+        int port = 8888;
+        std::vector<int> ports;      // несколько ретрансляторов: клиенты по кругу
+        int max_clients = 1000;
+        int start_clients = 50;
+        int step_clients = 50;
+        double step_seconds = 5.0;
+        int room_size = 5;
+        int base_room = 1;
+        int threads = 0;
+        int bitrate = 24000;
+        double max_loss_percent = 1.0;
+        double max_p99_ms = 50.0;
+        bool keep_going = false;
+    };
+
+    // Слот статистики ступени: текущая и предыдущая, которую еще досчитываем
+    inline int slot_of(int step) { return step & 1; }
+
+    struct SentPacket {
+        std::atomic<uint32_t> sequence{UINT32_MAX};
+        std::atomic<int32_t> step{-1};
+        std::atomic<uint64_t> time_ns{0};
+    };
+
+    // RFC 3550: J += (|D| - J) / 16 по каждой паре получатель — отправитель
+    struct JitterState {
+        int64_t last_transit_ns = 0;
+        double jitter_ns = 0.0;
+        bool valid = false;
+    };
+
+    struct Client {
+        int fd = -1;
+        uint32_t id = 0;
+        uint16_t room = 0;
+        const sockaddr_in* server = nullptr;
+        int first_step = 0;          // ступень, на которой клиент подключился
+        uint32_t sequence = 0;
+
+        std::array<SentPacket, SEND_RING> sent_ring;
+        std::atomic<uint64_t> sent[2] = {{0}, {0}};
+        std::atomic<uint64_t> received[2] = {{0}, {0}};
+
+        // Только поток-владелец
+        std::unordered_map<uint32_t, JitterState> jitter;
+    };
+
+    // Счетчики ступени одного потока, читает и обнуляет главный поток
+    struct WorkerStats {
+        std::array<std::atomic<uint32_t>, LATENCY_BUCKETS> latency[2];
+        std::atomic<uint64_t> latency_max_us[2] = {{0}, {0}};
+        std::atomic<uint64_t> jitter_sum_us[2] = {{0}, {0}};
+        std::atomic<uint64_t> jitter_samples[2] = {{0}, {0}};
+        std::atomic<uint64_t> late_ticks[2] = {{0}, {0}};
+
+        WorkerStats() {
+            for (auto& slot : latency) {
+                for (auto& bucket : slot) bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    struct StepReport {
+        int step = 0;
+        int clients = 0;
+        int measured_receivers = 0;
+        uint64_t expected = 0;
+        uint64_t received = 0;
+        double loss_percent = 0.0;
+        double worst_client_loss_percent = 0.0;
+        double p50_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+        double jitter_ms = 0.0;
+        uint64_t late_ticks = 0;
+        bool failed = false;
+    };
+
+    class LoadGenerator {
+    public:
+        explicit LoadGenerator(const Options& options) : options_(options) {}
+
+        ~LoadGenerator() {
+            stop_workers();
+            for (auto& client : clients_) {
+                if (client->fd != -1) close(client->fd);
+            }
+        }
+
+        bool init() {
+            std::vector<int> ports = options_.ports;
+            if (ports.empty()) ports.push_back(options_.port);
+            for (int port : ports) {
+                sockaddr_in server{};
+                server.sin_family = AF_INET;
+                server.sin_port = htons(port);
+                if (inet_pton(AF_INET, options_.server_ip.c_str(), &server.sin_addr) != 1) {
+                    std::cerr << "❌ Invalid server address: " << options_.server_ip << std::endl;
+                    return false;
+                }
+                servers_.push_back(server);
+            }
+
+            if (!raise_fd_limit()) return false;
+            if (!precode_frames()) return false;
+
+            clients_.reserve(options_.max_clients);
+            for (int i = 0; i < options_.max_clients; ++i) {
+                auto client = std::make_unique<Client>();
+                client->id = static_cast<uint32_t>(i);
+                client->room = static_cast<uint16_t>(options_.base_room + i / options_.room_size);
+                // Соседи по комнате — на разных ретрансляторах
+                client->server = &servers_[i % servers_.size()];
+                client->fd = open_socket();
+                if (client->fd == -1) {
+                    std::cerr << "❌ Failed to open socket for client " << i
+                              << ": " << strerror(errno) << std::endl;
+                    return false;
+                }
+                clients_.push_back(std::move(client));
+            }
+
+            int threads = options_.threads > 0
+                ? options_.threads
+                : std::max(1u, std::thread::hardware_concurrency() / 2);
+            workers_.resize(threads);
+            for (auto& worker : workers_) {
+                worker.stats = std::make_unique<WorkerStats>();
+                worker.epoll_fd = epoll_create1(0);
+                if (worker.epoll_fd == -1) return false;
+            }
+
+            // Клиенты по потокам — через одного, чтобы ступени нагружали всех поровну
+            for (size_t i = 0; i < clients_.size(); ++i) {
+                Worker& worker = workers_[i % workers_.size()];
+                worker.clients.push_back(clients_[i].get());
+
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.ptr = clients_[i].get();
+                if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, clients_[i]->fd, &event) == -1) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int run() {
+            current_step_ = -1;
+            activate(options_.start_clients, -1);
+            start_workers();
+
+            std::cout << "🚀 " << workers_.size() << " worker threads, "
+                      << options_.room_size << " clients per room, "
+                      << packet_bytes_ << " B average payload" << std::endl;
+
+            // Разогрев: ретранслятор узнает первых клиентов
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+
+            print_header();
+
+            const auto step_duration = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(options_.step_seconds));
+
+            StepReport last_good;
+            StepReport first_failed;
+            bool have_good = false;
+            bool saturated = false;
+
+            int step = 0;
+            current_step_ = step;
+            auto step_end = Clock::now() + step_duration;
+
+            while (running) {
+                std::this_thread::sleep_until(step_end);
+                if (!running) break;
+
+                bool last_step = active_ >= static_cast<int>(clients_.size());
+
+                // Следующая ступень стартует сразу, текущую досчитываем после паузы
+                int next = step + 1;
+                if (!last_step) {
+                    activate(std::min<int>(active_ + options_.step_clients, clients_.size()), next);
+                }
+                current_step_ = next;
+                auto next_end = Clock::now() + step_duration;
+
+                std::this_thread::sleep_for(REPORT_GRACE);
+                StepReport report = collect(step);
+                print_report(report);
+
+                if (report.failed) {
+                    if (!saturated) first_failed = report;
+                    saturated = true;
+                } else if (!saturated) {
+                    last_good = report;
+                    have_good = true;
+                }
+
+                if (last_step || (saturated && !options_.keep_going)) break;
+
+                step = next;
+                step_end = next_end;
+            }
+
+            stop_workers();
+            print_summary(have_good, last_good, saturated, first_failed);
+            return 0;
+        }
+
+    private:
+        struct Worker {
+            std::vector<Client*> clients;
+            int epoll_fd = -1;
+            std::unique_ptr<WorkerStats> stats;
+            std::thread thread;
+        };
+
+        bool raise_fd_limit() {
+            rlimit limit{};
+            getrlimit(RLIMIT_NOFILE, &limit);
+
+            rlim_t needed = static_cast<rlim_t>(options_.max_clients) + 64;
+            if (limit.rlim_cur < needed) {
+                limit.rlim_cur = std::min(needed, limit.rlim_max);
+                setrlimit(RLIMIT_NOFILE, &limit);
+                getrlimit(RLIMIT_NOFILE, &limit);
+            }
+
+            if (limit.rlim_cur < needed) {
+                std::cerr << "❌ Need " << needed << " file descriptors, limit is "
+                          << limit.rlim_cur << " (raise ulimit -n)" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        int open_socket() {
+            int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+            if (fd == -1) return -1;
+
+            int size = SOCKET_BUFFER_BYTES;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+            sockaddr_in local{};
+            local.sin_family = AF_INET;
+            local.sin_addr.s_addr = htonl(INADDR_ANY);
+            local.sin_port = 0;
+            if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == -1) {
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        // Синтетическая "речь": тон с гармониками и слоговой огибающей 4 Гц
+        bool precode_frames() {
+            OpusCodec codec;
+            if (!codec.init(SAMPLE_RATE, 1)) return false;
+            codec.setBitrate(options_.bitrate);
+
+            std::vector<float> pcm(FRAME_SIZE);
+            unsigned char packet[OpusCodec::MAX_PACKET_SIZE];
+            size_t total = 0;
+
+            frames_.reserve(PRECODED_FRAMES);
+            for (int f = 0; f < PRECODED_FRAMES; ++f) {
+                for (int i = 0; i < FRAME_SIZE; ++i) {
+                    double t = static_cast<double>(f * FRAME_SIZE + i) / SAMPLE_RATE;
+                    double envelope = 0.5 * (1.0 - cos(2.0 * M_PI * 4.0 * t));
+                    double pitch = 140.0 + 30.0 * sin(2.0 * M_PI * 0.7 * t);
+                    double voice = 0.5 * sin(2.0 * M_PI * pitch * t)
+                                 + 0.25 * sin(2.0 * M_PI * 2.0 * pitch * t)
+                                 + 0.12 * sin(2.0 * M_PI * 3.0 * pitch * t);
+                    pcm[i] = static_cast<float>(0.4 * envelope * voice);
+                }
+
+                int bytes = codec.encode(pcm.data(), FRAME_SIZE, packet, sizeof(packet));
+                if (bytes < 0) {
+                    std::cerr << "❌ Opus encode failed: " << OpusCodec::errorString(bytes) << std::endl;
+                    return false;
+                }
+
+                frames_.emplace_back(packet, packet + bytes);
+                total += bytes;
+            }
+
+            packet_bytes_ = total / frames_.size();
+            return true;
+        }
+
+        void activate(int count, int step) {
+            for (int i = active_; i < count; ++i) {
+                clients_[i]->first_step = step;
+            }
+            active_.store(count, std::memory_order_release);
+        }
+
+        void start_workers() {
+            workers_running_ = true;
+            for (size_t w = 0; w < workers_.size(); ++w) {
+                workers_[w].thread = std::thread(&LoadGenerator::worker_loop, this, w);
+            }
+        }
+
+        void stop_workers() {
+            workers_running_ = false;
+            for (auto& worker : workers_) {
+                if (worker.thread.joinable()) worker.thread.join();
+                if (worker.epoll_fd != -1) {
+                    close(worker.epoll_fd);
+                    worker.epoll_fd = -1;
+                }
+            }
+        }
+
+        void worker_loop(size_t index) {
+            Worker& worker = workers_[index];
+
+            // Потоки сдвинуты внутри тика: отправка не приходит одной пачкой
+            Clock::time_point next_tick = Clock::now() +
+                std::chrono::duration_cast<Clock::duration>(TICK) * static_cast<int>(index) /
+                static_cast<int>(workers_.size());
+
+            std::vector<epoll_event> events(256);
+            while (workers_running_) {
+                int step = current_step_.load(std::memory_order_acquire);
+                int active = active_.load(std::memory_order_acquire);
+
+                for (Client* client : worker.clients) {
+                    if (static_cast<int>(client->id) >= active) break;
+                    send_frame(*client, step);
+                }
+
+                next_tick += TICK;
+                auto now = Clock::now();
+                if (now > next_tick) {
+                    // Не успели разослать за тик — упирается сам генератор
+                    if (step >= 0) {
+                        worker.stats->late_ticks[slot_of(step)].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    next_tick = now;
+                }
+
+                // До следующего тика — прием
+                while (workers_running_) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        next_tick - Clock::now()).count();
+                    if (remaining <= 0) break;
+
+                    int ready = epoll_wait(worker.epoll_fd, events.data(), events.size(),
+                                           static_cast<int>(remaining));
+                    for (int i = 0; i < ready; ++i) {
+                        receive_all(*static_cast<Client*>(events[i].data.ptr), *worker.stats);
+                    }
+                }
+            }
+        }
+
+        void send_frame(Client& client, int step) {
+            const auto& frame = frames_[client.sequence % frames_.size()];
+
+            protocol::PacketHeader header;
+            header.room = client.room;
+            header.ssrc = client.id;
+            header.sequence = client.sequence;
+            header.timestamp = client.sequence * FRAME_SIZE;
+
+            unsigned char packet[protocol::HEADER_SIZE + OpusCodec::MAX_PACKET_SIZE];
+            protocol::write_header(packet, header);
+            memcpy(packet + protocol::HEADER_SIZE, frame.data(), frame.size());
+
+            SentPacket& entry = client.sent_ring[client.sequence % SEND_RING];
+            entry.step.store(step, std::memory_order_relaxed);
+            entry.time_ns.store(now_ns(), std::memory_order_relaxed);
+            entry.sequence.store(client.sequence, std::memory_order_release);
+
+            ssize_t sent = sendto(client.fd, packet, protocol::HEADER_SIZE + frame.size(), 0,
+                                  reinterpret_cast<const sockaddr*>(client.server), sizeof(*client.server));
+            if (sent > 0 && step >= 0) {
+                client.sent[slot_of(step)].fetch_add(1, std::memory_order_relaxed);
+            }
+            client.sequence++;
+        }
+
+        void receive_all(Client& client, WorkerStats& stats) {
+            unsigned char buffers[RECV_BATCH][MAX_DATAGRAM];
+            iovec iov[RECV_BATCH];
+            mmsghdr messages[RECV_BATCH];
+
+            for (int i = 0; i < RECV_BATCH; ++i) {
+                iov[i].iov_base = buffers[i];
+                iov[i].iov_len = MAX_DATAGRAM;
+                memset(&messages[i].msg_hdr, 0, sizeof(messages[i].msg_hdr));
+                messages[i].msg_hdr.msg_iov = &iov[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            while (true) {
+                int count = recvmmsg(client.fd, messages, RECV_BATCH, MSG_DONTWAIT, nullptr);
+                if (count <= 0) break;
+
+                uint64_t arrival = now_ns();
+                for (int i = 0; i < count; ++i) {
+                    account_packet(client, buffers[i], messages[i].msg_len, arrival, stats);
+                }
+                if (count < RECV_BATCH) break;
+            }
+        }
+
+        void account_packet(Client& receiver, const unsigned char* data, size_t size,
+                            uint64_t arrival, WorkerStats& stats) {
+            protocol::PacketHeader header;
+            if (!protocol::read_header(data, size, header)) return;
+            if (header.type != protocol::PACKET_AUDIO || header.ssrc >= clients_.size()) return;
+
+            const SentPacket& entry = clients_[header.ssrc]->sent_ring[header.sequence % SEND_RING];
+            if (entry.sequence.load(std::memory_order_acquire) != header.sequence) return;
+
+            int step = entry.step.load(std::memory_order_relaxed);
+            uint64_t sent_ns = entry.time_ns.load(std::memory_order_relaxed);
+
+            // Пакеты разогрева и ступеней, которые уже посчитаны, не учитываем
+            int current = current_step_.load(std::memory_order_relaxed);
+            if (step < 0 || step < current - 1) return;
+
+            int slot = slot_of(step);
+            receiver.received[slot].fetch_add(1, std::memory_order_relaxed);
+
+            int64_t transit = static_cast<int64_t>(arrival - sent_ns);
+            uint64_t latency_us = static_cast<uint64_t>(std::max<int64_t>(transit, 0)) / 1000;
+            size_t bucket = std::min<uint64_t>(latency_us / LATENCY_BUCKET_US, LATENCY_BUCKETS - 1);
+            stats.latency[slot][bucket].fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t previous_max = stats.latency_max_us[slot].load(std::memory_order_relaxed);
+            while (latency_us > previous_max &&
+                   !stats.latency_max_us[slot].compare_exchange_weak(previous_max, latency_us,
+                                                                     std::memory_order_relaxed)) {}
+
+            JitterState& jitter = receiver.jitter[header.ssrc];
+            if (jitter.valid) {
+                double d = std::abs(static_cast<double>(transit - jitter.last_transit_ns));
+                jitter.jitter_ns += (d - jitter.jitter_ns) / 16.0;
+                stats.jitter_sum_us[slot].fetch_add(static_cast<uint64_t>(jitter.jitter_ns / 1000.0),
+                                                    std::memory_order_relaxed);
+                stats.jitter_samples[slot].fetch_add(1, std::memory_order_relaxed);
+            }
+            jitter.last_transit_ns = transit;
+            jitter.valid = true;
+        }
+
+        // Итоги ступени; счетчики ее слота обнуляются под следующую ступень
+        StepReport collect(int step) {
+            const int slot = slot_of(step);
+            StepReport report;
+            report.step = step;
+            report.clients = 0;
+
+            for (const auto& client : clients_) {
+                if (client->first_step <= step && static_cast<int>(client->id) < active_) {
+                    report.clients++;
+                }
+            }
+
+            // Отправлено в каждую комнату за ступень
+            std::unordered_map<uint16_t, uint64_t> room_sent;
+            for (const auto& client : clients_) {
+                room_sent[client->room] += client->sent[slot].load(std::memory_order_relaxed);
+            }
+
+            // Получатель ждет все, что отправили остальные участники комнаты.
+            // Подключившиеся на этой ступени не считаются: ретранслятор узнает их
+            // только по первому пакету
+            double worst = 0.0;
+            for (const auto& client : clients_) {
+                if (client->first_step >= step || static_cast<int>(client->id) >= active_) continue;
+
+                uint64_t expected = room_sent[client->room] - client->sent[slot].load(std::memory_order_relaxed);
+                uint64_t received = std::min(client->received[slot].load(std::memory_order_relaxed), expected);
+                if (expected == 0) continue;
+
+                report.expected += expected;
+                report.received += received;
+                report.measured_receivers++;
+                worst = std::max(worst, 100.0 * (expected - received) / expected);
+            }
+            report.worst_client_loss_percent = worst;
+            if (report.expected > 0) {
+                report.loss_percent = 100.0 * (report.expected - report.received) / report.expected;
+            }
+
+            std::vector<uint64_t> histogram(LATENCY_BUCKETS, 0);
+            uint64_t samples = 0, jitter_sum = 0, jitter_samples = 0, max_us = 0;
+            for (auto& worker : workers_) {
+                WorkerStats& stats = *worker.stats;
+                for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+                    uint32_t value = stats.latency[slot][b].exchange(0, std::memory_order_relaxed);
+                    histogram[b] += value;
+                    samples += value;
+                }
+                max_us = std::max(max_us, stats.latency_max_us[slot].exchange(0, std::memory_order_relaxed));
+                jitter_sum += stats.jitter_sum_us[slot].exchange(0, std::memory_order_relaxed);
+                jitter_samples += stats.jitter_samples[slot].exchange(0, std::memory_order_relaxed);
+                report.late_ticks += stats.late_ticks[slot].exchange(0, std::memory_order_relaxed);
+            }
+
+            report.p50_ms = percentile(histogram, samples, 0.50);
+            report.p99_ms = percentile(histogram, samples, 0.99);
+            report.max_ms = max_us / 1000.0;
+            report.jitter_ms = jitter_samples > 0 ? jitter_sum / 1000.0 / jitter_samples : 0.0;
+
+            for (auto& client : clients_) {
+                client->sent[slot].store(0, std::memory_order_relaxed);
+                client->received[slot].store(0, std::memory_order_relaxed);
+            }
+
+            report.failed = report.measured_receivers > 0 &&
+                            (report.loss_percent > options_.max_loss_percent ||
+                             report.p99_ms > options_.max_p99_ms);
+            return report;
+        }
+
+        static double percentile(const std::vector<uint64_t>& histogram, uint64_t samples, double q) {
+            if (samples == 0) return 0.0;
+
+            uint64_t rank = static_cast<uint64_t>(std::ceil(q * samples));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < histogram.size(); ++b) {
+                seen += histogram[b];
+                if (seen >= rank) {
+                    return (b + 1) * LATENCY_BUCKET_US / 1000.0;
+                }
+            }
+            return LATENCY_BUCKETS * LATENCY_BUCKET_US / 1000.0;
+        }
+
+        void print_header() const {
+            std::cout << "\n step  clients   pkt/s in  pkt/s out   loss%  worst%   p50ms   p99ms   maxms  jitter  late\n"
+                      << " ----  -------  ---------  ---------  ------  ------  ------  ------  ------  ------  ----"
+                      << std::endl;
+        }
+
+        void print_report(const StepReport& report) const {
+            // Ожидаемая нагрузка ретранслятора: входящие и исходящие пакеты
+            const double packets_per_client = 1000.0 / std::chrono::milliseconds(TICK).count();
+            double in_rate = report.clients * packets_per_client;
+            double out_rate = in_rate * (std::min(options_.room_size, std::max(report.clients, 1)) - 1);
+
+            std::cout << std::fixed
+                      << std::setw(5) << report.step
+                      << std::setw(9) << report.clients
+                      << std::setw(11) << std::setprecision(0) << in_rate
+                      << std::setw(11) << out_rate
+                      << std::setw(8) << std::setprecision(2) << report.loss_percent
+                      << std::setw(8) << report.worst_client_loss_percent
+                      << std::setw(8) << std::setprecision(1) << report.p50_ms
+                      << std::setw(8) << report.p99_ms
+                      << std::setw(8) << report.max_ms
+                      << std::setw(8) << std::setprecision(2) << report.jitter_ms
+                      << std::setw(6) << report.late_ticks
+                      << (report.failed ? "  ❌" : "  ✅") << std::endl;
+
+            if (report.late_ticks > 0) {
+                std::cout << "       ⚠️  generator missed " << report.late_ticks
+                          << " ticks: results are bound by this machine, not the relay" << std::endl;
+            }
+        }
+
+        void print_summary(bool have_good, const StepReport& last_good,
+                           bool saturated, const StepReport& first_failed) const {
+            std::cout << "\n========================================" << std::endl;
+            std::cout << "         RELAY CAPACITY SUMMARY         " << std::endl;
+            std::cout << "========================================" << std::endl;
+            std::cout << "Limits: loss <= " << std::setprecision(2) << options_.max_loss_percent
+                      << "%, p99 <= " << std::setprecision(1) << options_.max_p99_ms << " ms" << std::endl;
+
+            if (have_good) {
+                std::cout << "✅ Last good step:   " << last_good.clients << " clients ("
+                          << std::setprecision(2) << last_good.loss_percent << "% loss, p99 "
+                          << std::setprecision(1) << last_good.p99_ms << " ms)" << std::endl;
+            }
+
+            if (saturated) {
+                std::cout << "❌ Saturated at:     " << first_failed.clients << " clients ("
+                          << std::setprecision(2) << first_failed.loss_percent << "% loss, p99 "
+                          << std::setprecision(1) << first_failed.p99_ms << " ms)" << std::endl;
+                if (have_good) {
+                    std::cout << "📈 Capacity between " << last_good.clients << " and "
+                              << first_failed.clients << " clients; rerun with --start="
+                              << last_good.clients << " and a smaller --step to narrow it" << std::endl;
+                } else {
+                    std::cout << "📈 Saturated at the first step; rerun with a smaller --start" << std::endl;
+                }
+                if (first_failed.late_ticks > 0) {
+                    std::cout << "⚠️  The generator was overloaded at that step too; "
+                              << "use more --threads or a second machine" << std::endl;
+                }
+            } else if (running) {
+                std::cout << "✅ No saturation up to " << clients_.size()
+                          << " clients; raise --clients" << std::endl;
+            } else {
+                std::cout << "⏹️  Interrupted before saturation" << std::endl;
+            }
+        }
+
+    private:
+        Options options_;
+        std::vector<sockaddr_in> servers_;
+
+        std::vector<std::vector<unsigned char>> frames_;
+        size_t packet_bytes_ = 0;
+
+        std::vector<std::unique_ptr<Client>> clients_;
+        std::vector<Worker> workers_;
+
+        std::atomic<int> active_{0};
+        std::atomic<int> current_step_{-1};
+        std::atomic<bool> workers_running_{false};
+    };
+
+    void print_usage() {
+        std::cout << "\n📈 RELAY LOAD GENERATOR\n" << std::endl;
+        std::cout << "Usage: ./voice_load [server_ip] [options]" << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --port=N          Relay port (default 8888)" << std::endl;
+        std::cout << "  --ports=A,B,...   Several trunked relays on one host: clients round-robin," << std::endl;
+        std::cout << "                    so every room spans the relays" << std::endl;
+        std::cout << "  --clients=N       Maximum simulated clients (default 1000)" << std::endl;
+        std::cout << "  --start=N         Clients in the first step (default 50)" << std::endl;
+        std::cout << "  --step=N          Clients added per step (default 50)" << std::endl;
+        std::cout << "  --step-seconds=S  Step duration (default 5)" << std::endl;
+        std::cout << "  --room-size=N     Clients per room (default 5)" << std::endl;
+        std::cout << "  --base-room=N     First room number (default 1)" << std::endl;
+        std::cout << "  --threads=N       Generator threads (default: half the cores)" << std::endl;
+        std::cout << "  --bitrate=N       Opus bitrate of the synthetic stream (default 24000)" << std::endl;
+        std::cout << "  --max-loss=P      Step fails above P% loss (default 1)" << std::endl;
+        std::cout << "  --max-p99=MS      Step fails above MS p99 latency (default 50)" << std::endl;
+        std::cout << "  --keep-going      Keep ramping after saturation" << std::endl;
+        std::cout << "\nExample:" << std::endl;
+        std::cout << "  ./voice server" << std::endl;
+        std::cout << "  ./voice_load 127.0.0.1 --clients=5000 --step=250" << std::endl;
+        std::cout << "\nTwo trunked relays:" << std::endl;
+        std::cout << "  ./voice server --port=8888 --peer=127.0.0.1:8889" << std::endl;
+        std::cout << "  ./voice server --port=8889 --peer=127.0.0.1:8888" << std::endl;
+        std::cout << "  ./voice_load 127.0.0.1 --ports=8888,8889\n" << std::endl;
+    }
+
+    bool parse_value(const std::string& arg, const char* name, std::string& value) {
+        std::string prefix = std::string(name) + "=";
+        if (arg.rfind(prefix, 0) != 0) return false;
+
+        value = arg.substr(prefix.size());
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signal_handler);
+
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        std::string value;
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg == "--keep-going") {
+            options.keep_going = true;
+        } else if (parse_value(arg, "--port", value)) {
+            options.port = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--ports", value)) {
+            options.ports.clear();
+            size_t start = 0;
+            while (start <= value.size()) {
+                size_t comma = value.find(',', start);
+                if (comma == std::string::npos) comma = value.size();
+                int port = std::atoi(value.substr(start, comma - start).c_str());
+                if (port <= 0 || port > 65535) {
+                    std::cerr << "❌ Error: Invalid port list '" << value << "'" << std::endl;
+                    return 1;
+                }
+                options.ports.push_back(port);
+                start = comma + 1;
+            }
+        } else if (parse_value(arg, "--clients", value)) {
+            options.max_clients = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--start", value)) {
+            options.start_clients = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--step", value)) {
+            options.step_clients = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--step-seconds", value)) {
+            options.step_seconds = std::atof(value.c_str());
+        } else if (parse_value(arg, "--room-size", value)) {
+            options.room_size = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--base-room", value)) {
+            options.base_room = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--threads", value)) {
+            options.threads = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--bitrate", value)) {
+            options.bitrate = std::atoi(value.c_str());
+        } else if (parse_value(arg, "--max-loss", value)) {
+            options.max_loss_percent = std::atof(value.c_str());
+        } else if (parse_value(arg, "--max-p99", value)) {
+            options.max_p99_ms = std::atof(value.c_str());
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "❌ Error: Unknown option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            options.server_ip = arg;
+        }
+    }
+
+    options.start_clients = std::clamp(options.start_clients, 1, std::max(options.max_clients, 1));
+    if (options.max_clients < 1 || options.step_clients < 1 || options.room_size < 2 ||
+        options.step_seconds <= 1.0 ||
+        options.base_room + (options.max_clients - 1) / options.room_size > 65535) {
+        std::cerr << "❌ Error: Need clients >= 1, step >= 1, room size >= 2, "
+                  << "step longer than 1 s and rooms within 0-65535" << std::endl;
+        print_usage();
+        return 1;
+    }
+
+    std::cout << "📈 Load test against " << options.server_ip << ":";
+    if (options.ports.empty()) {
+        std::cout << options.port;
+    } else {
+        for (size_t i = 0; i < options.ports.size(); ++i) {
+            std::cout << (i > 0 ? "," : "") << options.ports[i];
+        }
+    }
+    std::cout << ": " << options.start_clients << " -> " << options.max_clients
+              << " clients, +" << options.step_clients << " every "
+              << options.step_seconds << " s" << std::endl;
+
+    LoadGenerator generator(options);
+    if (!generator.init()) {
+        std::cerr << "❌ Initialization failed" << std::endl;
+        return 1;
+    }
+
+    return generator.run();
+}
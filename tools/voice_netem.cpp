@@ -0,0 +1,621 @@
+// Эмулятор плохой сети: UDP прокси между клиентами и ретранслятором.
+// На каждый адрес клиента — свой сокет к ретранслятору, так что тот
+// по-прежнему различает клиентов. В каждом направлении каждого клиента
+// свое звено: потери (равномерные и пачками по модели Gilbert–Elliott),
+// задержка, джиттер, переупорядочивание, дубли и ограничение полосы.
+// Решения звена зависят только от seed и номера пакета в звене — прогон
+// с тем же seed и тем же трафиком повторяется.
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int MAX_DATAGRAM = 2048;
+    constexpr int SOCKET_BUFFER_BYTES = 1024 * 1024;
+    // Заголовки IP + UDP — тоже занимают полосу
+    constexpr int UDP_OVERHEAD_BYTES = 28;
+    // Ожидание в poll, когда в очереди пусто
+    constexpr uint64_t IDLE_WAIT_NS = 100'000'000;
+    constexpr uint64_t NS_PER_MS = 1'000'000;
+
+    std::atomic<bool> running(true);
+
+    void signal_handler(int) {
+        running = false;
+    }
+
+    uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+    }
+
+    // Искажения одного направления. Вероятности — доли (0..1)
+    struct Impairment {
+        double loss = 0.0;            // потери (в хорошем состоянии модели GE)
+        bool gilbert_elliott = false;
+        double ge_p = 0.0;            // хорошее -> плохое
+        double ge_r = 1.0;            // плохое -> хорошее
+        double ge_bad_loss = 1.0;     // потери в плохом состоянии
+        double delay_ms = 0.0;
+        double jitter_ms = 0.0;       // стандартное отклонение; тоже переупорядочивает
+        double reorder = 0.0;         // пакет уходит без задержки, обгоняя задержанные
+        double duplicate = 0.0;
+        double rate_kbit = 0.0;       // 0 — без ограничения
+        double queue_ms = 200.0;      // очередь перед узким местом, дальше — хвост теряется
+
+        bool active() const {
+            return loss > 0 || gilbert_elliott || delay_ms > 0 || jitter_ms > 0 ||
+                   reorder > 0 || duplicate > 0 || rate_kbit > 0;
+        }
+    };
+
+    struct LinkStats {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t delivered = 0;
+        uint64_t lost = 0;            // случайные потери
+        uint64_t burst_lost = 0;      // в плохом состоянии GE
+        uint64_t queue_dropped = 0;   // очередь полосы переполнена
+        uint64_t duplicated = 0;
+        uint64_t reordered = 0;
+
+        void add(const LinkStats& other) {
+            packets += other.packets;
+            bytes += other.bytes;
+            delivered += other.delivered;
+            lost += other.lost;
+            burst_lost += other.burst_lost;
+            queue_dropped += other.queue_dropped;
+            duplicated += other.duplicated;
+            reordered += other.reordered;
+        }
+    };
+
+    // Звено: одно направление одного клиента
+    class Link {
+    public:
+        static constexpr int MAX_COPIES = 2;
+
+        Link(const Impairment& impairment, uint64_t seed) : impairment_(impairment) {
+            std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+            rng_.seed(sequence);
+        }
+
+        // Моменты доставки копий пакета (0 — потерян, 2 — дубль)
+        int schedule(size_t bytes, uint64_t arrived_ns, uint64_t due_ns[MAX_COPIES]) {
+            stats_.packets++;
+            stats_.bytes += bytes;
+
+            // Одинаковое число случайных чисел на пакет: решения зависят
+            // только от номера пакета, не от того, какие ветки сработали
+            double u_state = uniform_(rng_);
+            double u_loss = uniform_(rng_);
+            double u_duplicate = uniform_(rng_);
+            double u_reorder = uniform_(rng_);
+            double jitter[MAX_COPIES] = {normal_(rng_), normal_(rng_)};
+
+            if (impairment_.gilbert_elliott) {
+                bad_ = bad_ ? !(u_state < impairment_.ge_r) : u_state < impairment_.ge_p;
+            }
+            if (u_loss < (bad_ ? impairment_.ge_bad_loss : impairment_.loss)) {
+                (bad_ ? stats_.burst_lost : stats_.lost)++;
+                return 0;
+            }
+
+            int copies = u_duplicate < impairment_.duplicate ? 2 : 1;
+            if (copies == 2) stats_.duplicated++;
+
+            int scheduled = 0;
+            for (int c = 0; c < copies; ++c) {
+                // Узкое место до задержки: пакеты передаются по очереди в порядке
+                // поступления. Задержка и джиттер — после него, иначе очередь
+                // возвращала бы исходный порядок и --reorder/--jitter не действовали
+                uint64_t sent = arrived_ns;
+                if (impairment_.rate_kbit > 0) {
+                    uint64_t start = std::max(arrived_ns, busy_until_ns_);
+                    if (start - arrived_ns > static_cast<uint64_t>(impairment_.queue_ms * NS_PER_MS)) {
+                        stats_.queue_dropped++;
+                        continue;
+                    }
+                    double bits = (bytes + UDP_OVERHEAD_BYTES) * 8.0;
+                    busy_until_ns_ = start + static_cast<uint64_t>(bits * 1e6 / impairment_.rate_kbit);
+                    sent = busy_until_ns_;
+                }
+
+                double delay_ms = std::max(0.0, impairment_.delay_ms + jitter[c] * impairment_.jitter_ms);
+                if (c == 0 && u_reorder < impairment_.reorder) {
+                    delay_ms = 0.0;
+                    stats_.reordered++;
+                }
+                due_ns[scheduled++] = sent + static_cast<uint64_t>(delay_ms * NS_PER_MS);
+            }
+            stats_.delivered += scheduled;
+            return scheduled;
+        }
+
+        const LinkStats& stats() const { return stats_; }
+
+    private:
+        const Impairment& impairment_;
+        std::mt19937_64 rng_;
+        std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+        std::normal_distribution<double> normal_{0.0, 1.0};
+
+        bool bad_ = false;
+        uint64_t busy_until_ns_ = 0;
+        LinkStats stats_;
+    };
+
+    struct Options {
+        std::string listen_ip = "0.0.0.0";
+        int listen_port = 12345;
+        std::string server_ip = "127.0.0.1";
+        int server_port = 12346;
+        Impairment impairment;
+        bool upstream = true;         // клиент -> ретранслятор
+        bool downstream = true;       // ретранслятор -> клиент
+        uint64_t seed = 1;
+        double seconds = 0.0;         // 0 — до Ctrl+C
+        double idle_seconds = 60.0;
+        bool quiet = false;
+    };
+
+    // Клиент прокси: его адрес, сокет к ретранслятору и два звена
+    struct Session {
+        Session(const Options& options, const Impairment& pass, uint64_t index)
+            : up(options.upstream ? options.impairment : pass, options.seed * 1000003 + index * 2)
+            , down(options.downstream ? options.impairment : pass, options.seed * 1000003 + index * 2 + 1) {}
+
+        ~Session() {
+            if (fd != -1) close(fd);
+        }
+
+        sockaddr_in client{};
+        int fd = -1;
+        uint64_t last_seen_ns = 0;
+        Link up;
+        Link down;
+    };
+
+    struct Pending {
+        uint64_t due_ns;
+        uint64_t order;               // порядок поступления при равном due
+        std::shared_ptr<Session> session;
+        bool upstream;
+        std::vector<unsigned char> data;
+
+        bool operator>(const Pending& other) const {
+            return due_ns != other.due_ns ? due_ns > other.due_ns : order > other.order;
+        }
+    };
+
+    class NetemProxy {
+    public:
+        explicit NetemProxy(const Options& options) : options_(options) {}
+
+        ~NetemProxy() {
+            if (listen_fd_ != -1) close(listen_fd_);
+        }
+
+        bool init() {
+            if (!make_address(options_.server_ip, options_.server_port, server_)) {
+                std::cerr << "❌ Invalid server address: " << options_.server_ip << std::endl;
+                return false;
+            }
+
+            sockaddr_in bind_addr{};
+            if (!make_address(options_.listen_ip, options_.listen_port, bind_addr)) {
+                std::cerr << "❌ Invalid listen address: " << options_.listen_ip << std::endl;
+                return false;
+            }
+
+            listen_fd_ = open_socket();
+            if (listen_fd_ == -1 ||
+                bind(listen_fd_, reinterpret_cast<sockaddr*>(&bind_addr), sizeof(bind_addr)) < 0) {
+                std::cerr << "❌ Cannot bind " << options_.listen_ip << ":" << options_.listen_port
+                          << ": " << strerror(errno) << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        int run() {
+            const uint64_t start = now_ns();
+            const uint64_t end = options_.seconds > 0
+                ? start + static_cast<uint64_t>(options_.seconds * 1e9) : UINT64_MAX;
+            uint64_t next_status = start + 1'000'000'000;
+            LinkStats last_up, last_down;
+
+            std::vector<pollfd> fds;
+            std::vector<std::shared_ptr<Session>> polled;
+
+            while (running && now_ns() < end) {
+                uint64_t now = now_ns();
+                deliver_due(now);
+
+                // Ждем до ближайшей доставки или нового пакета
+                uint64_t wait = IDLE_WAIT_NS;
+                if (!pending_.empty()) {
+                    wait = pending_.top().due_ns > now ? std::min(wait, pending_.top().due_ns - now) : 0;
+                }
+
+                fds.clear();
+                polled.clear();
+                fds.push_back({listen_fd_, POLLIN, 0});
+                for (const auto& [key, session] : sessions_) {
+                    fds.push_back({session->fd, POLLIN, 0});
+                    polled.push_back(session);
+                }
+
+                timespec timeout{static_cast<time_t>(wait / 1'000'000'000),
+                                 static_cast<long>(wait % 1'000'000'000)};
+                if (ppoll(fds.data(), fds.size(), &timeout, nullptr) > 0) {
+                    now = now_ns();
+                    if (fds[0].revents & POLLIN) {
+                        receive_from_clients(now);
+                    }
+                    for (size_t i = 1; i < fds.size(); ++i) {
+                        if (fds[i].revents & POLLIN) {
+                            receive_from_server(polled[i - 1], now);
+                        }
+                    }
+                }
+
+                if (now >= next_status) {
+                    expire_sessions(now);
+                    if (!options_.quiet) {
+                        LinkStats up, down;
+                        totals(up, down);
+                        print_status(static_cast<int>((now - start) / 1'000'000'000), up, last_up, down, last_down);
+                        last_up = up;
+                        last_down = down;
+                    }
+                    next_status += 1'000'000'000;
+                }
+            }
+
+            // Что еще в пути — доставляем, как если бы сеть отработала
+            while (!pending_.empty()) {
+                deliver_due(UINT64_MAX);
+            }
+
+            print_summary();
+            return 0;
+        }
+
+    private:
+        static bool make_address(const std::string& ip, int port, sockaddr_in& out) {
+            out = sockaddr_in{};
+            out.sin_family = AF_INET;
+            out.sin_port = htons(static_cast<uint16_t>(port));
+            return port > 0 && port <= 65535 && inet_pton(AF_INET, ip.c_str(), &out.sin_addr) == 1;
+        }
+
+        static uint64_t client_key(const sockaddr_in& addr) {
+            return (uint64_t(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+        }
+
+        static int open_socket() {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            if (fd < 0) return -1;
+
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+            int bytes = SOCKET_BUFFER_BYTES;
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+            setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+            return fd;
+        }
+
+        std::shared_ptr<Session> session_for(const sockaddr_in& from, uint64_t now) {
+            auto it = sessions_.find(client_key(from));
+            if (it != sessions_.end()) return it->second;
+
+            auto session = std::make_shared<Session>(options_, pass_, next_session_++);
+            session->client = from;
+            session->fd = open_socket();
+            if (session->fd == -1 ||
+                connect(session->fd, reinterpret_cast<sockaddr*>(&server_), sizeof(server_)) < 0) {
+                std::cerr << "\n❌ Cannot open upstream socket: " << strerror(errno) << std::endl;
+                return nullptr;
+            }
+
+            char ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+            std::cout << "\n📱 New client " << ip << ":" << ntohs(from.sin_port) << std::endl;
+
+            session->last_seen_ns = now;
+            sessions_.emplace(client_key(from), session);
+            return session;
+        }
+
+        void receive_from_clients(uint64_t now) {
+            unsigned char buffer[MAX_DATAGRAM];
+            sockaddr_in from{};
+            socklen_t from_len = sizeof(from);
+
+            ssize_t received;
+            while ((received = recvfrom(listen_fd_, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                        reinterpret_cast<sockaddr*>(&from), &from_len)) > 0) {
+                from_len = sizeof(from);
+                std::shared_ptr<Session> session = session_for(from, now);
+                if (!session) continue;
+
+                session->last_seen_ns = now;
+                enqueue(session, true, buffer, static_cast<size_t>(received), now);
+            }
+        }
+
+        void receive_from_server(const std::shared_ptr<Session>& session, uint64_t now) {
+            unsigned char buffer[MAX_DATAGRAM];
+            ssize_t received;
+            while ((received = recv(session->fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+                enqueue(session, false, buffer, static_cast<size_t>(received), now);
+            }
+        }
+
+        void enqueue(const std::shared_ptr<Session>& session, bool upstream,
+                     const unsigned char* data, size_t size, uint64_t now) {
+            Link& link = upstream ? session->up : session->down;
+            uint64_t due[Link::MAX_COPIES];
+            int copies = link.schedule(size, now, due);
+
+            for (int c = 0; c < copies; ++c) {
+                pending_.push(Pending{due[c], next_order_++, session, upstream,
+                                      std::vector<unsigned char>(data, data + size)});
+            }
+        }
+
+        void deliver_due(uint64_t now) {
+            while (!pending_.empty() && pending_.top().due_ns <= now) {
+                const Pending& packet = pending_.top();
+                if (packet.upstream) {
+                    send(packet.session->fd, packet.data.data(), packet.data.size(), 0);
+                } else {
+                    sendto(listen_fd_, packet.data.data(), packet.data.size(), 0,
+                           reinterpret_cast<const sockaddr*>(&packet.session->client),
+                           sizeof(packet.session->client));
+                }
+                pending_.pop();
+            }
+        }
+
+        // Тихие клиенты уходят; их пакеты в пути держат сессию до доставки
+        void expire_sessions(uint64_t now) {
+            uint64_t idle = static_cast<uint64_t>(options_.idle_seconds * 1e9);
+            for (auto it = sessions_.begin(); it != sessions_.end();) {
+                if (now - it->second->last_seen_ns > idle) {
+                    finished_.up.add(it->second->up.stats());
+                    finished_.down.add(it->second->down.stats());
+                    it = sessions_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        void totals(LinkStats& up, LinkStats& down) const {
+            up = finished_.up;
+            down = finished_.down;
+            for (const auto& [key, session] : sessions_) {
+                up.add(session->up.stats());
+                down.add(session->down.stats());
+            }
+        }
+
+        void print_status(int elapsed, const LinkStats& up, const LinkStats& last_up,
+                          const LinkStats& down, const LinkStats& last_down) const {
+            auto dropped = [](const LinkStats& s) { return s.lost + s.burst_lost + s.queue_dropped; };
+            std::cout << "\r⏱️  " << elapsed << "s | 📡 Clients: " << sessions_.size()
+                      << " | ⬆️  " << (up.packets - last_up.packets) << " pkt/s, "
+                      << (dropped(up) - dropped(last_up)) << " dropped"
+                      << " | ⬇️  " << (down.packets - last_down.packets) << " pkt/s, "
+                      << (dropped(down) - dropped(last_down)) << " dropped"
+                      << " | ⏳ Queued: " << pending_.size() << "     " << std::flush;
+        }
+
+        static void print_direction(const char* name, const LinkStats& s) {
+            auto percent = [&s](uint64_t n) { return s.packets > 0 ? 100.0 * n / s.packets : 0.0; };
+            char line[256];
+            snprintf(line, sizeof(line),
+                     "  %-10s %9llu in %9llu out | loss %5.2f%% burst %5.2f%% queue %5.2f%% | "
+                     "dup %5.2f%% reorder %5.2f%%\n",
+                     name, static_cast<unsigned long long>(s.packets), static_cast<unsigned long long>(s.delivered),
+                     percent(s.lost), percent(s.burst_lost), percent(s.queue_dropped),
+                     percent(s.duplicated), percent(s.reordered));
+            std::cout << line;
+        }
+
+        void print_summary() const {
+            LinkStats up, down;
+            totals(up, down);
+            std::cout << "\n\n📊 Netem summary (seed " << options_.seed << ")" << std::endl;
+            print_direction("upstream", up);
+            print_direction("downstream", down);
+        }
+
+        const Options& options_;
+        Impairment pass_;             // направление без искажений
+        sockaddr_in server_{};
+        int listen_fd_ = -1;
+
+        std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions_;
+        uint64_t next_session_ = 0;
+        struct {
+            LinkStats up;
+            LinkStats down;
+        } finished_;
+
+        std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending_;
+        uint64_t next_order_ = 0;
+    };
+
+    void print_usage() {
+        std::cout << "\n🌩️  NETWORK IMPAIRMENT PROXY\n" << std::endl;
+        std::cout << "Usage: ./voice_netem [options]" << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --listen=[IP:]PORT  Where clients connect (default 12345)" << std::endl;
+        std::cout << "  --server=IP:PORT    Relay to forward to (default 127.0.0.1:12346)" << std::endl;
+        std::cout << "  --loss=P            Random loss, P% (good state with --ge)" << std::endl;
+        std::cout << "  --ge=P,R[,B]        Gilbert-Elliott bursts: P% good->bad, R% bad->good," << std::endl;
+        std::cout << "                      B% loss while bad (default 100)" << std::endl;
+        std::cout << "  --delay=MS          One-way delay" << std::endl;
+        std::cout << "  --jitter=MS         Delay std deviation (reorders packets, like netem)" << std::endl;
+        std::cout << "  --reorder=P         P% of packets skip the delay and overtake delayed ones" << std::endl;
+        std::cout << "  --duplicate=P       P% of packets delivered twice" << std::endl;
+        std::cout << "  --rate=KBIT         Bandwidth cap per client and direction. The bottleneck" << std::endl;
+        std::cout << "                      comes first; delay, jitter and reordering apply after it" << std::endl;
+        std::cout << "  --queue-ms=MS       Bottleneck queue before tail drop (default 200)" << std::endl;
+        std::cout << "  --direction=D       both (default), up (client->relay) or down" << std::endl;
+        std::cout << "  --seed=N            Random seed (default 1): same seed, same decisions" << std::endl;
+        std::cout << "  --seconds=S         Stop after S seconds (default: until Ctrl+C)" << std::endl;
+        std::cout << "  --idle=S            Forget clients silent for S seconds (default 60)" << std::endl;
+        std::cout << "  --quiet             No per-second status line" << std::endl;
+        std::cout << "\nExample:" << std::endl;
+        std::cout << "  ./voice server --port=12346" << std::endl;
+        std::cout << "  ./voice_netem --loss=1 --ge=2,30 --delay=40 --jitter=8 --seed=7" << std::endl;
+        std::cout << "  ./voice client 127.0.0.1\n" << std::endl;
+    }
+
+    bool parse_value(const std::string& arg, const char* name, std::string& value) {
+        std::string prefix = std::string(name) + "=";
+        if (arg.rfind(prefix, 0) != 0) return false;
+
+        value = arg.substr(prefix.size());
+        return true;
+    }
+
+    // "IP:PORT" или "PORT" (IP остается прежним)
+    bool parse_endpoint(const std::string& value, std::string& ip, int& port) {
+        size_t colon = value.rfind(':');
+        if (colon != std::string::npos) {
+            ip = value.substr(0, colon);
+        }
+        port = std::atoi(value.c_str() + (colon == std::string::npos ? 0 : colon + 1));
+        return port > 0 && port <= 65535;
+    }
+
+    bool parse_percent(const std::string& value, double& out) {
+        char* end = nullptr;
+        double percent = std::strtod(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0' || percent < 0 || percent > 100) return false;
+        out = percent / 100.0;
+        return true;
+    }
+
+    bool parse_gilbert_elliott(const std::string& value, Impairment& impairment) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true) {
+            size_t comma = value.find(',', start);
+            parts.push_back(value.substr(start, comma - start));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        if (parts.size() < 2 || parts.size() > 3) return false;
+
+        impairment.gilbert_elliott = true;
+        return parse_percent(parts[0], impairment.ge_p) &&
+               parse_percent(parts[1], impairment.ge_r) &&
+               (parts.size() < 3 || parse_percent(parts[2], impairment.ge_bad_loss));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    Options options;
+    Impairment& impairment = options.impairment;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        std::string value;
+        bool ok = true;
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (parse_value(arg, "--listen", value)) {
+            ok = parse_endpoint(value, options.listen_ip, options.listen_port);
+        } else if (parse_value(arg, "--server", value)) {
+            ok = parse_endpoint(value, options.server_ip, options.server_port);
+        } else if (parse_value(arg, "--loss", value)) {
+            ok = parse_percent(value, impairment.loss);
+        } else if (parse_value(arg, "--ge", value)) {
+            ok = parse_gilbert_elliott(value, impairment);
+        } else if (parse_value(arg, "--delay", value)) {
+            impairment.delay_ms = std::atof(value.c_str());
+            ok = impairment.delay_ms >= 0;
+        } else if (parse_value(arg, "--jitter", value)) {
+            impairment.jitter_ms = std::atof(value.c_str());
+            ok = impairment.jitter_ms >= 0;
+        } else if (parse_value(arg, "--reorder", value)) {
+            ok = parse_percent(value, impairment.reorder);
+        } else if (parse_value(arg, "--duplicate", value)) {
+            ok = parse_percent(value, impairment.duplicate);
+        } else if (parse_value(arg, "--rate", value)) {
+            impairment.rate_kbit = std::atof(value.c_str());
+            ok = impairment.rate_kbit >= 0;
+        } else if (parse_value(arg, "--queue-ms", value)) {
+            impairment.queue_ms = std::atof(value.c_str());
+            ok = impairment.queue_ms >= 0;
+        } else if (parse_value(arg, "--direction", value)) {
+            options.upstream = value == "both" || value == "up";
+            options.downstream = value == "both" || value == "down";
+            ok = options.upstream || options.downstream;
+        } else if (parse_value(arg, "--seed", value)) {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (parse_value(arg, "--seconds", value)) {
+            options.seconds = std::atof(value.c_str());
+        } else if (parse_value(arg, "--idle", value)) {
+            options.idle_seconds = std::atof(value.c_str());
+            ok = options.idle_seconds > 0;
+        } else {
+            std::cerr << "❌ Error: Unknown option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+
+        if (!ok) {
+            std::cerr << "❌ Error: Bad value in '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    NetemProxy proxy(options);
+    if (!proxy.init()) {
+        return 1;
+    }
+
+    std::cout << "🌩️  Proxy " << options.listen_ip << ":" << options.listen_port << " -> "
+              << options.server_ip << ":" << options.server_port
+              << " (seed " << options.seed << ")" << std::endl;
+    if (!impairment.active()) {
+        std::cout << "⚠️  No impairment configured: forwarding as is" << std::endl;
+    }
+
+    return proxy.run();
+}
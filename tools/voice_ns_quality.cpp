@@ -0,0 +1,783 @@
+// Качество шумоподавления против цены: чистая речь смешивается с шумом
+// на заданных SNR, каждая конфигурация (тип подавления × настройки режима,
+// плюс VoiceProcessor в каждом режиме) обрабатывает смесь. Объективные
+// метрики относительно чистой речи — сегментный SNR, лог-спектральное
+// расстояние и подавление шума в паузах — рядом с процессорным временем
+// на кадр. Выход перед сравнением масштабируется так, чтобы речь в нем
+// совпала по уровню с чистой, уровень речи в выходе — отдельной колонкой: метрики качества не зависят
+// от усиления тракта. Итоговая таблица отмечает конфигурации, прошедшие
+// порог качества, и самую дешевую из них. Задержка выхода меряется отдельно
+// ниже и выше 8 кГц: при разделении полос они должны совпадать, иначе
+// конфигурация не проходит, а код возврата — 1.
+#include "../include/FFT.hpp"
+#include "../include/NoiseSuppressor.hpp"
+#include "../include/VoiceProcessor.hpp"
+#include "../include/WavFile.hpp"
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int SAMPLE_RATE = 48000;
+    constexpr int FRAME_SIZE = 960;            // 20 мс, как в voice_bench
+    // Начало не оцениваем: оценка шума еще сходится
+    constexpr double WARMUP_SECONDS = 1.0;
+    // Кадр речи — не тише самого громкого кадра на столько
+    constexpr double ACTIVE_RANGE_DB = 30.0;
+    // Границы сегментного SNR на кадр (ITU-T P.Sup23 / Quackenbush)
+    constexpr double SEG_SNR_MIN_DB = -10.0;
+    constexpr double SEG_SNR_MAX_DB = 35.0;
+    constexpr int LSD_FFT = 1024;
+    // LSD — только в речевой полосе: выше речи нет, любой остаток шума
+    // давал бы там десятки дБ
+    constexpr double LSD_MAX_HZ = 8000.0;
+    // Пол спектра — ниже пика кадра чистой речи на столько
+    constexpr double LSD_FLOOR_DB = 60.0;
+    // Поиск задержки обработки: по окну и в пределах
+    constexpr int ALIGN_WINDOW = SAMPLE_RATE / 2;
+    constexpr int ALIGN_MAX_LAG = 2048;
+    // Задержка по полосам: взаимная корреляция входа и выхода в полосе.
+    // Переходную полосу BandSplitter (срез 7 кГц, граница 8 кГц) пропускаем
+    constexpr double LOW_LAG_MAX_HZ = 6000.0;
+    constexpr double HIGH_LAG_MIN_HZ = 10000.0;
+    constexpr int BAND_LAG_WINDOW = 32768;
+    constexpr int MAX_BAND_LAG_MISMATCH = 1;
+
+    struct Options {
+        double seconds = 10.0;
+        std::vector<double> snrs = {0.0, 5.0, 10.0, 20.0};
+        std::vector<std::string> noises = {"white", "pink", "babble"};
+        std::string speech_path;
+        std::string filter;
+        uint32_t seed = 1;
+        double min_gain_db = 3.0;     // порог: средний прирост сегментного SNR
+        double max_lsd_db = 12.0;     // порог: среднее лог-спектральное расстояние
+        bool json = false;
+    };
+
+    // Обработка одного прогона: кадр FRAME_SIZE на входе и выходе
+    using FrameFn = std::function<void(const float*, float*)>;
+
+    struct Config {
+        std::string name;
+        // noise — кадр чистого шума для calibrateNoise
+        std::function<FrameFn(const float* noise)> create;
+    };
+
+    struct Metrics {
+        double seg_snr_db = 0.0;
+        double lsd_db = 0.0;
+        double noise_reduction_db = 0.0;   // энергия шума в паузах: вход / выход
+        double level_db = 0.0;             // уровень выхода относительно чистой речи
+    };
+
+    struct Result {
+        std::string config;
+        std::string noise;
+        double snr_db;
+        Metrics input;                     // необработанная смесь
+        Metrics output;
+        double us_per_frame;
+        int lag;
+        int lag_low;                       // задержка ниже и выше 8 кГц
+        int lag_high;
+    };
+
+    struct BandLag {
+        int low = 0;
+        int high = 0;
+        bool matches() const { return std::abs(low - high) <= MAX_BAND_LAG_MISMATCH; }
+    };
+
+    const char* mode_name(FrameProcessor::ProcessingMode mode) {
+        switch (mode) {
+            case FrameProcessor::MODE_AGGRESSIVE: return "aggressive";
+            case FrameProcessor::MODE_CONSERVATIVE: return "conservative";
+            case FrameProcessor::MODE_AUTO: return "auto";
+            case FrameProcessor::MODE_STANDARD:
+            default: return "standard";
+        }
+    }
+
+    const char* suppression_name(NoiseSuppressor::SuppressionType type) {
+        switch (type) {
+            case NoiseSuppressor::SUBTRACTION: return "subtraction";
+            case NoiseSuppressor::WIENER: return "wiener";
+            case NoiseSuppressor::SPECTRAL_GATING: return "gating";
+            case NoiseSuppressor::MMSE:
+            default: return "mmse";
+        }
+    }
+
+    double thread_cpu_seconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    // Речь-подобный сигнал: гармоники основного тона с плавающей высотой,
+    // окрашенные формантами гласной, слоги ~4 Гц и паузы между фразами
+    std::vector<float> synth_speech(size_t samples, uint32_t seed, float level) {
+        struct Vowel { float f1, f2, f3; };
+        static const Vowel vowels[] = {
+            {730, 1090, 2440}, {270, 2290, 3010}, {300, 870, 2240}, {530, 1840, 2480}, {570, 840, 2410}
+        };
+
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::vector<float> out(samples, 0.0f);
+
+        const float two_pi = 2.0f * static_cast<float>(M_PI);
+        const float base_f0 = 100.0f + 120.0f * uniform(rng);
+        float phase = 0.0f;
+        size_t position = 0;
+
+        while (position < samples) {
+            // Фраза из 3-7 слогов, затем пауза 0.2-0.6 с
+            int syllables = 3 + static_cast<int>(uniform(rng) * 5);
+            for (int s = 0; s < syllables && position < samples; ++s) {
+                const Vowel& vowel = vowels[static_cast<size_t>(uniform(rng) * 5) % 5];
+                size_t length = static_cast<size_t>((0.15f + 0.15f * uniform(rng)) * SAMPLE_RATE);
+                float f0_start = base_f0 * (0.85f + 0.3f * uniform(rng));
+                float f0_end = base_f0 * (0.85f + 0.3f * uniform(rng));
+
+                for (size_t i = 0; i < length && position < samples; ++i, ++position) {
+                    float t = static_cast<float>(i) / length;
+                    float f0 = f0_start + (f0_end - f0_start) * t;
+                    phase += two_pi * f0 / SAMPLE_RATE;
+                    if (phase > two_pi) phase -= two_pi;
+
+                    float value = 0.0f;
+                    for (int h = 1; h * f0 < 4000.0f; ++h) {
+                        float f = h * f0;
+                        // Три резонанса гласной поверх спада -6 дБ/октаву
+                        float shape = std::exp(-std::pow((f - vowel.f1) / 120.0f, 2.0f)) +
+                                      0.6f * std::exp(-std::pow((f - vowel.f2) / 160.0f, 2.0f)) +
+                                      0.3f * std::exp(-std::pow((f - vowel.f3) / 200.0f, 2.0f)) + 0.05f;
+                        value += shape / h * std::sin(h * phase);
+                    }
+                    float envelope = std::sin(static_cast<float>(M_PI) * t);
+                    out[position] = level * envelope * envelope * value;
+                }
+            }
+            position += static_cast<size_t>((0.2f + 0.4f * uniform(rng)) * SAMPLE_RATE);
+        }
+        return out;
+    }
+
+    std::vector<float> make_noise(const std::string& kind, size_t samples, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        std::vector<float> out(samples);
+
+        if (kind == "white") {
+            for (auto& x : out) x = normal(rng);
+        } else if (kind == "pink") {
+            // Фильтр Пола Келлета: -3 дБ/октаву
+            float b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+            for (auto& x : out) {
+                float w = normal(rng);
+                b0 = 0.99886f * b0 + w * 0.0555179f;
+                b1 = 0.99332f * b1 + w * 0.0750759f;
+                b2 = 0.96900f * b2 + w * 0.1538520f;
+                b3 = 0.86650f * b3 + w * 0.3104856f;
+                b4 = 0.55000f * b4 + w * 0.5329522f;
+                b5 = -0.7616f * b5 - w * 0.0168980f;
+                x = b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362f;
+                b6 = w * 0.115926f;
+            }
+        } else if (kind == "babble") {
+            // Шесть синтетических говорящих одновременно
+            std::fill(out.begin(), out.end(), 0.0f);
+            for (uint32_t talker = 0; talker < 6; ++talker) {
+                std::vector<float> voice = synth_speech(samples, seed * 31 + talker + 1, 1.0f);
+                for (size_t i = 0; i < samples; ++i) out[i] += voice[i];
+            }
+        } else {
+            MappedWav wav;
+            if (!wav.open(kind) || wav.getSampleRate() != SAMPLE_RATE || wav.getFrameCount() == 0) {
+                return {};
+            }
+            // Короткая запись — по кругу
+            for (size_t done = 0; done < samples;) {
+                done += wav.readMono(0, std::min(samples - done, wav.getFrameCount()), out.data() + done);
+            }
+        }
+        return out;
+    }
+
+    double energy(const float* x, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) sum += static_cast<double>(x[i]) * x[i];
+        return sum;
+    }
+
+    // Задержка обработки: максимум взаимной корреляции с чистой речью.
+    // Корреляция первых разностей: иначе пик тянут низкие частоты, а DC
+    // фильтр тракта сдвигает их фазу и сбивает оценку на пару сэмплов
+    int estimate_lag(const std::vector<float>& clean, const std::vector<float>& processed) {
+        size_t start = static_cast<size_t>(WARMUP_SECONDS * SAMPLE_RATE);
+        if (clean.size() < start + ALIGN_WINDOW + ALIGN_MAX_LAG) return 0;
+
+        // Окно с самой громкой речью — корреляция надежнее
+        size_t best_start = start;
+        double best_energy = -1.0;
+        for (size_t s = start; s + ALIGN_WINDOW + ALIGN_MAX_LAG <= clean.size(); s += ALIGN_WINDOW) {
+            double e = energy(clean.data() + s, ALIGN_WINDOW);
+            if (e > best_energy) {
+                best_energy = e;
+                best_start = s;
+            }
+        }
+
+        int best_lag = 0;
+        double best = -1e300;
+        for (int lag = 0; lag <= ALIGN_MAX_LAG; ++lag) {
+            double sum = 0.0;
+            for (int i = 0; i < ALIGN_WINDOW; ++i) {
+                size_t n = best_start + i;
+                sum += static_cast<double>(clean[n] - clean[n - 1]) *
+                       (processed[n + lag] - processed[n + lag - 1]);
+            }
+            if (sum > best) {
+                best = sum;
+                best_lag = lag;
+            }
+        }
+        return best_lag;
+    }
+
+    // Задержка y относительно x в полосе [lo_hz, hi_hz): максимум взаимной
+    // корреляции через FFT, x берется окном BAND_LAG_WINDOW после прогрева
+    int band_lag(const std::vector<float>& x, const std::vector<float>& y, double lo_hz, double hi_hz) {
+        const size_t start = static_cast<size_t>(WARMUP_SECONDS * SAMPLE_RATE);
+        if (x.size() < start + BAND_LAG_WINDOW + ALIGN_MAX_LAG) return 0;
+
+        // Без заворота: y длиннее окна x на ALIGN_MAX_LAG, и все влезает в n
+        const int n = dsp::nextPowerOfTwo(BAND_LAG_WINDOW + ALIGN_MAX_LAG);
+        std::vector<std::complex<float>> fx(n), fy(n);
+        for (int i = 0; i < BAND_LAG_WINDOW; ++i) fx[i] = x[start + i];
+        for (int i = 0; i < BAND_LAG_WINDOW + ALIGN_MAX_LAG; ++i) fy[i] = y[start + i];
+        dsp::iterativeFFT(fx);
+        dsp::iterativeFFT(fy);
+
+        const int lo = std::max(1, static_cast<int>(lo_hz * n / SAMPLE_RATE));
+        const int hi = std::min(n / 2, static_cast<int>(hi_hz * n / SAMPLE_RATE));
+        std::vector<std::complex<float>> cross(n, 0.0f);
+        for (int k = lo; k < hi; ++k) {
+            cross[k] = std::conj(fx[k]) * fy[k];
+            cross[n - k] = std::conj(cross[k]);
+        }
+        dsp::iterativeFFT(cross, true);
+
+        int best_lag = 0;
+        for (int lag = 1; lag <= ALIGN_MAX_LAG; ++lag) {
+            if (cross[lag].real() > cross[best_lag].real()) best_lag = lag;
+        }
+        return best_lag;
+    }
+
+    // По входу обработки, а не по чистой речи: в синтетической речи почти
+    // нет энергии выше 8 кГц, а в шуме она есть
+    BandLag estimate_band_lag(const std::vector<float>& noisy, const std::vector<float>& processed) {
+        return {band_lag(noisy, processed, 0.0, LOW_LAG_MAX_HZ),
+                band_lag(noisy, processed, HIGH_LAG_MIN_HZ, SAMPLE_RATE / 2.0)};
+    }
+
+    class QualityRunner {
+    public:
+        explicit QualityRunner(const Options& options) : options_(options) {}
+
+        int run() {
+            // Таблицы — в stdout; сообщения модулей при создании — в никуда
+            std::ostream out(std::cout.rdbuf());
+            std::cout.rdbuf(nullptr);
+            int status = run_all(out);
+            std::cout.rdbuf(out.rdbuf());
+            return status;
+        }
+
+    private:
+        int run_all(std::ostream& out) {
+            size_t samples = static_cast<size_t>(options_.seconds * SAMPLE_RATE) / FRAME_SIZE * FRAME_SIZE;
+
+            std::vector<float> clean;
+            if (options_.speech_path.empty()) {
+                clean = synth_speech(samples, options_.seed, 0.1f);
+            } else {
+                MappedWav wav;
+                if (!wav.open(options_.speech_path) || wav.getSampleRate() != SAMPLE_RATE) {
+                    std::cerr << "❌ Speech must be a " << SAMPLE_RATE << " Hz WAV: "
+                              << options_.speech_path << std::endl;
+                    return 1;
+                }
+                samples = std::min(samples, wav.getFrameCount() / FRAME_SIZE * FRAME_SIZE);
+                clean.resize(samples);
+                wav.readMono(0, samples, clean.data());
+            }
+            if (samples < static_cast<size_t>((WARMUP_SECONDS + 1.0) * SAMPLE_RATE)) {
+                std::cerr << "❌ Need at least " << WARMUP_SECONDS + 1.0 << " s of speech" << std::endl;
+                return 1;
+            }
+
+            std::vector<Config> configs = make_configs();
+            if (configs.empty()) {
+                std::cerr << "❌ No configuration matches '" << options_.filter << "'" << std::endl;
+                return 1;
+            }
+
+            // Задержка — свойство конфигурации: считаем один раз
+            std::map<std::string, int> lags;
+            std::map<std::string, BandLag> band_lags;
+
+            for (const std::string& kind : options_.noises) {
+                std::vector<float> noise = make_noise(kind, samples, options_.seed + 1000);
+                if (noise.empty()) {
+                    std::cerr << "❌ Unknown noise or unreadable " << SAMPLE_RATE << " Hz WAV: " << kind << std::endl;
+                    return 1;
+                }
+
+                for (double snr : options_.snrs) {
+                    std::vector<float> scaled = scale_noise(clean, noise, snr);
+                    std::vector<float> noisy(samples);
+                    for (size_t i = 0; i < samples; ++i) noisy[i] = clean[i] + scaled[i];
+                    Metrics input = measure(clean, noisy, noisy, 0, false);
+
+                    if (!options_.json) {
+                        out << "\n" << kind << " noise, SNR " << snr << " dB" << std::endl;
+                        print_header(out);
+                        print_row(out, "(unprocessed)", input, input, 0.0);
+                    }
+
+                    for (const Config& config : configs) {
+                        std::vector<float> processed(samples);
+                        double us = process(config, scaled.data(), noisy, processed);
+
+                        auto lag = lags.find(config.name);
+                        if (lag == lags.end()) {
+                            lag = lags.emplace(config.name, estimate_lag(clean, processed)).first;
+                        }
+                        auto band_lag = band_lags.find(config.name);
+                        if (band_lag == band_lags.end()) {
+                            band_lag = band_lags.emplace(config.name, estimate_band_lag(noisy, processed)).first;
+                        }
+
+                        Result result{config.name, kind, snr, input,
+                                      measure(clean, noisy, processed, lag->second, true), us, lag->second,
+                                      band_lag->second.low, band_lag->second.high};
+                        if (!options_.json) print_row(out, config.name, input, result.output, us);
+                        results_.push_back(result);
+                    }
+                }
+            }
+
+            if (options_.json) {
+                print_json(out);
+            } else {
+                print_summary(out);
+            }
+
+            // Полосы с разной задержкой — ошибка тракта, а не вопрос настройки
+            int status = 0;
+            for (const auto& [name, band_lag] : band_lags) {
+                if (band_lag.matches()) continue;
+                std::cerr << "❌ " << name << ": output lag " << band_lag.low << " samples below 8 kHz, "
+                          << band_lag.high << " above" << std::endl;
+                status = 1;
+            }
+            return status;
+        }
+
+        bool selected(const std::string& name) const {
+            return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+        }
+
+        std::vector<Config> make_configs() const {
+            const FrameProcessor::ProcessingMode modes[] = {
+                FrameProcessor::MODE_AGGRESSIVE, FrameProcessor::MODE_STANDARD,
+                FrameProcessor::MODE_CONSERVATIVE, FrameProcessor::MODE_AUTO
+            };
+            std::vector<Config> configs;
+
+            // Подавитель отдельно: каждый тип с настройками каждого режима
+            for (auto type : {NoiseSuppressor::SUBTRACTION, NoiseSuppressor::WIENER,
+                              NoiseSuppressor::MMSE, NoiseSuppressor::SPECTRAL_GATING}) {
+                for (auto mode : modes) {
+                    std::string name = std::string("ns/") + suppression_name(type) + "/" + mode_name(mode);
+                    if (!selected(name)) continue;
+
+                    configs.push_back({name, [type, mode](const float* noise) -> FrameFn {
+                        auto suppressor = std::make_shared<NoiseSuppressor>(SAMPLE_RATE, FRAME_SIZE);
+                        FrameProcessor::ModeSettings settings = FrameProcessor::settingsFor(mode);
+                        suppressor->setSuppressionType(type);
+                        suppressor->setReduction(settings.reductionDb);
+                        suppressor->setSmoothing(settings.timeSmoothing, settings.freqSmoothing);
+                        suppressor->calibrateNoise(std::vector<float>(noise, noise + FRAME_SIZE));
+
+                        auto input = std::make_shared<std::vector<float>>(FRAME_SIZE);
+                        return [suppressor, input](const float* in, float* out) {
+                            std::copy(in, in + FRAME_SIZE, input->begin());
+                            std::vector<float> result = suppressor->process(*input);
+                            std::copy(result.begin(), result.end(), out);
+                        };
+                    }});
+                }
+            }
+
+            // Весь тракт режима, без АРУ и лимитера: уровень не должен
+            // влиять на метрики относительно чистой речи. /split — с
+            // подавлением только в полосе речи
+            for (auto mode : modes) {
+                for (bool split : {false, true}) {
+                    std::string name = std::string("vp/") + mode_name(mode) + (split ? "/split" : "");
+                    if (!selected(name)) continue;
+
+                    configs.push_back({name, [mode, split](const float* noise) -> FrameFn {
+                        auto processor = std::make_shared<VoiceProcessor>(SAMPLE_RATE, FRAME_SIZE);
+                        processor->enableBandSplit(split);
+                        processor->setMode(mode);
+                        processor->enableAutoGain(false);
+                        processor->enableLimiter(false);
+                        processor->calibrateNoise(noise);
+                        return [processor](const float* in, float* out) { processor->process(in, out); };
+                    }});
+                }
+            }
+            return configs;
+        }
+
+        // Шум масштабируется под SNR по энергии всей речи
+        static std::vector<float> scale_noise(const std::vector<float>& clean, const std::vector<float>& noise,
+                                              double snr_db) {
+            double speech_energy = energy(clean.data(), clean.size());
+            double noise_energy = energy(noise.data(), noise.size());
+            double gain = std::sqrt(speech_energy / (noise_energy * std::pow(10.0, snr_db / 10.0)));
+
+            std::vector<float> out(noise.size());
+            for (size_t i = 0; i < noise.size(); ++i) {
+                out[i] = static_cast<float>(gain) * noise[i];
+            }
+            return out;
+        }
+
+        // Процессорное время потока на кадр, мкс; калибровка не в счет
+        static double process(const Config& config, const float* noise, const std::vector<float>& input,
+                              std::vector<float>& output) {
+            FrameFn frame = config.create(noise);
+
+            double start = thread_cpu_seconds();
+            for (size_t offset = 0; offset + FRAME_SIZE <= input.size(); offset += FRAME_SIZE) {
+                frame(input.data() + offset, output.data() + offset);
+            }
+            double elapsed = thread_cpu_seconds() - start;
+            return elapsed * 1e6 / (input.size() / FRAME_SIZE);
+        }
+
+        // Метрики y относительно чистой речи; y сдвинут на lag сэмплов.
+        // noisy — вход обработки, по нему — подавление шума в паузах.
+        // match_level — масштабировать y к чистой речи перед сравнением
+        Metrics measure(const std::vector<float>& clean, const std::vector<float>& noisy,
+                        const std::vector<float>& y, int lag, bool match_level) {
+            size_t first = static_cast<size_t>(WARMUP_SECONDS * SAMPLE_RATE) / FRAME_SIZE;
+            size_t frames = (clean.size() - static_cast<size_t>(lag)) / FRAME_SIZE;
+
+            double loudest = 0.0;
+            for (size_t f = first; f < frames; ++f) {
+                loudest = std::max(loudest, energy(clean.data() + f * FRAME_SIZE, FRAME_SIZE));
+            }
+            double active_threshold = loudest * std::pow(10.0, -ACTIVE_RANGE_DB / 10.0);
+
+            // Уровень речи в выходе — проекция на чистую речь (шум с ней не
+            // коррелирует); масштаб сравнения выравнивает эту проекцию с чистой
+            // речью. МНК-усиление сюда не годится: оно приглушает и шум, и
+            // любой тракт с единичным усилением выигрывал бы у входа
+            double cross = 0.0, clean_power = 0.0, output_power = 0.0;
+            for (size_t f = first; f < frames; ++f) {
+                const float* s = clean.data() + f * FRAME_SIZE;
+                const float* out = y.data() + f * FRAME_SIZE + lag;
+                for (int i = 0; i < FRAME_SIZE; ++i) {
+                    cross += static_cast<double>(s[i]) * out[i];
+                    clean_power += static_cast<double>(s[i]) * s[i];
+                    output_power += static_cast<double>(out[i]) * out[i];
+                }
+            }
+            const bool correlated = cross > 0.0 && clean_power > 0.0 && output_power > 0.0;
+            const double gain = match_level && correlated ? clean_power / cross : 1.0;
+            scaled_.resize(FRAME_SIZE);
+
+            Metrics m;
+            m.level_db = correlated ? 20.0 * std::log10(cross / clean_power) : 0.0;
+            double seg_sum = 0.0, lsd_sum = 0.0;
+            double pause_in = 0.0, pause_out = 0.0;
+            size_t active = 0;
+
+            for (size_t f = first; f < frames; ++f) {
+                const float* s = clean.data() + f * FRAME_SIZE;
+                const float* x = noisy.data() + f * FRAME_SIZE;
+                const float* out = scaled_.data();
+                for (int i = 0; i < FRAME_SIZE; ++i) {
+                    scaled_[i] = static_cast<float>(gain * y[f * FRAME_SIZE + lag + i]);
+                }
+                double clean_energy = energy(s, FRAME_SIZE);
+
+                if (clean_energy < active_threshold) {
+                    pause_in += energy(x, FRAME_SIZE);
+                    pause_out += energy(out, FRAME_SIZE);
+                    continue;
+                }
+
+                double error = 0.0;
+                for (int i = 0; i < FRAME_SIZE; ++i) {
+                    double d = static_cast<double>(s[i]) - out[i];
+                    error += d * d;
+                }
+                double seg = 10.0 * std::log10(clean_energy / (error + 1e-20));
+                seg_sum += std::clamp(seg, SEG_SNR_MIN_DB, SEG_SNR_MAX_DB);
+                lsd_sum += log_spectral_distance(s, out);
+                active++;
+            }
+
+            if (active > 0) {
+                m.seg_snr_db = seg_sum / active;
+                m.lsd_db = lsd_sum / active;
+            }
+            if (pause_out > 0.0) {
+                m.noise_reduction_db = 10.0 * std::log10(pause_in / pause_out);
+            }
+            return m;
+        }
+
+        // sqrt(среднее по частотам (10 lg Ps/Py)^2), окно Ханна, до LSD_MAX_HZ
+        double log_spectral_distance(const float* s, const float* y) {
+            if (hann_.empty()) {
+                hann_.resize(FRAME_SIZE);
+                for (int i = 0; i < FRAME_SIZE; ++i) {
+                    hann_[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / (FRAME_SIZE - 1));
+                }
+            }
+
+            std::fill(spectrum_s_.begin(), spectrum_s_.end(), std::complex<float>(0.0f));
+            std::fill(spectrum_y_.begin(), spectrum_y_.end(), std::complex<float>(0.0f));
+            for (int i = 0; i < FRAME_SIZE; ++i) {
+                spectrum_s_[i] = s[i] * hann_[i];
+                spectrum_y_[i] = y[i] * hann_[i];
+            }
+            fft_.forward(spectrum_s_.data());
+            fft_.forward(spectrum_y_.data());
+
+            const int bins = static_cast<int>(LSD_MAX_HZ * LSD_FFT / SAMPLE_RATE);
+            double peak = 0.0;
+            for (int k = 1; k <= bins; ++k) peak = std::max(peak, static_cast<double>(std::norm(spectrum_s_[k])));
+
+            // Пол — чтобы провалы спектра речи не давали бесконечности
+            const double floor = peak * std::pow(10.0, -LSD_FLOOR_DB / 10.0) + 1e-20;
+            double sum = 0.0;
+            for (int k = 1; k <= bins; ++k) {
+                double ps = std::max(static_cast<double>(std::norm(spectrum_s_[k])), floor);
+                double py = std::max(static_cast<double>(std::norm(spectrum_y_[k])), floor);
+                double d = 10.0 * std::log10(ps / py);
+                sum += d * d;
+            }
+            return std::sqrt(sum / bins);
+        }
+
+        static void print_header(std::ostream& out) {
+            out << "  " << std::left << std::setw(28) << "config" << std::right
+                << std::setw(9) << "segSNR" << std::setw(9) << "gain" << std::setw(9) << "LSD"
+                << std::setw(9) << "NR" << std::setw(9) << "level" << std::setw(12) << "us/frame" << std::endl;
+        }
+
+        static void print_row(std::ostream& out, const std::string& name, const Metrics& input,
+                              const Metrics& m, double us) {
+            out << "  " << std::left << std::setw(28) << name << std::right << std::fixed
+                << std::setprecision(2)
+                << std::setw(9) << m.seg_snr_db << std::setw(9) << m.seg_snr_db - input.seg_snr_db
+                << std::setw(9) << m.lsd_db << std::setw(9) << m.noise_reduction_db
+                << std::setw(9) << m.level_db << std::setprecision(1) << std::setw(12) << us
+                << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+
+        // Среднее по всем условиям; по возрастанию цены
+        void print_summary(std::ostream& out) const {
+            struct Summary {
+                std::string name;
+                double gain = 0.0, lsd = 0.0, nr = 0.0, us = 0.0;
+                int runs = 0;
+                BandLag lag;
+            };
+            std::vector<Summary> summaries;
+            for (const Result& r : results_) {
+                auto it = std::find_if(summaries.begin(), summaries.end(),
+                                       [&r](const Summary& s) { return s.name == r.config; });
+                if (it == summaries.end()) {
+                    summaries.push_back({r.config});
+                    it = summaries.end() - 1;
+                    it->lag = {r.lag_low, r.lag_high};
+                }
+                it->gain += r.output.seg_snr_db - r.input.seg_snr_db;
+                it->lsd += r.output.lsd_db;
+                it->nr += r.output.noise_reduction_db;
+                it->us += r.us_per_frame;
+                it->runs++;
+            }
+            for (Summary& s : summaries) {
+                s.gain /= s.runs;
+                s.lsd /= s.runs;
+                s.nr /= s.runs;
+                s.us /= s.runs;
+            }
+            std::sort(summaries.begin(), summaries.end(),
+                      [](const Summary& a, const Summary& b) { return a.us < b.us; });
+
+            out << "\nSummary: mean over " << options_.noises.size() * options_.snrs.size()
+                << " conditions, cheapest first (bar: gain >= " << options_.min_gain_db
+                << " dB, LSD <= " << options_.max_lsd_db << " dB)" << std::endl;
+            out << "  " << std::left << std::setw(28) << "config" << std::right
+                << std::setw(9) << "gain" << std::setw(9) << "LSD" << std::setw(9) << "NR"
+                << std::setw(12) << "us/frame" << std::setw(10) << "realtime" << std::setw(12) << "lag <8k/>8k"
+                << "  bar" << std::endl;
+
+            const Summary* cheapest = nullptr;
+            double frame_us = 1e6 * FRAME_SIZE / SAMPLE_RATE;
+            for (const Summary& s : summaries) {
+                bool pass = s.gain >= options_.min_gain_db && s.lsd <= options_.max_lsd_db && s.lag.matches();
+                if (pass && !cheapest) cheapest = &s;
+
+                out << "  " << std::left << std::setw(28) << s.name << std::right << std::fixed
+                    << std::setprecision(2) << std::setw(9) << s.gain << std::setw(9) << s.lsd
+                    << std::setw(9) << s.nr << std::setprecision(1) << std::setw(12) << s.us
+                    << std::setprecision(0) << std::setw(9) << frame_us / std::max(s.us, 1e-3) << "x"
+                    << std::setw(12) << (std::to_string(s.lag.low) + "/" + std::to_string(s.lag.high))
+                    << std::defaultfloat << std::setprecision(6) << (pass ? "  ✅" : "  ❌") << std::endl;
+            }
+
+            if (cheapest) {
+                out << "\n💡 Cheapest configuration meeting the bar: " << cheapest->name << std::endl;
+            } else {
+                out << "\n⚠️  No configuration meets the bar" << std::endl;
+            }
+        }
+
+        void print_json(std::ostream& out) const {
+            out << "{\"sample_rate\": " << SAMPLE_RATE << ", \"frame_size\": " << FRAME_SIZE
+                << ", \"seconds\": " << options_.seconds << ", \"seed\": " << options_.seed
+                << ", \"results\": [";
+            for (size_t i = 0; i < results_.size(); ++i) {
+                const Result& r = results_[i];
+                out << (i > 0 ? "," : "") << "\n  {\"config\": \"" << r.config << "\""
+                    << ", \"noise\": \"" << r.noise << "\", \"snr_db\": " << r.snr_db
+                    << std::fixed << std::setprecision(3)
+                    << ", \"input_seg_snr_db\": " << r.input.seg_snr_db
+                    << ", \"seg_snr_db\": " << r.output.seg_snr_db
+                    << ", \"input_lsd_db\": " << r.input.lsd_db
+                    << ", \"lsd_db\": " << r.output.lsd_db
+                    << ", \"noise_reduction_db\": " << r.output.noise_reduction_db
+                    << ", \"level_db\": " << r.output.level_db
+                    << ", \"us_per_frame\": " << r.us_per_frame
+                    << std::defaultfloat << std::setprecision(6) << ", \"lag\": " << r.lag
+                    << ", \"lag_low\": " << r.lag_low << ", \"lag_high\": " << r.lag_high << "}";
+            }
+            out << "\n]}" << std::endl;
+        }
+
+        Options options_;
+        std::vector<Result> results_;
+        std::vector<float> scaled_;
+
+        dsp::FixedFFT<LSD_FFT> fft_;
+        std::vector<float> hann_;
+        std::vector<std::complex<float>> spectrum_s_ = std::vector<std::complex<float>>(LSD_FFT);
+        std::vector<std::complex<float>> spectrum_y_ = std::vector<std::complex<float>>(LSD_FFT);
+    };
+
+    void print_usage() {
+        std::cout << "\n🎚️  NOISE SUPPRESSOR QUALITY vs CPU\n" << std::endl;
+        std::cout << "Usage: ./voice_ns_quality [options]" << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --speech=FILE     Clean speech, 48 kHz WAV (default: synthetic speech)" << std::endl;
+        std::cout << "  --noise=A,B       white, pink, babble or 48 kHz WAV files (default all three)" << std::endl;
+        std::cout << "  --snr=A,B         Input SNRs in dB (default 0,5,10,20)" << std::endl;
+        std::cout << "  --seconds=S       Signal length per condition (default 10)" << std::endl;
+        std::cout << "  --filter=TEXT     Only configurations containing TEXT (ns/, vp/, mmse, ...)" << std::endl;
+        std::cout << "  --seed=N          Synthetic speech and noise seed (default 1)" << std::endl;
+        std::cout << "  --min-gain=DB     Quality bar: mean segmental SNR gain (default 3)" << std::endl;
+        std::cout << "  --max-lsd=DB      Quality bar: mean log-spectral distance (default 12)" << std::endl;
+        std::cout << "  --json            Machine-readable per-condition results" << std::endl;
+        std::cout << "\nColumns: segSNR and its gain over the noisy input, log-spectral distance" << std::endl;
+        std::cout << "to clean speech (lower is better), noise reduction in pauses, output level" << std::endl;
+        std::cout << "relative to clean speech, CPU per frame (" << FRAME_SIZE << " samples at "
+                  << SAMPLE_RATE << " Hz)." << std::endl;
+        std::cout << "Processed output is scaled so its speech component matches clean speech" << std::endl;
+        std::cout << "before the quality metrics, so they do not depend on the chain's gain." << std::endl;
+        std::cout << "The output lag is measured below and above 8 kHz; a configuration whose" << std::endl;
+        std::cout << "bands come out with different lags fails, and the exit status is 1.\n" << std::endl;
+    }
+
+    std::vector<std::string> split_list(const std::string& value) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) comma = value.size();
+            if (comma > start) parts.push_back(value.substr(start, comma - start));
+            start = comma + 1;
+        }
+        return parts;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg.rfind("--speech=", 0) == 0) {
+            options.speech_path = arg.substr(9);
+        } else if (arg.rfind("--noise=", 0) == 0) {
+            options.noises = split_list(arg.substr(8));
+        } else if (arg.rfind("--snr=", 0) == 0) {
+            options.snrs.clear();
+            for (const std::string& snr : split_list(arg.substr(6))) {
+                options.snrs.push_back(std::atof(snr.c_str()));
+            }
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            options.seconds = std::atof(arg.c_str() + 10);
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = arg.substr(9);
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = static_cast<uint32_t>(std::strtoul(arg.c_str() + 7, nullptr, 10));
+        } else if (arg.rfind("--min-gain=", 0) == 0) {
+            options.min_gain_db = std::atof(arg.c_str() + 11);
+        } else if (arg.rfind("--max-lsd=", 0) == 0) {
+            options.max_lsd_db = std::atof(arg.c_str() + 10);
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            std::cerr << "❌ Error: Unknown option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (options.seconds <= 0.0 || options.noises.empty() || options.snrs.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    QualityRunner runner(options);
+    return runner.run();
+}
@@ -0,0 +1,605 @@
+// Пропускная способность ретранслятора на loopback. Relay запускается в
+// этом же процессе; в каждой комнате M говорящих и остальные — слушатели.
+// Для каждой точки (размер комнаты x число клиентов) меряем пересланные
+// пакеты в секунду, процессорное время сетевого потока ретранслятора на
+// пересланный пакет и задержку от отправки говорящим до приема слушателем
+// (p50/p99/p999) — видно, где рассылка перестает масштабироваться.
+// Задержка до слушателя идет через один поток приема бенчмарка, поэтому
+// рядом — собственная гистограмма ретранслятора RELAY_FORWARD (прочитана ->
+// разослана) за то же окно: где предел — в ретрансляторе или в замере.
+// --crypto=aead|both: те же точки с шифрованием AES-GCM (говорящие
+// шифруют, ретранслятор проверяет, слушатели расшифровывают) — цена
+// шифрования в пакетах в секунду и наносекундах на пакет.
+#include "../include/Relay.hpp"
+#include "../include/Protocol.hpp"
+#include "../include/PacketCrypto.hpp"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Гистограмма задержки: шаг 10 мкс, все дольше 200 мс — в последней ячейке
+    constexpr int LATENCY_BUCKET_US = 10;
+    constexpr int LATENCY_BUCKETS = 20000;
+    constexpr auto WARMUP = std::chrono::milliseconds(500);
+    // После окна замера ждем опоздавших, затем считаем
+    constexpr auto DRAIN = std::chrono::milliseconds(200);
+    constexpr auto JOIN_TIMEOUT = std::chrono::seconds(3);
+    constexpr int RECV_BATCH = 64;
+    constexpr int MAX_DATAGRAM = 1500;
+    constexpr size_t RECV_BUFFER = protocol::HEADER_SIZE + MAX_DATAGRAM + PacketCrypto::OVERHEAD;
+    constexpr int SOCKET_BUFFER_BYTES = 256 * 1024;
+    // Точка считается насыщенной при таких потерях
+    constexpr double SATURATION_LOSS_PERCENT = 1.0;
+
+    uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+    }
+
+    struct Options {
+        int port = 23500;
+        std::vector<int> room_sizes = {2, 5, 10, 25, 50};
+        std::vector<int> client_counts = {100, 250, 500, 1000};
+        int senders = 1;             // говорящих в комнате
+        int interval_ms = 20;        // пакет говорящего раз в столько
+        int payload_bytes = 60;      // ~24 кбит/с при 20 мс
+        double seconds = 3.0;        // окно замера одной точки
+        std::vector<bool> crypto = {false};   // каждая точка — без шифрования и/или с ним
+        bool json = false;
+    };
+
+    struct Point {
+        bool encrypted = false;
+        int room_size = 0;
+        int clients = 0;
+        int rooms = 0;
+        uint64_t sent = 0;
+        uint64_t expected = 0;
+        uint64_t delivered = 0;
+        double forwarded_per_second = 0.0;
+        double relay_cpu_percent = 0.0;
+        double cpu_ns_per_packet = 0.0;
+        double loss_percent = 0.0;
+        double p50_us = 0.0;
+        double p99_us = 0.0;
+        double p999_us = 0.0;
+        double max_us = 0.0;
+        // RELAY_FORWARD самого ретранслятора за окно замера
+        uint64_t relay_forwarded = 0;
+        double relay_p50_us = 0.0;
+        double relay_p99_us = 0.0;
+        double relay_p999_us = 0.0;
+        bool saturated = false;
+    };
+
+    // Полезная нагрузка: байт TOC (CELT, 20 мс) и время отправки
+    constexpr unsigned char PAYLOAD_TOC = 0xF8;
+
+    class RelayBench {
+    public:
+        explicit RelayBench(const Options& options) : options_(options) {}
+
+        int run(std::ostream& out) {
+            int max_clients = *std::max_element(options_.client_counts.begin(), options_.client_counts.end());
+            if (!raise_fd_limit(max_clients)) return 1;
+
+            if (!options_.json) print_header(out);
+
+            std::vector<Point> points;
+            for (int room_size : options_.room_sizes) {
+                for (int clients : options_.client_counts) {
+                    if (room_size > clients || room_size <= options_.senders) continue;
+
+                    for (bool encrypted : options_.crypto) {
+                        Point point;
+                        point.encrypted = encrypted;
+                        if (!measure(room_size, clients, point)) return 1;
+                        points.push_back(point);
+                        if (!options_.json) print_point(out, point);
+                    }
+                }
+            }
+
+            if (options_.json) print_json(out, points);
+            return 0;
+        }
+
+    private:
+        struct Client {
+            int fd = -1;
+            uint16_t room = 0;
+            bool sender = false;
+            uint32_t sequence = 0;
+        };
+
+        bool measure(int room_size, int client_count, Point& point) {
+            point.room_size = room_size;
+            point.rooms = client_count / room_size;
+            point.clients = point.rooms * room_size;
+
+            Relay relay;
+            if (point.encrypted && !set_keys(relay)) return false;
+            if (!relay.listen(options_.port)) {
+                std::cerr << "❌ Cannot listen on port " << options_.port << std::endl;
+                return false;
+            }
+            relay.start();
+
+            std::vector<Client> clients;
+            bool ok = open_clients(point, clients) && join(relay, clients, point.encrypted);
+
+            if (ok) {
+                run_traffic(relay, clients, point);
+            }
+
+            for (Client& client : clients) {
+                if (client.fd >= 0) close(client.fd);
+            }
+            relay.stop();
+            return ok;
+        }
+
+        // Новый случайный ключ на точку: ретранслятору, говорящим и слушателям
+        bool set_keys(Relay& relay) {
+            static const char DIGITS[] = "0123456789abcdef";
+            std::random_device random;
+            std::string key;
+            for (int i = 0; i < 64; ++i) key += DIGITS[random() % 16];
+
+            salt_ = PacketCrypto::random_salt();
+            return relay.set_key(key) && sender_crypto_.set_key_hex(key) && receiver_crypto_.set_key_hex(key);
+        }
+
+        // Шифрует пакет на месте, если точка с шифрованием; размер пакета
+        size_t seal(unsigned char* packet, size_t size, bool encrypted) {
+            if (!encrypted) return size;
+
+            unsigned char sealed[RECV_BUFFER];
+            size = sender_crypto_.seal(packet, size, salt_, sealed);
+            memcpy(packet, sealed, size);
+            return size;
+        }
+
+        bool open_clients(const Point& point, std::vector<Client>& clients) {
+            server_ = {};
+            server_.sin_family = AF_INET;
+            server_.sin_port = htons(options_.port);
+            server_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            for (int room = 0; room < point.rooms; ++room) {
+                for (int member = 0; member < point.room_size; ++member) {
+                    Client client;
+                    client.fd = socket(AF_INET, SOCK_DGRAM, 0);
+                    if (client.fd < 0) {
+                        std::cerr << "❌ socket(): " << strerror(errno) << std::endl;
+                        return false;
+                    }
+                    fcntl(client.fd, F_SETFL, O_NONBLOCK);
+                    int size = SOCKET_BUFFER_BYTES;
+                    setsockopt(client.fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+                    // Комната 0 — общая, начинаем с 1
+                    client.room = static_cast<uint16_t>(room + 1);
+                    client.sender = member < options_.senders;
+                    clients.push_back(client);
+                }
+            }
+            return true;
+        }
+
+        // Каждый клиент представляется отчетом о приеме: ретранслятор
+        // заводит его и переводит в комнату, не пересылая звук
+        bool join(const Relay& relay, const std::vector<Client>& clients, bool encrypted) {
+            for (size_t i = 0; i < clients.size(); ++i) {
+                protocol::PacketHeader header;
+                header.type = protocol::PACKET_RECEIVER_REPORT;
+                header.room = clients[i].room;
+                header.ssrc = static_cast<uint32_t>(i);
+
+                unsigned char packet[protocol::HEADER_SIZE + protocol::REPORT_SIZE + PacketCrypto::OVERHEAD];
+                protocol::write_header(packet, header);
+                protocol::write_report(packet + protocol::HEADER_SIZE, protocol::ReceiverReport{});
+                size_t size = seal(packet, protocol::HEADER_SIZE + protocol::REPORT_SIZE, encrypted);
+                sendto(clients[i].fd, packet, size, 0,
+                       reinterpret_cast<const sockaddr*>(&server_), sizeof(server_));
+            }
+
+            auto deadline = Clock::now() + JOIN_TIMEOUT;
+            while (relay.client_count() < clients.size()) {
+                if (Clock::now() > deadline) {
+                    std::cerr << "❌ Relay registered " << relay.client_count() << " of "
+                              << clients.size() << " clients" << std::endl;
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return true;
+        }
+
+        void run_traffic(Relay& relay, std::vector<Client>& clients, Point& point) {
+            auto measure_start = Clock::now() + WARMUP;
+            auto measure_end = measure_start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(options_.seconds));
+            uint64_t window_start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                measure_start.time_since_epoch()).count();
+            uint64_t window_end_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                measure_end.time_since_epoch()).count();
+
+            std::atomic<bool> receiving(true);
+            std::vector<uint64_t> histogram(LATENCY_BUCKETS, 0);
+            uint64_t delivered = 0;
+            uint64_t max_ns = 0;
+            std::thread receiver([&] {
+                receive_loop(clients, point.encrypted, receiving, window_start_ns, window_end_ns,
+                             histogram, delivered, max_ns);
+            });
+
+            // Говорящие равномерно по интервалу, чтобы не слать всех разом
+            std::vector<Client*> senders;
+            for (Client& client : clients) {
+                if (client.sender) senders.push_back(&client);
+            }
+            const auto interval = std::chrono::milliseconds(options_.interval_ms);
+            const auto spacing = interval / std::max<size_t>(senders.size(), 1);
+
+            double cpu_start = 0.0;
+            bool cpu_started = false;
+            std::unique_ptr<PipelineLatency::Snapshots> relay_start;
+            uint64_t sent = 0;
+            auto tick = Clock::now();
+            while (tick < measure_end) {
+                for (size_t i = 0; i < senders.size(); ++i) {
+                    std::this_thread::sleep_until(tick + spacing * i);
+
+                    if (!cpu_started && Clock::now() >= measure_start) {
+                        cpu_start = relay.network_cpu_seconds();
+                        relay_start = relay.latency().snapshot();
+                        cpu_started = true;
+                    }
+
+                    uint64_t sent_ns = send_audio(*senders[i], static_cast<uint32_t>(senders[i] - clients.data()),
+                                                  point.encrypted);
+                    if (sent_ns >= window_start_ns && sent_ns < window_end_ns) sent++;
+                }
+                tick += interval;
+            }
+            double cpu_end = relay.network_cpu_seconds();
+
+            std::this_thread::sleep_for(DRAIN);
+            receiving = false;
+            receiver.join();
+
+            if (relay_start) {
+                auto relay_end = relay.latency().snapshot();
+                const auto forward = (*relay_end)[PipelineLatency::RELAY_FORWARD].since(
+                    (*relay_start)[PipelineLatency::RELAY_FORWARD]);
+                point.relay_forwarded = forward.count;
+                point.relay_p50_us = forward.percentile(0.50) / 1000.0;
+                point.relay_p99_us = forward.percentile(0.99) / 1000.0;
+                point.relay_p999_us = forward.percentile(0.999) / 1000.0;
+            }
+
+            double cpu_seconds = cpu_end - cpu_start;
+            point.sent = sent;
+            point.expected = sent * static_cast<uint64_t>(point.room_size - 1);
+            point.delivered = delivered;
+            point.forwarded_per_second = delivered / options_.seconds;
+            point.relay_cpu_percent = 100.0 * cpu_seconds / options_.seconds;
+            point.cpu_ns_per_packet = delivered > 0 ? cpu_seconds * 1e9 / delivered : 0.0;
+            point.loss_percent = point.expected > 0
+                ? 100.0 * (1.0 - static_cast<double>(std::min(delivered, point.expected)) / point.expected)
+                : 0.0;
+            point.p50_us = percentile_us(histogram, delivered, 0.50);
+            point.p99_us = percentile_us(histogram, delivered, 0.99);
+            point.p999_us = percentile_us(histogram, delivered, 0.999);
+            point.max_us = max_ns / 1000.0;
+            point.saturated = point.loss_percent > SATURATION_LOSS_PERCENT;
+        }
+
+        // Время отправки (или 0, если не ушло)
+        uint64_t send_audio(Client& client, uint32_t ssrc, bool encrypted) {
+            unsigned char packet[RECV_BUFFER];
+            size_t payload = std::max<size_t>(options_.payload_bytes, 1 + sizeof(uint64_t));
+
+            protocol::PacketHeader header;
+            header.room = client.room;
+            header.ssrc = ssrc;
+            header.sequence = client.sequence;
+            header.timestamp = client.sequence * 960;
+            client.sequence++;
+
+            protocol::write_header(packet, header);
+            unsigned char* body = packet + protocol::HEADER_SIZE;
+            memset(body, 0, payload);
+            body[0] = PAYLOAD_TOC;
+
+            uint64_t sent_ns = now_ns();
+            memcpy(body + 1, &sent_ns, sizeof(sent_ns));
+            size_t size = seal(packet, protocol::HEADER_SIZE + payload, encrypted);
+            ssize_t result = sendto(client.fd, packet, size, 0,
+                                    reinterpret_cast<const sockaddr*>(&server_), sizeof(server_));
+            return result > 0 ? sent_ns : 0;
+        }
+
+        void receive_loop(const std::vector<Client>& clients, bool encrypted, const std::atomic<bool>& receiving,
+                          uint64_t window_start_ns, uint64_t window_end_ns,
+                          std::vector<uint64_t>& histogram, uint64_t& delivered, uint64_t& max_ns) {
+            int epoll_fd = epoll_create1(0);
+            for (const Client& client : clients) {
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.fd = client.fd;
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client.fd, &event);
+            }
+
+            static unsigned char buffers[RECV_BATCH][RECV_BUFFER];
+            static unsigned char opened[RECV_BUFFER];
+            iovec iov[RECV_BATCH];
+            mmsghdr messages[RECV_BATCH];
+            for (int i = 0; i < RECV_BATCH; ++i) {
+                iov[i].iov_base = buffers[i];
+                iov[i].iov_len = RECV_BUFFER;
+                memset(&messages[i].msg_hdr, 0, sizeof(messages[i].msg_hdr));
+                messages[i].msg_hdr.msg_iov = &iov[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            std::vector<epoll_event> events(256);
+            while (receiving) {
+                int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 10);
+                for (int e = 0; e < ready; ++e) {
+                    while (true) {
+                        int count = recvmmsg(events[e].data.fd, messages, RECV_BATCH, MSG_DONTWAIT, nullptr);
+                        if (count <= 0) break;
+
+                        uint64_t arrival = now_ns();
+                        for (int i = 0; i < count; ++i) {
+                            // Время отправки зашифровано: слушатель расшифровывает, как клиент
+                            const unsigned char* packet = buffers[i];
+                            size_t size = messages[i].msg_len;
+                            if (encrypted) {
+                                size = receiver_crypto_.open(packet, size, opened);
+                                packet = opened;
+                            }
+                            if (size < protocol::HEADER_SIZE + 1 + sizeof(uint64_t)) continue;
+
+                            uint64_t sent_ns;
+                            memcpy(&sent_ns, packet + protocol::HEADER_SIZE + 1, sizeof(sent_ns));
+                            if (sent_ns < window_start_ns || sent_ns >= window_end_ns) continue;
+
+                            uint64_t latency = arrival > sent_ns ? arrival - sent_ns : 0;
+                            size_t bucket = std::min<uint64_t>(latency / 1000 / LATENCY_BUCKET_US,
+                                                               LATENCY_BUCKETS - 1);
+                            histogram[bucket]++;
+                            delivered++;
+                            max_ns = std::max(max_ns, latency);
+                        }
+                        if (count < RECV_BATCH) break;
+                    }
+                }
+            }
+            close(epoll_fd);
+        }
+
+        // Верхняя граница ячейки квантиля
+        static double percentile_us(const std::vector<uint64_t>& histogram, uint64_t samples, double q) {
+            if (samples == 0) return 0.0;
+
+            uint64_t rank = static_cast<uint64_t>(std::ceil(q * samples));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < histogram.size(); ++i) {
+                seen += histogram[i];
+                if (seen >= rank) return static_cast<double>((i + 1) * LATENCY_BUCKET_US);
+            }
+            return static_cast<double>(histogram.size() * LATENCY_BUCKET_US);
+        }
+
+        static bool raise_fd_limit(int clients) {
+            rlimit limit{};
+            getrlimit(RLIMIT_NOFILE, &limit);
+
+            rlim_t needed = static_cast<rlim_t>(clients) + 64;
+            if (limit.rlim_cur < needed) {
+                limit.rlim_cur = std::min(needed, limit.rlim_max);
+                setrlimit(RLIMIT_NOFILE, &limit);
+                getrlimit(RLIMIT_NOFILE, &limit);
+            }
+
+            if (limit.rlim_cur < needed) {
+                std::cerr << "❌ Need " << needed << " file descriptors, limit is "
+                          << limit.rlim_cur << " (raise ulimit -n)" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        void print_header(std::ostream& out) const {
+            out << "Relay loopback benchmark: " << options_.senders << " sender(s) per room, packet every "
+                << options_.interval_ms << " ms, " << options_.payload_bytes << " byte payload, "
+                << options_.seconds << " s per point" << std::endl;
+            out << "Latency is sender -> relay -> listener on loopback (two kernel hops, one receiver thread);" << std::endl;
+            out << "relay fwd is the relay's own RELAY_FORWARD histogram (read -> sent to all listeners)" << std::endl;
+            if (options_.crypto.back()) {
+                out << "aead: AES-256-GCM, senders seal, relay opens, listeners open" << std::endl;
+            }
+            out << std::endl;
+            out << std::setw(6) << "crypto" << std::setw(5) << "room" << std::setw(8) << "clients" << std::setw(12) << "fwd pkt/s"
+                << std::setw(9) << "relay%" << std::setw(10) << "ns/pkt" << std::setw(8) << "loss%"
+                << std::setw(9) << "p50 us" << std::setw(9) << "p99 us" << std::setw(10) << "p999 us"
+                << std::setw(10) << "max us" << std::setw(10) << "fwd p50" << std::setw(10) << "fwd p99"
+                << std::setw(11) << "fwd p999" << std::endl;
+        }
+
+        static void print_point(std::ostream& out, const Point& point) {
+            out << std::fixed << std::setw(6) << (point.encrypted ? "aead" : "plain")
+                << std::setw(5) << point.room_size << std::setw(8) << point.clients
+                << std::setprecision(0) << std::setw(12) << point.forwarded_per_second
+                << std::setprecision(1) << std::setw(9) << point.relay_cpu_percent
+                << std::setprecision(0) << std::setw(10) << point.cpu_ns_per_packet
+                << std::setprecision(2) << std::setw(8) << point.loss_percent
+                << std::setprecision(0) << std::setw(9) << point.p50_us << std::setw(9) << point.p99_us
+                << std::setw(10) << point.p999_us << std::setw(10) << point.max_us
+                << std::setprecision(1) << std::setw(10) << point.relay_p50_us
+                << std::setw(10) << point.relay_p99_us << std::setw(11) << point.relay_p999_us
+                << (point.saturated ? "  ⚠️  saturated" : "")
+                << std::defaultfloat << std::endl;
+        }
+
+        void print_json(std::ostream& out, const std::vector<Point>& points) const {
+            out << "{\"senders_per_room\": " << options_.senders
+                << ", \"interval_ms\": " << options_.interval_ms
+                << ", \"payload_bytes\": " << options_.payload_bytes
+                << ", \"seconds\": " << options_.seconds
+                << ", \"points\": [";
+            for (size_t i = 0; i < points.size(); ++i) {
+                const Point& p = points[i];
+                out << (i > 0 ? "," : "") << "\n  {\"crypto\": \"" << (p.encrypted ? "aead" : "plain") << "\""
+                    << ", \"room_size\": " << p.room_size
+                    << ", \"clients\": " << p.clients
+                    << ", \"sent\": " << p.sent
+                    << ", \"expected\": " << p.expected
+                    << ", \"delivered\": " << p.delivered
+                    << std::fixed << std::setprecision(1)
+                    << ", \"forwarded_per_second\": " << p.forwarded_per_second
+                    << ", \"relay_cpu_percent\": " << p.relay_cpu_percent
+                    << ", \"cpu_ns_per_packet\": " << p.cpu_ns_per_packet
+                    << std::setprecision(3)
+                    << ", \"loss_percent\": " << p.loss_percent
+                    << std::setprecision(0)
+                    << ", \"p50_us\": " << p.p50_us
+                    << ", \"p99_us\": " << p.p99_us
+                    << ", \"p999_us\": " << p.p999_us
+                    << ", \"max_us\": " << p.max_us
+                    << ", \"relay_forwarded\": " << p.relay_forwarded
+                    << std::setprecision(1)
+                    << ", \"relay_forward_p50_us\": " << p.relay_p50_us
+                    << ", \"relay_forward_p99_us\": " << p.relay_p99_us
+                    << ", \"relay_forward_p999_us\": " << p.relay_p999_us
+                    << std::defaultfloat
+                    << ", \"saturated\": " << (p.saturated ? "true" : "false") << "}";
+            }
+            out << "\n]}" << std::endl;
+        }
+
+    private:
+        Options options_;
+        sockaddr_in server_{};
+
+        // Шифрование: у говорящих (поток замера) и у слушателей — свое
+        PacketCrypto sender_crypto_;
+        PacketCrypto receiver_crypto_;
+        uint32_t salt_ = 0;
+    };
+
+    bool parse_list(const std::string& text, std::vector<int>& values) {
+        values.clear();
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            int value = std::atoi(item.c_str());
+            if (value <= 0) return false;
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    void print_usage() {
+        std::cout << "\n📈 RELAY LOOPBACK BENCHMARK\n" << std::endl;
+        std::cout << "Usage: ./voice_relay_bench [options]" << std::endl;
+        std::cout << "\nOptions:" << std::endl;
+        std::cout << "  --room-sizes=LIST  Room sizes to sweep (default 2,5,10,25,50)" << std::endl;
+        std::cout << "  --clients=LIST     Client counts to sweep (default 100,250,500,1000)" << std::endl;
+        std::cout << "  --senders=M        Speakers per room, the rest listen (default 1)" << std::endl;
+        std::cout << "  --interval-ms=MS   Packet interval per speaker (default 20)" << std::endl;
+        std::cout << "  --payload=BYTES    Audio payload size (default 60)" << std::endl;
+        std::cout << "  --seconds=S        Measurement window per point (default 3)" << std::endl;
+        std::cout << "  --port=N           Loopback port for the relay (default 23500)" << std::endl;
+        std::cout << "  --crypto=MODE      plain, aead (AES-GCM) or both side by side (default plain)" << std::endl;
+        std::cout << "  --json             Machine-readable output" << std::endl;
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        bool valid = true;
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        } else if (arg.rfind("--room-sizes=", 0) == 0) {
+            valid = parse_list(arg.substr(13), options.room_sizes);
+        } else if (arg.rfind("--clients=", 0) == 0) {
+            valid = parse_list(arg.substr(10), options.client_counts);
+        } else if (arg.rfind("--senders=", 0) == 0) {
+            options.senders = std::atoi(arg.c_str() + 10);
+            valid = options.senders > 0;
+        } else if (arg.rfind("--interval-ms=", 0) == 0) {
+            options.interval_ms = std::atoi(arg.c_str() + 14);
+            valid = options.interval_ms > 0;
+        } else if (arg.rfind("--payload=", 0) == 0) {
+            options.payload_bytes = std::atoi(arg.c_str() + 10);
+            valid = options.payload_bytes > 0 && options.payload_bytes <= MAX_DATAGRAM;
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            options.seconds = std::atof(arg.c_str() + 10);
+            valid = options.seconds > 0.0;
+        } else if (arg.rfind("--port=", 0) == 0) {
+            options.port = std::atoi(arg.c_str() + 7);
+        } else if (arg.rfind("--crypto=", 0) == 0) {
+            std::string mode = arg.substr(9);
+            if (mode == "plain") {
+                options.crypto = {false};
+            } else if (mode == "aead") {
+                options.crypto = {true};
+            } else if (mode == "both") {
+                options.crypto = {false, true};
+            } else {
+                valid = false;
+            }
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            std::cerr << "❌ Error: Invalid option '" << arg << "'" << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    // Ретранслятор сообщает о каждом новом клиенте — в замере это шум.
+    // Результаты пишем в исходный stdout, сообщения модулей отбрасываем
+    std::ostream out(std::cout.rdbuf());
+    std::cout.rdbuf(nullptr);
+
+    RelayBench bench(options);
+    int status = bench.run(out);
+
+    std::cout.rdbuf(out.rdbuf());
+    return status;
+}